@@ -6,10 +6,15 @@
 
 """
 Script to generate Zigbee factory NVS partition image.
+
+With --batch, streams a device CSV and generates every image in parallel
+worker processes, into one directory or archive plus a manifest.
 """
 
 import os
 import sys
+import io
+import time
 import logging
 import binascii
 import argparse
@@ -17,23 +22,20 @@ import re
 from ctypes import *
 import struct
 import csv
-from itertools import zip_longest
+import tarfile
+import multiprocessing
+from itertools import islice, zip_longest
 
 
+# only the single device mode needs the IDF mass manufacturing tools
+idf_import_error = None
 try:
     idf_path = os.environ['IDF_PATH']
     sys.path.insert(0, idf_path + '/tools/mass_mfg/')
     import mfg_gen
-except Exception as e:
-    print(e)
-    sys.exit('Please check IDF_PATH')
-
-
-try:
     import esp_idf_nvs_partition_gen.nvs_partition_gen as nvs_partition_gen
 except Exception as e:
-    print(e)
-    sys.exit('Please check IDF_PATH')
+    idf_import_error = e
 
 
 is_output_header_file_style = False
@@ -59,9 +61,13 @@ ZB_PRODUCTION_CONFIG_VERSION_1_0 = 0x01
 ZB_PRODUCTION_CONFIG_VERSION_2_0 = 0x02
 ZB_PRODUCTION_CONFIG_CURRENT_VERSION = ZB_PRODUCTION_CONFIG_VERSION_2_0
 APP_PROD_CFG_CURRENT_VERSION = 0x0001
+PRODUCTION_CONFIG_HEADER = bytes([0xE7, 0x37, 0xDD, 0xF6])
+# devices per task handed to a batch worker
+ZB_BATCH_CHUNK_ROWS = 256
 
 
-class zb_production_config_ver_2_t(Structure):
+# little endian whatever the host, bytes() of it is the image layout
+class zb_production_config_ver_2_t(LittleEndianStructure):
     APS_channel_page_size= ZB_PROD_CFG_APS_CHANNEL_LIST_SIZE * ZB_PROD_CFG_MAC_TX_POWER_CHANNEL_N
     install_code_size = ZB_CCM_KEY_SIZE + ZB_CCM_KEY_CRC_SIZ
     _fields_ = [("crc", c_uint), 
@@ -75,6 +81,10 @@ class zb_production_config_ver_2_t(Structure):
                 ]
 
 
+# end of zb_production_config_ver_2_t without the tail padding: len = 190
+ZB_PRODUCTION_CONFIG_VER_2_SIZE = zb_production_config_ver_2_t.install_code.offset + zb_production_config_ver_2_t.install_code.size
+
+
 class zb_manufacturer_config_t(Structure):
     _fields_ = [("version", c_ushort),
                 ("manuf_code", c_ushort),
@@ -108,36 +118,46 @@ def restrict_value(value, lower, upper):
 
 
 '''
- * Calculate CRC-16 checksum using classic algorithm based on polynomial arithmetic.
- * Use the standard CRC-16/X-25 config.
+ * Byte-at-a-time table of a reflected CRC: the remainder of every byte value,
+ * so a byte costs one lookup instead of eight shifts.
 '''
-def zb_crc_16(data, crc, length):
-    data = binascii.unhexlify(data)
-    for i in range(length):
-        crc ^= data[i]
+def zb_crc_table(polynomial):
+    table = []
+    for i in range(256):
+        crc = i
         for j in range(8):
             if crc & 0x0001 == 1:
-                crc = (crc >> 1) ^ 0x8408
+                crc = (crc >> 1) ^ polynomial
             else:
                 crc >>= 1
+        table.append(crc)
+    return table
+
+
+ZB_CRC_16_TABLE = zb_crc_table(0x8408)
+ZB_CRC_32_TABLE = zb_crc_table(0xEDB88320)
+
+
+'''
+ * Calculate CRC-16 checksum, table driven.
+ * Use the standard CRC-16/X-25 config.
+'''
+def zb_crc_16(data, crc, length):
+    data = binascii.unhexlify(data)
+    for i in range(length):
+        crc = (crc >> 8) ^ ZB_CRC_16_TABLE[(crc ^ data[i]) & 0xff]
     return crc
 
 
 '''
- * Calculate CRC-32 checksum using classic algorithm based on polynomial arithmetic.
+ * Calculate CRC-32 checksum, table driven.
  * Use the polynomial x^32+x^26+x^23+x^22+x^16+x^12+x^11+x^10+x^8+x^7+x^5+x^4+x^2+x+1 (CRC-32).
  '''
 def zb_crc32(p_buffer, length):
     # Initialize CRC with fixed value 
     crc = 0xFFFFFFFF
     for i in range(length):
-        crc = crc ^ p_buffer[i]
-        for j in range(8):
-            if (crc & (1<<0)) != 0:
-                mask = ~(0) & 0xFFFFFFFF
-            else:
-                mask = 0
-            crc = (crc >> 1) ^ (0xEDB88320 & mask)
+        crc = (crc >> 8) ^ ZB_CRC_32_TABLE[(crc ^ p_buffer[i]) & 0xff]
     return ~crc & 0xffffffff
 
 
@@ -145,59 +165,6 @@ def zb_calculate_production_config_crc(prod_cfg_ptr, prod_cfg_size):
     return zb_crc32(prod_cfg_ptr, prod_cfg_size)
 
 
-def zb_pro_cfg_convert_to_byte_list(data, data_type, data_len):
-    data_arry = []
-    data_list = []
-    if data_len == 1:
-        data_list.append(data)
-    else:
-        data_list = data
-    for i in range(len(data_list)):
-        data_bytes = b''
-        if data_type == 'c_ushort':
-            data_bytes = struct.pack("<H", data_list[i]) #  < little type storge
-        elif data_type == 'c_uint':
-            data_bytes = struct.pack("<I", data_list[i]) #  < little type storge
-        elif data_type == 'c_uchar' or data_type == 'c_char' or data_type == 'c_ubyte' or data_type == 'c_byte':
-            data_bytes = struct.pack("<B", data_list[i]) #  < little type storge
-        elif data_type == 'c_wchar_p':
-            for k in range(len(data_list[i])):
-                data =  struct.pack("<B", ord(data_list[i][k])) #  < little type storge
-                data_bytes = data_bytes + data
-        for j in range(len(data_bytes)):
-            data_arry.append(int(data_bytes[j]))
-    return data_arry
-
- 
-def table_list_convert_to_byte_list(data_list):
-    g_pro_cfg_data = []
-    for i in range(len(data_list)):
-        g_pro_cfg_data += zb_pro_cfg_convert_to_byte_list(data_list[i][0], data_list[i][1], data_list[i][2])
-    return g_pro_cfg_data
-
-
-def zb_pro_cfg_byte_list_add(zb_pro_cfg_struct):
-    data_list = [[zb_pro_cfg_struct.len, 'c_ushort', 1],
-                [zb_pro_cfg_struct.version, 'c_ushort', 1],
-                [zb_pro_cfg_struct.aps_channel_mask_list, 'c_uint', ZB_PROD_CFG_APS_CHANNEL_LIST_SIZE],
-                [zb_pro_cfg_struct.mac_address, 'c_ubyte', 8],
-                [zb_pro_cfg_struct.mac_tx_power, 'c_ubyte', ZB_PROD_CFG_APS_CHANNEL_LIST_SIZE * ZB_PROD_CFG_MAC_TX_POWER_CHANNEL_N],
-                [zb_pro_cfg_struct.options, 'c_ubyte', 1],
-                [zb_pro_cfg_struct.install_code, 'c_ubyte', ZB_CCM_KEY_SIZE + ZB_CCM_KEY_CRC_SIZ],
-                ]
-    data_arry = table_list_convert_to_byte_list(data_list)
-    return data_arry
-
-
-def zb_application_byte_list_add(app_data_struct):
-    data_list = [[app_data_struct.version, 'c_ushort', 1],
-    [app_data_struct.manuf_code, 'c_ushort', 1],
-    [app_data_struct.manuf_name, 'c_wchar_p', 1],
-    ]
-    data_arry = table_list_convert_to_byte_list(data_list)
-    return data_arry
-
-
 def set_common_section_parameter(zb_pro_cfg_section_data, key, value):
     if  key.find('channel_mask_page') != -1:
         # channel page
@@ -310,49 +277,39 @@ def set_common_section_parameter(zb_pro_cfg_section_data, key, value):
         return RET_NOT_FOUND
 
 
-def generate_binary(args, key_value_list):
-    g_product_config_len = 0
-    bin_ext = '.bin'
-    filename, ext = os.path.splitext(args.output)
-    if bin_ext not in ext:
-        sys.exit('Error: `%s`. Only `.bin` extension allowed.' % args.output)
-    args.outdir, args.output = nvs_partition_gen.set_target_filepath(args.outdir, args.output)
-    # init parameter
+def zb_production_config_image(key_value_list):
+    """zb_fct image of one device: magic header, CRC-32, production config, manufacturer config"""
     zb_pro_cfg_data = zb_production_config_ver_2_t()
     zb_manaufacturer_data = zb_manufacturer_config_t()
     # Version is not utilized at the moment
     zb_pro_cfg_data.version = ZB_PRODUCTION_CONFIG_CURRENT_VERSION
-    g_product_config_len += 8 + 20 + 8 + 135 + 1 + 18 # zb_production_config_ver_2_t:  len = 190
+    for key, value in key_value_list:
+        if set_common_section_parameter(zb_pro_cfg_data, key, value) == RET_ERROR or \
+                set_manufacturer_param(zb_manaufacturer_data, key, value) == RET_ERROR:
+            raise ValueError('invalid %s: %s' % (key, value))
 
-    for index in range(0, len(key_value_list)):
-        try:
-            # Check key length
-            ret = 0
-            key = key_value_list[index][0]
-            value = key_value_list[index][1]
-            ret = set_common_section_parameter(zb_pro_cfg_data, key, value)
-            ret = set_manufacturer_param(zb_manaufacturer_data, key, value)
-
-        except RuntimeError as e:
-            print(e)
-            sys.exit(-2)
-
-    g_product_config_len += 2 + 2 + len(zb_manaufacturer_data.manuf_name)
+    manuf_name = zb_manaufacturer_data.manuf_name.encode('latin-1')
     # file data length
-    zb_pro_cfg_data.len = g_product_config_len
-    g_pro_cfg_buffer = []
-    # product config buffer: table storge
-    g_pro_cfg_buffer = zb_pro_cfg_byte_list_add(zb_pro_cfg_data)
-    g_pro_cfg_buffer += zb_application_byte_list_add(zb_manaufacturer_data)
+    zb_pro_cfg_data.len = ZB_PRODUCTION_CONFIG_VER_2_SIZE + 2 + 2 + len(manuf_name)
+    # product config buffer: the structure as laid out, after the crc
+    g_pro_cfg_buffer = bytes(zb_pro_cfg_data)[4:ZB_PRODUCTION_CONFIG_VER_2_SIZE]
+    g_pro_cfg_buffer += struct.pack('<HH', zb_manaufacturer_data.version, zb_manaufacturer_data.manuf_code) + manuf_name
     # fill prod_cfg_header (crc)
-    zb_pro_cfg_data.crc = zb_calculate_production_config_crc(g_pro_cfg_buffer,len(g_pro_cfg_buffer))
-    # table change to write binary
-    data_crc_list = [[zb_pro_cfg_data.crc, 'c_uint', 1]]
-    data_crc_arry = table_list_convert_to_byte_list(data_crc_list)
-    g_pro_cfg_buffer = data_crc_arry + g_pro_cfg_buffer  # g_pro_cfg_buffer = hdr(crc len version) + pro_cfg + csk + application
-    # fill prod_cfg magic header
-    PRODUCTION_CONFIG_HEADER = [0xE7, 0x37, 0xDD, 0xF6]
-    g_pro_cfg_buffer = PRODUCTION_CONFIG_HEADER + g_pro_cfg_buffer  # buffer list
+    zb_pro_cfg_data.crc = zb_calculate_production_config_crc(g_pro_cfg_buffer, len(g_pro_cfg_buffer))
+    return PRODUCTION_CONFIG_HEADER + struct.pack('<I', zb_pro_cfg_data.crc) + g_pro_cfg_buffer, zb_pro_cfg_data.crc
+
+
+def generate_binary(args, key_value_list):
+    bin_ext = '.bin'
+    filename, ext = os.path.splitext(args.output)
+    if bin_ext not in ext:
+        sys.exit('Error: `%s`. Only `.bin` extension allowed.' % args.output)
+    args.outdir, args.output = nvs_partition_gen.set_target_filepath(args.outdir, args.output)
+    try:
+        g_pro_cfg_buffer, _ = zb_production_config_image(key_value_list)
+    except ValueError as e:
+        print(e)
+        sys.exit(-2)
 
     # generate arry config file 
     if is_output_header_file_style:
@@ -373,8 +330,7 @@ def generate_binary(args, key_value_list):
 
     # generate binary
     output_file = open(args.output, 'wb')
-    g_pro_cfg_buffer_bytes = b''.join(map(lambda x:int.to_bytes(x,1,'little'),g_pro_cfg_buffer)) # little write bytes
-    output_file.write(g_pro_cfg_buffer_bytes)
+    output_file.write(g_pro_cfg_buffer)
     output_file.close()
     print('\nCreated NVS binary: ===>', args.output)
 
@@ -436,7 +392,120 @@ def generate_binary_from_csv(args):
         csv_values_file.close()
 
 
+def zb_fileid(key_value_data, previous):
+    """Output file name of a device, as mfg_gen picks it: the mac_address, else the id column, else one more than the last"""
+    values = dict(key_value_data)
+    for key in ('mac_address', 'id'):
+        if values.get(key) not in (None, '', 'NULL'):
+            return values[key]
+    return str(int(previous) + 1)
+
+
+def zb_batch_chunks(csv_file):
+    """Stream the device CSV in chunks of (file id, key-value pairs without the id column)"""
+    reader = csv.reader(csv_file)
+    keys = [key.strip() for key in next(reader)]
+    fileid = '0'
+    chunk = []
+    for values in reader:
+        if not values or values == ['']:
+            continue
+        key_value_data = list(zip_longest(keys, [value.strip() for value in values]))
+        fileid = zb_fileid(key_value_data, fileid)
+        chunk.append((fileid, key_value_data[1:]))
+        if len(chunk) == ZB_BATCH_CHUNK_ROWS:
+            yield chunk
+            chunk = []
+    if chunk:
+        yield chunk
+
+
+def zb_batch_check_unique(csv_path):
+    """Exit before anything is written if two devices of the CSV would get the same file"""
+    seen = set()
+    with open(csv_path, 'r', newline='') as csv_values_file:
+        for chunk in zb_batch_chunks(csv_values_file):
+            for fileid, _ in chunk:
+                if fileid in seen:
+                    raise SystemExit('Device %s appears twice in %s' % (fileid, csv_path))
+                seen.add(fileid)
+
+
+def zb_batch_worker(chunk):
+    """Images of a chunk of devices, in a worker process: (file id, image, crc) or (file id, None, error)"""
+    results = []
+    for fileid, key_value_pair in chunk:
+        try:
+            image, crc = zb_production_config_image(key_value_pair)
+            results.append((fileid, image, crc))
+        except Exception as e:
+            results.append((fileid, None, str(e)))
+    return results
+
+
+def zb_batch_write(outdir, archive, name, data):
+    if archive is None:
+        path = os.path.join(outdir, name)
+        if os.path.isfile(path):
+            raise SystemExit('Target binary file: %s already exists.`' % path)
+        with open(path, 'wb') as output_file:
+            output_file.write(data)
+        return
+    info = tarfile.TarInfo(name)
+    info.size = len(data)
+    info.mtime = int(time.time())
+    archive.addfile(info, io.BytesIO(data))
+
+
+def generate_batch(args):
+    """All devices of the CSV into <outdir>/bin/<id>.bin and <outdir>/manifest.csv, or into one tar archive"""
+    bin_str = 'bin'
+    zb_batch_check_unique(args.csv)
+    os.makedirs(args.outdir, exist_ok=True)
+    archive = tarfile.open(os.path.join(args.outdir, args.archive), 'w') if args.archive else None
+    if archive is None:
+        os.makedirs(os.path.join(args.outdir, bin_str), exist_ok=True)
+    manifest = io.StringIO()
+    manifest_csv = csv.writer(manifest, lineterminator='\n')
+    manifest_csv.writerow(['id', 'file', 'size', 'crc32'])
+    seen = set()
+    errors = 0
+    start = time.monotonic()
+
+    with open(args.csv, 'r', newline='') as csv_values_file:
+        chunks = zb_batch_chunks(csv_values_file)
+        pool = multiprocessing.Pool(args.jobs) if args.jobs > 1 else None
+        try:
+            results = pool.imap(zb_batch_worker, chunks) if pool else map(zb_batch_worker, chunks)
+            for chunk in results:
+                for fileid, image, crc in chunk:
+                    if image is None:
+                        print('Device %s: %s' % (fileid, crc))
+                        errors += 1
+                        continue
+                    seen.add(fileid)
+                    name = '%s/%s.%s' % (bin_str, fileid, bin_str)
+                    zb_batch_write(args.outdir, archive, name, image)
+                    manifest_csv.writerow([fileid, name, len(image), '0x%08x' % crc])
+        finally:
+            if pool:
+                pool.terminate()
+
+    zb_batch_write(args.outdir, archive, 'manifest.csv', manifest.getvalue().encode())
+    if archive is not None:
+        archive.close()
+    elapsed = time.monotonic() - start
+    print('Generated %d images in %.2f s, %.0f devices/s with %d worker(s), %d error(s)' %
+          (len(seen), elapsed, len(seen) / elapsed if elapsed else 0, args.jobs, errors))
+    print('Files generated in %s ...' % os.path.join(args.outdir, args.archive or ''))
+    if errors:
+        sys.exit(1)
+
+
 def generate(args):
+    if idf_import_error is not None:
+        print(idf_import_error)
+        sys.exit('Please check IDF_PATH')
     args.outdir = os.path.join(args.outdir, '')
     # if csv is not present creat a sigle device for generate binary
     file_name = os.getcwd() + '/sigle_device.csv'
@@ -461,9 +530,16 @@ def validate_args(args):
     if (args.csv and args.installcode != 'NULL' and args.mac_address != 'NULL'):
         logging.error("csv and installcode/mac_address/channel_mask/manufacturer_name/ manufacturer_code should not be both present or none")
         sys.exit(1)
+    if args.batch and args.csv is None:
+        logging.error('--batch needs --csv')
+        sys.exit(1)
+    if args.jobs < 1:
+        logging.error('Invalid number of jobs: %d' % args.jobs)
+        sys.exit(1)
     # csv, first line is heder
     if args.csv is not None:
-        count = len(open(args.csv, 'r').readlines())
+        with open(args.csv, 'r') as csv_file:
+            count = len(list(islice(csv_file, 2)))
         if count < 2:
             logging.error('Invalid csv:' + (args.csv))
             sys.exit(1)
@@ -506,13 +582,19 @@ def get_args():
     parser.add_argument('-mn', '--manufacturer_name', default='Espressif', type=str, help='The manufacturer name.')
     parser.add_argument('-mc', '--manufacturer_code', default=0x131B, type=any_base_int, help='The manufacturer code.')
     parser.add_argument('--outdir', default=os.getcwd(), help='Output directory to store files created (Default: current directory)')
+    parser.add_argument('--batch', action='store_true', help='Generate every device of --csv in parallel, with a manifest; does not need IDF_PATH.')
+    parser.add_argument('-j', '--jobs', default=os.cpu_count() or 1, type=int, help='Worker processes for --batch (Default: one per CPU).')
+    parser.add_argument('--archive', type=str, help='With --batch, pack the images and the manifest into this tar file in --outdir instead.')
     return parser.parse_args()
 
 
 def main():
     args = get_args()
     validate_args(args)
-    generate(args)
+    if args.batch:
+        generate_batch(args)
+    else:
+        generate(args)
 
 
 if __name__ == '__main__':
@@ -0,0 +1,20 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Runs the light_bench kernels on the host, one JSON line per kernel on
+ * stdout. Numbers are nanoseconds per call; on target the same kernels
+ * report CPU cycles (CONFIG_LIGHT_BENCH_ON_BOOT).
+ */
+
+#include "light_bench.h"
+#include "light_driver.h"
+
+int main(void)
+{
+    light_driver_set_power(0, LIGHT_DEFAULT_ON);
+    light_driver_init();
+    light_bench_run_all(true);
+    return 0;
+}
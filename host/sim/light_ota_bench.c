@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Downloads a generated upgrade file into the OTA client of the light
+ * firmware running on the host, through the stand-in server of
+ * sim_zigbee_ota_serve(), and prints one JSON line per run:
+ *
+ *  - bytes_per_s: download throughput in virtual time, as the client
+ *    reports it; bounded by the block size over the block period
+ *  - ns_per_block: host time the client takes per block, parsing, hashing
+ *    and writing the slot included
+ *  - ram_bytes: RAM the client holds, see light_ota_get_stats()
+ *  - checkpoints: progress saved to NVS, resumed_from: where the last
+ *    download of the run started
+ *  - errors: a run that did not end the way it should, e.g. a slot that
+ *    differs from the app or a corrupt image that was booted
+ *
+ * The file is built the way main/tools/make_ota_image.py builds it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_ota_ops.h"
+#include "esp_zb_light.h"
+#include "light_ota.h"
+#include "mbedtls/sha256.h"
+#include "sim.h"
+
+void app_main(void);
+
+#define BENCH_APP_SIZE      (256 * 1024)
+#define BENCH_FILE_VERSION  (CONFIG_LIGHT_OTA_FILE_VERSION + 1)
+
+typedef struct {
+    const char *name;
+    uint8_t block_max;          /* server side cap, 0 for the client's block size */
+    uint16_t period_ms;         /* MinimumBlockPeriod, written to the client before the run */
+    uint32_t block_us;          /* air time per block */
+    uint32_t cut_at;            /* interrupt the first download there, 0 never */
+    bool corrupt;               /* flip an image byte after the hash was taken */
+} bench_run_t;
+
+static const bench_run_t s_runs[] = {
+    { "full", 0, CONFIG_LIGHT_OTA_BLOCK_PERIOD_MS, 40000, 0, false },
+    { "unpaced", 0, 0, 40000, 0, false },
+    { "small_blocks", 32, CONFIG_LIGHT_OTA_BLOCK_PERIOD_MS, 40000, 0, false },
+    { "resume", 0, 0, 40000, BENCH_APP_SIZE * 3 / 5, false },
+    { "corrupt", 0, 0, 40000, 0, true },
+};
+
+static uint64_t bench_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+static uint32_t bench_random(uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static void bench_put(uint8_t **p, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        *(*p)++ = (uint8_t)(value >> (8 * i));
+    }
+}
+
+/* upgrade file header, the app as the upgrade image and its SHA-256 */
+static uint8_t *bench_make_file(const uint8_t *app, uint32_t app_size, uint32_t *size)
+{
+    *size = LIGHT_OTA_FILE_HEADER_SIZE + 2 * LIGHT_OTA_TAG_HEADER_SIZE + app_size + LIGHT_OTA_SHA256_SIZE;
+    uint8_t *file = calloc(1, *size);
+    if (!file) {
+        perror("calloc");
+        exit(1);
+    }
+    uint8_t *p = file;
+    bench_put(&p, 0x0BEEF11E, 4);
+    bench_put(&p, 0x0100, 2);
+    bench_put(&p, LIGHT_OTA_FILE_HEADER_SIZE, 2);
+    bench_put(&p, 0, 2);
+    bench_put(&p, CONFIG_LIGHT_OTA_MANUFACTURER_CODE, 2);
+    bench_put(&p, CONFIG_LIGHT_OTA_IMAGE_TYPE, 2);
+    bench_put(&p, BENCH_FILE_VERSION, 4);
+    bench_put(&p, 0x0002, 2);
+    memcpy(p, "light_ota_bench", 15);
+    p += 32;
+    bench_put(&p, *size, 4);
+    bench_put(&p, LIGHT_OTA_TAG_UPGRADE_IMAGE, 2);
+    bench_put(&p, app_size, 4);
+    memcpy(p, app, app_size);
+    p += app_size;
+    bench_put(&p, LIGHT_OTA_TAG_SHA256, 2);
+    bench_put(&p, LIGHT_OTA_SHA256_SIZE, 4);
+    mbedtls_sha256(app, app_size, p, 0);
+    return file;
+}
+
+static unsigned bench_run(const bench_run_t *run, const uint8_t *app)
+{
+    uint32_t size;
+    uint8_t *file = bench_make_file(app, BENCH_APP_SIZE, &size);
+    if (run->corrupt) {
+        file[LIGHT_OTA_FILE_HEADER_SIZE + LIGHT_OTA_TAG_HEADER_SIZE + BENCH_APP_SIZE / 2] ^= 0x01;
+    }
+    uint16_t period_ms = run->period_ms;
+    esp_zb_zcl_set_attribute_val(HA_COLOR_DIMMABLE_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE,
+                                 ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MIN_BLOCK_REQUE_ID, &period_ms, false);
+    light_ota_stats_t before;
+    light_ota_get_stats(&before);
+    uint32_t restarts = sim_restart_count();
+    unsigned errors = 0;
+
+    sim_ota_server_t server = {
+        .block_us = run->block_us,
+        .block_max = run->block_max,
+        .cut_at = run->cut_at,
+    };
+    uint64_t start = bench_clock_ns();
+    esp_err_t err = sim_zigbee_ota_serve(HA_COLOR_DIMMABLE_LIGHT_ENDPOINT, file, size, &server);
+    if (run->cut_at) {
+        errors += err != ESP_ERR_TIMEOUT;
+        server.cut_at = 0;
+        err = sim_zigbee_ota_serve(HA_COLOR_DIMMABLE_LIGHT_ENDPOINT, file, size, &server);
+    }
+    uint64_t ns = bench_clock_ns() - start;
+
+    light_ota_stats_t stats;
+    light_ota_get_stats(&stats);
+    uint32_t slot_size;
+    const uint8_t *slot = sim_ota_slot(&slot_size);
+    bool booted = sim_restart_count() != restarts && esp_ota_get_boot_partition() == esp_ota_get_next_update_partition(NULL);
+    if (run->corrupt) {
+        errors += err == ESP_OK || booted || stats.failures == before.failures;
+    } else {
+        errors += err != ESP_OK || !booted || memcmp(slot, app, BENCH_APP_SIZE);
+        errors += run->cut_at && !stats.resumed_from;
+    }
+    printf("{\"bench\":\"ota_%s\",\"file_bytes\":%u,\"block_max\":%u,\"period_ms\":%u,\"blocks\":%u,\"bytes_per_s\":%u,"
+           "\"ns_per_block\":%.0f,\"ram_bytes\":%u,\"checkpoints\":%u,\"resumed_from\":%u,\"errors\":%u}\n",
+           run->name, size, run->block_max ? run->block_max : CONFIG_LIGHT_OTA_BLOCK_SIZE, run->period_ms, stats.blocks, stats.bytes_per_s,
+           stats.blocks ? (double)ns / stats.blocks : 0.0, stats.ram_bytes, stats.checkpoints - before.checkpoints, stats.resumed_from,
+           errors);
+    free(file);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && !strcmp(argv[1], "-v")) {
+        sim_log_enabled = 1;
+    }
+    app_main();
+    if (!esp_zb_zcl_get_attribute(HA_COLOR_DIMMABLE_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE,
+                                  ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID)) {
+        fprintf(stderr, "no OTA client, build with CONFIG_LIGHT_OTA\n");
+        return 1;
+    }
+    uint8_t *app = malloc(BENCH_APP_SIZE);
+    if (!app) {
+        perror("malloc");
+        return 1;
+    }
+    uint32_t rng = 0x2545f491;
+    for (uint32_t i = 0; i < BENCH_APP_SIZE; i++) {
+        app[i] = bench_random(&rng) >> 24;
+    }
+    app[0] = 0xe9;
+    unsigned errors = 0;
+    for (size_t i = 0; i < sizeof(s_runs) / sizeof(s_runs[0]); i++) {
+        errors += bench_run(&s_runs[i], app);
+    }
+    free(app);
+    return errors ? 1 : 0;
+}
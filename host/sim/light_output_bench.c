@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Pushes frames through the light driver to the simulated strip and prints
+ * one JSON line per pacing:
+ *
+ *  - max: frames back to back, what the output path sustains
+ *  - paced: BENCH_PACED_FPS frames per second, like a transition
+ *
+ * with, over the virtual time the run took:
+ *
+ *  - frames_per_s: frames pushed per second
+ *  - cpu_pct: host time spent rendering and copying frames into the strip
+ *  - blocked_pct: time the render context waited for the strip instead
+ *  - power_limited: frames the power limiter scaled down, see
+ *    CONFIG_LIGHT_DRIVER_POWER_BUDGET_MA; its cost is in cpu_pct
+ *  - errors: frames not reported done, or shown pixels that differ
+ *
+ * The strip transfer is modeled (see sim_led_strip.c), the CPU time is the
+ * host's. Build with -DLIGHT_HOST_LED_COUNT=60 or 300 for longer strips and
+ * with -DLIGHT_HOST_LED_ASYNC=OFF for the blocking refresh.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "light_driver.h"
+#include "light_power.h"
+#include "sim.h"
+
+#define BENCH_FRAMES     256
+#define BENCH_PACED_FPS  50
+
+static uint64_t bench_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+static void bench_frame_done(uint32_t frame, uint32_t wire_us, void *user_ctx)
+{
+    (*(uint32_t *)user_ctx)++;
+}
+
+static unsigned bench_run(const char *name, uint32_t fps, uint32_t *done)
+{
+    light_driver_stats_t before, after;
+    light_driver_get_stats(&before);
+    *done = 0;
+    uint64_t start_us = esp_timer_get_time();
+    uint64_t cpu_ns = 0;
+    uint32_t carry_ns = 0;
+    uint8_t level = 0;
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+        if (fps) {
+            uint64_t due_us = start_us + (uint64_t)i * 1000000 / fps;
+            if ((uint64_t)esp_timer_get_time() < due_us) {
+                sim_time_advance_us((uint32_t)(due_us - esp_timer_get_time()));
+            }
+        }
+        /* a new color every frame, or the commit renders nothing */
+        level = level == 255 ? 1 : level + 1;
+        light_driver_set_color_RGB(0, level, 255 - level, level / 2);
+        uint64_t t0 = bench_clock_ns();
+        light_driver_commit();
+        uint32_t ns = (uint32_t)(bench_clock_ns() - t0);
+        cpu_ns += ns;
+        /* the host's CPU time passes on the virtual clock too */
+        carry_ns += ns;
+        sim_time_advance_us(carry_ns / 1000);
+        carry_ns %= 1000;
+    }
+    uint64_t elapsed_us = esp_timer_get_time() - start_us;
+    light_driver_get_stats(&after);
+    uint32_t frames = after.frames - before.frames;
+    /* without the render task a frame is reported done once the next one starts */
+    unsigned errors = frames != BENCH_FRAMES || after.frames_done - before.frames_done != *done || *done + 1 < frames;
+    uint32_t count;
+    const uint8_t *pixels = sim_led_strip_pixels(&count);
+    /* the last color, scaled as the limiter does if it is over budget */
+    uint8_t red = level;
+    if (CONFIG_LIGHT_DRIVER_POWER_BUDGET_MA) {
+        const light_rgb_t last = { .r = level, .g = 255 - level, .b = level / 2 };
+        uint32_t load = light_power_load(&last, 1) * count;
+        red = light_color_scale(level, light_power_scale(load, light_power_budget_load(CONFIG_LIGHT_DRIVER_POWER_BUDGET_MA, count)));
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        errors += pixels[i * 3] != red;
+    }
+    printf("{\"bench\":\"output_%s\",\"leds\":%u,\"refresh\":\"%s\",\"frames\":%u,\"frames_per_s\":%.0f,\"cpu_pct\":%.2f,"
+           "\"blocked_pct\":%.1f,\"power_limited\":%u,\"errors\":%u}\n", name, (unsigned)count,
+           CONFIG_LIGHT_DRIVER_LED_ASYNC ? "async" : "blocking", (unsigned)frames,
+           elapsed_us ? frames * 1e6 / elapsed_us : 0.0, elapsed_us ? cpu_ns / 10.0 / elapsed_us : 0.0,
+           elapsed_us ? (after.wait_us - before.wait_us) * 100.0 / elapsed_us : 0.0,
+           (unsigned)(after.power_limited - before.power_limited), errors);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && !strcmp(argv[1], "-v")) {
+        sim_log_enabled = 1;
+    }
+    uint32_t done;
+    light_driver_config_t config = LIGHT_DRIVER_DEFAULT_CONFIG();
+    config.segment_count = 1;
+    config.on_frame_done = bench_frame_done;
+    config.user_ctx = &done;
+    light_driver_set_power(0, LIGHT_DEFAULT_ON);
+    light_driver_init_with_config(&config);
+    unsigned errors = bench_run("max", 0, &done);
+    errors += bench_run("paced", BENCH_PACED_FPS, &done);
+    return errors ? 1 : 0;
+}
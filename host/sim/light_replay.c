@@ -0,0 +1,335 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Replays a trace of ZCL set-attribute messages through the light firmware
+ * running on the host, and reports:
+ *
+ *  - handler latency: wall time of each zb_attribute_handler() call
+ *  - tick latency: wall time of each stack tick that ran alarms (the
+ *    render commit lives there)
+ *  - LED refresh count and the final pixel buffer
+ *  - light state saves requested and NVS writes done
+ *
+ * Trace format, one message per line, '#' starts a comment:
+ *
+ *     time_ms,endpoint,cluster,attribute,type,value
+ *
+ * Numbers are decimal or 0x hex; type is bool, u8, u16, u32, enum8 or the
+ * raw ZCL type id. Messages with the same time_ms arrive within one stack
+ * tick.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "light_report.h"
+#include "light_store.h"
+#include "light_trace.h"
+#include "sim.h"
+
+void app_main(void);
+
+typedef struct {
+    uint32_t time_ms;
+    uint8_t endpoint;
+    uint16_t cluster;
+    uint16_t attribute;
+    esp_zb_zcl_attr_type_t type;
+    uint32_t value;
+} replay_msg_t;
+
+typedef struct {
+    uint64_t *ns;
+    size_t count;
+    size_t capacity;
+} replay_samples_t;
+
+static uint64_t replay_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+static void replay_samples_add(replay_samples_t *samples, uint64_t ns)
+{
+    if (samples->count == samples->capacity) {
+        samples->capacity = samples->capacity ? samples->capacity * 2 : 1024;
+        samples->ns = realloc(samples->ns, samples->capacity * sizeof(uint64_t));
+        if (!samples->ns) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    samples->ns[samples->count++] = ns;
+}
+
+static int replay_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* nearest-rank percentile of sorted samples */
+static uint64_t replay_percentile(const replay_samples_t *samples, unsigned pct)
+{
+    size_t rank = (samples->count * pct + 99) / 100;
+    return samples->ns[rank ? rank - 1 : 0];
+}
+
+static void replay_report_latency(const char *name, replay_samples_t *samples)
+{
+    if (!samples->count) {
+        printf("%s_ns count=0\n", name);
+        return;
+    }
+    qsort(samples->ns, samples->count, sizeof(uint64_t), replay_cmp_u64);
+    printf("%s_ns count=%zu p50=%llu p90=%llu p99=%llu max=%llu\n", name, samples->count,
+           (unsigned long long)replay_percentile(samples, 50), (unsigned long long)replay_percentile(samples, 90),
+           (unsigned long long)replay_percentile(samples, 99), (unsigned long long)samples->ns[samples->count - 1]);
+}
+
+static bool replay_parse_type(const char *text, esp_zb_zcl_attr_type_t *type)
+{
+    static const struct {
+        const char *name;
+        esp_zb_zcl_attr_type_t type;
+    } names[] = {
+        { "bool", ESP_ZB_ZCL_ATTR_TYPE_BOOL },
+        { "u8", ESP_ZB_ZCL_ATTR_TYPE_U8 },
+        { "u16", ESP_ZB_ZCL_ATTR_TYPE_U16 },
+        { "u32", ESP_ZB_ZCL_ATTR_TYPE_U32 },
+        { "enum8", ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (!strcasecmp(text, names[i].name)) {
+            *type = names[i].type;
+            return true;
+        }
+    }
+    char *end;
+    unsigned long raw = strtoul(text, &end, 0);
+    if (end == text || *end || raw > 0xff) {
+        return false;
+    }
+    *type = (esp_zb_zcl_attr_type_t)raw;
+    return true;
+}
+
+static bool replay_parse_line(char *line, replay_msg_t *msg)
+{
+    char *field[6];
+    int count = 0;
+    for (char *token = strtok(line, ", \t\r\n"); token && count < 6; token = strtok(NULL, ", \t\r\n")) {
+        field[count++] = token;
+    }
+    if (count != 6) {
+        return false;
+    }
+    unsigned long number[6];
+    for (int i = 0; i < 6; i++) {
+        if (i == 4) {
+            continue;
+        }
+        char *end;
+        errno = 0;
+        number[i] = strtoul(field[i], &end, 0);
+        if (end == field[i] || *end || errno) {
+            return false;
+        }
+    }
+    msg->time_ms = number[0];
+    msg->endpoint = number[1];
+    msg->cluster = number[2];
+    msg->attribute = number[3];
+    msg->value = number[5];
+    return replay_parse_type(field[4], &msg->type);
+}
+
+static replay_msg_t *replay_load(const char *path, size_t *count)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return NULL;
+    }
+    replay_msg_t *msgs = NULL;
+    size_t capacity = 0;
+    char line[256];
+    unsigned line_no = 0;
+    *count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_no++;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        if (strspn(line, " \t\r\n") == strlen(line)) {
+            continue;
+        }
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            msgs = realloc(msgs, capacity * sizeof(replay_msg_t));
+            if (!msgs) {
+                perror("realloc");
+                exit(1);
+            }
+        }
+        if (!replay_parse_line(line, &msgs[*count])) {
+            fprintf(stderr, "%s:%u: expected time_ms,endpoint,cluster,attribute,type,value\n", path, line_no);
+            free(msgs);
+            fclose(file);
+            return NULL;
+        }
+        if (*count && msgs[*count].time_ms < msgs[*count - 1].time_ms) {
+            fprintf(stderr, "%s:%u: time goes backwards\n", path, line_no);
+            free(msgs);
+            fclose(file);
+            return NULL;
+        }
+        (*count)++;
+    }
+    fclose(file);
+    return msgs;
+}
+
+/* one stack tick: run whatever alarms are due now */
+static void replay_tick(replay_samples_t *ticks)
+{
+    uint64_t start = replay_clock_ns();
+    unsigned run = sim_zigbee_run_alarms();
+    uint64_t end = replay_clock_ns();
+    if (run) {
+        replay_samples_add(ticks, end - start);
+    }
+}
+
+/* let time pass, running alarms at the moments they fall due; alarms due
+ * at to_ms itself wait, messages arriving then belong to the same tick */
+static void replay_advance(uint32_t to_ms, replay_samples_t *ticks)
+{
+    uint32_t due_ms;
+    while (sim_zigbee_next_alarm(&due_ms) && (int32_t)(to_ms - due_ms) > 0) {
+        sim_time_set_ms(due_ms);
+        replay_tick(ticks);
+    }
+    sim_time_set_ms(to_ms);
+}
+
+static void replay_report_pixels(void)
+{
+    uint32_t count;
+    const uint8_t *pixels = sim_led_strip_pixels(&count);
+    printf("pixels count=%u", count);
+    /* run-length encoded, a uniform strip is one run */
+    for (uint32_t i = 0; i < count;) {
+        uint32_t run = 1;
+        while (i + run < count && !memcmp(&pixels[i * 3], &pixels[(i + run) * 3], 3)) {
+            run++;
+        }
+        printf(" %ux#%02x%02x%02x", run, pixels[i * 3], pixels[i * 3 + 1], pixels[i * 3 + 2]);
+        i += run;
+    }
+    printf("\n");
+}
+
+static void replay_usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-v] [-t] [-n repeat] trace.csv\n"
+            "  -v         print the firmware logs to stderr\n"
+            "  -t         print the binary event trace (LT lines) to stdout\n"
+            "  -n repeat  replay the trace this many times back to back (default 1)\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned repeat = 1;
+    bool trace = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "vtn:")) != -1) {
+        switch (opt) {
+        case 'v':
+            sim_log_enabled = 1;
+            break;
+        case 't':
+            trace = true;
+            break;
+        case 'n':
+            repeat = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            replay_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1 || !repeat) {
+        replay_usage(argv[0]);
+        return 2;
+    }
+    size_t count;
+    replay_msg_t *msgs = replay_load(argv[optind], &count);
+    if (!msgs) {
+        return 1;
+    }
+
+    replay_samples_t handler = { 0 };
+    replay_samples_t ticks = { 0 };
+    app_main();
+    sim_zigbee_signal(ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT, ESP_OK);
+    replay_tick(&ticks);
+    uint32_t boot_refreshes = sim_led_strip_refresh_count();
+    ticks.count = 0;
+
+    unsigned errors = 0;
+    uint32_t base_ms = sim_time_ms();
+    uint32_t span_ms = count ? msgs[count - 1].time_ms + 1 : 0;
+    for (unsigned pass = 0; pass < repeat; pass++, base_ms += span_ms) {
+        for (size_t i = 0; i < count; i++) {
+            const replay_msg_t *msg = &msgs[i];
+            replay_advance(base_ms + msg->time_ms, &ticks);
+            uint64_t start = replay_clock_ns();
+            esp_err_t err = sim_zigbee_write_attr(msg->endpoint, msg->cluster, msg->attribute, msg->type, msg->value);
+            uint64_t end = replay_clock_ns();
+            replay_samples_add(&handler, end - start);
+            if (trace) {
+                light_trace_dump();
+            }
+            if (err != ESP_OK) {
+                if (!errors) {
+                    fprintf(stderr, "message %zu (%u,%u,0x%04x,0x%04x): %s\n", i + 1, msg->time_ms, msg->endpoint, msg->cluster,
+                            msg->attribute, esp_err_to_name(err));
+                }
+                errors++;
+            }
+        }
+    }
+    /* drain: let the last tick, any retries and the pending state save run */
+    replay_advance(sim_time_ms() + CONFIG_LIGHT_STORE_MAX_DELAY_MS, &ticks);
+
+    printf("messages count=%zu repeat=%u errors=%u\n", count * repeat, repeat, errors);
+    replay_report_latency("handler", &handler);
+    replay_report_latency("tick", &ticks);
+    printf("led_refresh count=%u\n", sim_led_strip_refresh_count() - boot_refreshes);
+    replay_report_pixels();
+    light_store_stats_t store;
+    light_store_get_stats(&store);
+    printf("light_store updates=%u avoided=%u nvs_writes=%u\n", store.updates, store.avoided, sim_nvs_write_count());
+    light_report_stats_t report;
+    light_report_get_stats(&report);
+    printf("light_report changes=%u reports_est=%u attributes_est=%u suppressed_est=%u\n", report.changes, report.reports_est,
+           report.attributes_est, report.suppressed_est);
+
+    free(handler.ns);
+    free(ticks.ns);
+    free(msgs);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,355 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Applies generated scenes to every segment of the light firmware running
+ * on the host, three ways, and prints one JSON line per way:
+ *
+ *  - burst: one attribute write per value and segment, BENCH_WRITE_GAP_MS
+ *    apart, the way a bridge without scene support sets a room
+ *  - recall_stored: Recall Scene of scenes stored with Store Scene, with
+ *    every color attribute in the fields the stack holds for them
+ *  - recall_described: Recall Scene with the extension fields of Add Scene,
+ *    the first recall of a scene the table does not know yet
+ *
+ * with:
+ *
+ *  - commands: Zigbee commands a segment receives per scene
+ *  - refreshes: strip refreshes per scene until it shows on all segments,
+ *    fades included
+ *  - ns_per_scene: host time per scene and segment in the command handlers
+ *    and the commits they cause, i.e. the recall latency without the radio
+ *  - bytes_per_scene: RAM of a scene table entry, see light_scene.h
+ *  - errors: scenes that do not show the pixels of the burst they replace
+ *
+ * and one more line, own_transition: a recalled scene must fade for the
+ * transition time the stack passes for it, as added, after Store Scene,
+ * and once a bridge adds it again with another time. The host renders
+ * without the task, so the fade is checked as the recall hands it to the
+ * driver.
+ *
+ * A last line, readded_xy: a color temperature scene a bridge adds again as
+ * xy, with a color field of CurrentX and CurrentY only, must show the xy
+ * color and not keep the color temperature the table knew.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_zb_light.h"
+#include "light_scene.h"
+#include "sim.h"
+
+void app_main(void);
+
+#define BENCH_SCENES            8       /* per segment */
+#define BENCH_GROUP             0x0001
+#define BENCH_DESCRIBED_BASE    0x80    /* scene ids of the Add Scene run */
+#define BENCH_OWN_BASE          0xc0    /* scene ids of the own transition check */
+#define BENCH_OWN_DS            10      /* Add Scene transition time of the first of them, tenths of a second */
+#define BENCH_READDED_DS        3       /* transition time when the scene is added again */
+#define BENCH_WRITE_GAP_MS      15      /* unicast writes to one light, back to back on air */
+#define BENCH_SETTLE_MS         2000    /* longer than any fade, and than the step smoothing */
+
+typedef enum {
+    BENCH_BURST,
+    BENCH_RECALL_STORED,
+    BENCH_RECALL_DESCRIBED,
+} bench_way_t;
+
+static const char *const s_way_names[] = { "burst", "recall_stored", "recall_described" };
+
+typedef struct {
+    bool ct;
+    uint8_t level;
+    uint16_t x;
+    uint16_t y;
+    uint16_t mireds;
+} bench_scene_t;
+
+static bench_scene_t s_scenes[LIGHT_SEGMENT_COUNT][BENCH_SCENES];
+static uint8_t *s_expected[BENCH_SCENES];
+
+static uint64_t bench_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+static uint32_t bench_random(uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/* virtual time passes, alarms (commits, fades, saves) run when due */
+static void bench_settle(uint32_t ms)
+{
+    uint32_t to_ms = sim_time_ms() + ms;
+    uint32_t due_ms;
+    while (sim_zigbee_next_alarm(&due_ms) && (int32_t)(to_ms - due_ms) > 0) {
+        sim_time_set_ms(due_ms);
+        sim_zigbee_run_alarms();
+    }
+    sim_time_set_ms(to_ms);
+}
+
+/* the commit of what was received since start, timed from start */
+static uint64_t bench_command(esp_err_t err, uint64_t start, unsigned *errors)
+{
+    sim_zigbee_run_alarms();
+    *errors += err != ESP_OK;
+    return bench_clock_ns() - start;
+}
+
+static uint64_t bench_burst(uint8_t segment, const bench_scene_t *scene, unsigned *errors, uint32_t *commands)
+{
+    uint8_t endpoint = LIGHT_SEGMENT_ENDPOINT(segment);
+    uint64_t ns = 0;
+    struct {
+        uint16_t cluster_id;
+        uint16_t attr_id;
+        esp_zb_zcl_attr_type_t type;
+        uint32_t value;
+    } writes[4] = {
+        { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, 1 },
+        { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, scene->level },
+        { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, scene->x },
+        { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, scene->y },
+    };
+    size_t count = 4;
+    if (scene->ct) {
+        writes[2].attr_id = ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID;
+        writes[2].value = scene->mireds;
+        count = 3;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (i) {
+            bench_settle(BENCH_WRITE_GAP_MS);
+        }
+        uint64_t start = bench_clock_ns();
+        ns += bench_command(sim_zigbee_write_attr(endpoint, writes[i].cluster_id, writes[i].attr_id, writes[i].type, writes[i].value),
+                            start, errors);
+        (*commands)++;
+    }
+    return ns;
+}
+
+/* The stack hands over the extension fields it holds for the scene: for a
+ * stored scene every color attribute as it was, whatever the ColorMode; for
+ * a described one what Add Scene gave, only the scene's color. */
+static esp_err_t bench_recall(uint8_t segment, uint8_t scene_id, const bench_scene_t *scene, bool described, uint16_t transition_time)
+{
+    uint8_t on_off[1] = { 1 };
+    uint8_t level[1] = { scene->level };
+    uint16_t x = scene->ct && described ? 0 : scene->x;
+    uint16_t y = scene->ct && described ? 0 : scene->y;
+    uint16_t mireds = scene->ct || !described ? scene->mireds : 0;
+    uint8_t color[13] = { x, x >> 8, y, y >> 8 };
+    color[11] = mireds;
+    color[12] = mireds >> 8;
+    esp_zb_zcl_scenes_extension_field_t fields[3] = {
+        { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, sizeof(on_off), on_off, &fields[1] },
+        { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, sizeof(level), level, &fields[2] },
+        { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, sizeof(color), color, NULL },
+    };
+    return sim_zigbee_recall_scene(LIGHT_SEGMENT_ENDPOINT(segment), BENCH_GROUP, scene_id, transition_time, fields);
+}
+
+static unsigned bench_run(bench_way_t way)
+{
+    light_scene_stats_t scene_stats;
+    light_scene_get_stats(&scene_stats);
+    unsigned errors = 0;
+    uint32_t commands = 0;
+    uint32_t refreshes = 0;
+    uint64_t ns = 0;
+    for (uint8_t s = 0; s < BENCH_SCENES; s++) {
+        uint32_t before = sim_led_strip_refresh_count();
+        if (way == BENCH_BURST) {
+            for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+                ns += bench_burst(i, &s_scenes[i][s], &errors, &commands);
+            }
+        } else {
+            /* a group Recall Scene reaches every segment endpoint in the same stack tick */
+            uint64_t start = bench_clock_ns();
+            esp_err_t err = ESP_OK;
+            for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+                bool described = way == BENCH_RECALL_DESCRIBED;
+                esp_err_t ret = bench_recall(i, described ? BENCH_DESCRIBED_BASE + s : s, &s_scenes[i][s], described, 0);
+                err = err == ESP_OK ? ret : err;
+                commands++;
+            }
+            ns += bench_command(err, start, &errors);
+        }
+        bench_settle(BENCH_SETTLE_MS);
+        refreshes += sim_led_strip_refresh_count() - before;
+        uint32_t count;
+        const uint8_t *pixels = sim_led_strip_pixels(&count);
+        errors += memcmp(pixels, s_expected[s], count * 3) != 0;
+    }
+    uint32_t applied = BENCH_SCENES * LIGHT_SEGMENT_COUNT;
+    printf("{\"bench\":\"scene_%s\",\"segments\":%u,\"scenes\":%u,\"commands\":%.2f,\"refreshes\":%.2f,\"ns_per_scene\":%.0f,"
+           "\"bytes_per_scene\":%u,\"table_bytes\":%u,\"errors\":%u}\n",
+           s_way_names[way], LIGHT_SEGMENT_COUNT, BENCH_SCENES, (double)commands / applied, (double)refreshes / BENCH_SCENES,
+           (double)ns / applied, scene_stats.bytes_per_scene, scene_stats.capacity * scene_stats.bytes_per_scene, errors);
+    return errors;
+}
+
+/* the fade of the last recall is want_ms and the scene shows on every segment once it is over */
+static unsigned bench_check_fade(esp_err_t err, uint8_t s, uint32_t want_ms)
+{
+    light_scene_stats_t scene_stats;
+    light_scene_get_stats(&scene_stats);
+    sim_zigbee_run_alarms();
+    bench_settle(BENCH_SETTLE_MS);
+    uint32_t count;
+    const uint8_t *pixels = sim_led_strip_pixels(&count);
+    return err != ESP_OK || scene_stats.transition_ms_last != want_ms || memcmp(pixels, s_expected[s], count * 3) != 0;
+}
+
+static unsigned bench_own_transition(void)
+{
+    unsigned errors = 0;
+    unsigned checks = 0;
+    for (uint8_t s = 0; s < BENCH_SCENES; s++) {
+        uint8_t scene_id = BENCH_OWN_BASE + s;
+        uint16_t own_ds = BENCH_OWN_DS + s;
+        esp_err_t err = ESP_OK;
+        /* added with a transition time */
+        for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+            esp_err_t ret = bench_recall(i, scene_id, &s_scenes[i][s], true, own_ds);
+            err = err == ESP_OK ? ret : err;
+        }
+        errors += bench_check_fade(err, s, own_ds * 100U);
+        /* stored, the stack keeps the time */
+        for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+            esp_err_t ret = sim_zigbee_store_scene(LIGHT_SEGMENT_ENDPOINT(i), BENCH_GROUP, scene_id);
+            ret = ret == ESP_OK ? bench_recall(i, scene_id, &s_scenes[i][s], false, own_ds) : ret;
+            err = err == ESP_OK ? ret : err;
+        }
+        errors += bench_check_fade(err, s, own_ds * 100U);
+        /* added again with another time, same fields */
+        for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+            esp_err_t ret = bench_recall(i, scene_id, &s_scenes[i][s], false, BENCH_READDED_DS);
+            err = err == ESP_OK ? ret : err;
+        }
+        errors += bench_check_fade(err, s, BENCH_READDED_DS * 100U);
+        checks += 3;
+    }
+    printf("{\"bench\":\"scene_own_transition\",\"segments\":%u,\"scenes\":%u,\"checks\":%u,\"errors\":%u}\n", LIGHT_SEGMENT_COUNT,
+           BENCH_SCENES, checks, errors);
+    return errors;
+}
+
+static unsigned bench_readded_xy(void)
+{
+    unsigned errors = 0;
+    unsigned scenes = 0;
+    uint32_t commands = 0;
+    for (uint8_t s = 0; s < BENCH_SCENES; s++) {
+        if (!s_scenes[0][s].ct) {
+            continue;
+        }
+        /* what the scene's xy shows, through the burst */
+        for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+            bench_scene_t xy = s_scenes[i][s];
+            xy.ct = false;
+            bench_burst(i, &xy, &errors, &commands);
+        }
+        bench_settle(BENCH_SETTLE_MS);
+        uint32_t count;
+        const uint8_t *pixels = sim_led_strip_pixels(&count);
+        uint8_t *expected = malloc(count * 3);
+        if (!expected) {
+            perror("malloc");
+            return errors + 1;
+        }
+        memcpy(expected, pixels, count * 3);
+        /* away from it, then the scene as added again */
+        esp_err_t err = ESP_OK;
+        for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+            esp_err_t ret = bench_recall(i, (s + 1) % BENCH_SCENES, &s_scenes[i][(s + 1) % BENCH_SCENES], false, 0);
+            err = err == ESP_OK ? ret : err;
+        }
+        sim_zigbee_run_alarms();
+        bench_settle(BENCH_SETTLE_MS);
+        for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+            const bench_scene_t *scene = &s_scenes[i][s];
+            uint8_t on_off[1] = { 1 };
+            uint8_t level[1] = { scene->level };
+            uint8_t color[4] = { scene->x, scene->x >> 8, scene->y, scene->y >> 8 };
+            esp_zb_zcl_scenes_extension_field_t fields[3] = {
+                { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, sizeof(on_off), on_off, &fields[1] },
+                { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, sizeof(level), level, &fields[2] },
+                { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, sizeof(color), color, NULL },
+            };
+            esp_err_t ret = sim_zigbee_recall_scene(LIGHT_SEGMENT_ENDPOINT(i), BENCH_GROUP, s, 0, fields);
+            err = err == ESP_OK ? ret : err;
+        }
+        sim_zigbee_run_alarms();
+        bench_settle(BENCH_SETTLE_MS);
+        pixels = sim_led_strip_pixels(&count);
+        errors += err != ESP_OK || memcmp(pixels, expected, count * 3) != 0;
+        free(expected);
+        scenes++;
+    }
+    printf("{\"bench\":\"scene_readded_xy\",\"segments\":%u,\"scenes\":%u,\"errors\":%u}\n", LIGHT_SEGMENT_COUNT, scenes, errors);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && !strcmp(argv[1], "-v")) {
+        sim_log_enabled = 1;
+    }
+    app_main();
+    sim_zigbee_signal(ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT, ESP_OK);
+    bench_settle(BENCH_SETTLE_MS);
+
+    /* generate the scenes, show each through the burst and store it */
+    uint32_t rng = 0x2545f491;
+    unsigned errors = 0;
+    uint32_t commands = 0;
+    for (uint8_t s = 0; s < BENCH_SCENES; s++) {
+        for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+            bench_scene_t *scene = &s_scenes[i][s];
+            scene->ct = (s % 4) == 3;
+            scene->level = 1 + bench_random(&rng) % 254;
+            scene->x = 0x2000 + bench_random(&rng) % 0x8000;
+            scene->y = 0x2000 + bench_random(&rng) % 0x8000;
+            scene->mireds = 153 + bench_random(&rng) % 348;
+            bench_burst(i, scene, &errors, &commands);
+        }
+        bench_settle(BENCH_SETTLE_MS);
+        uint32_t count;
+        const uint8_t *pixels = sim_led_strip_pixels(&count);
+        s_expected[s] = malloc(count * 3);
+        if (!s_expected[s]) {
+            perror("malloc");
+            return 1;
+        }
+        memcpy(s_expected[s], pixels, count * 3);
+        for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++) {
+            errors += sim_zigbee_store_scene(LIGHT_SEGMENT_ENDPOINT(i), BENCH_GROUP, s) != ESP_OK;
+        }
+    }
+    if (errors) {
+        fprintf(stderr, "failed to set up the scenes\n");
+        return 1;
+    }
+    for (bench_way_t way = BENCH_BURST; way <= BENCH_RECALL_DESCRIBED; way++) {
+        errors += bench_run(way);
+    }
+    errors += bench_own_transition();
+    errors += bench_readded_xy();
+    for (uint8_t s = 0; s < BENCH_SCENES; s++) {
+        free(s_expected[s]);
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Streams generated animations through the pixel stream cluster of the
+ * light firmware running on the host, and prints one JSON line per
+ * pattern and encoding:
+ *
+ *  - bytes_per_pixel: chunk payload bytes (headers included) per pixel shown
+ *  - chunks_per_frame: Zigbee commands per frame, what bounds the frame
+ *    rate on air
+ *  - frames_per_s: frames the firmware takes per second of host time, from
+ *    the command handler to the strip refresh
+ *  - errors: shown frames that differ from the generated one, scaled to
+ *    the power budget where it is over
+ *
+ * The encoder here is the reference for controllers: raw pixels, ops
+ * (literal and repeat runs) on every frame, or ops against the previous
+ * frame (skip runs) with a full frame every BENCH_KEY_INTERVAL frames.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_zb_light.h"
+#include "light_color.h"
+#include "light_power.h"
+#include "light_stream.h"
+#include "sim.h"
+
+void app_main(void);
+
+/* ZCL payload that fits one unfragmented APS frame with network security */
+#define BENCH_PAYLOAD_MAX   72
+#define BENCH_FRAMES        256
+#define BENCH_KEY_INTERVAL  32
+
+typedef enum {
+    BENCH_RAW,
+    BENCH_OPS,
+    BENCH_DELTA,
+} bench_encoding_t;
+
+static const char *const s_encoding_names[] = { "raw", "ops", "delta" };
+
+typedef struct {
+    uint8_t seq;
+    uint16_t led_count;
+    /* the chunk being built, sent once the next one starts or the frame ends */
+    uint8_t chunk[BENCH_PAYLOAD_MAX];
+    uint16_t chunk_size;
+    bool pending;
+    /* totals */
+    uint64_t ns;
+    uint32_t chunks;
+    uint32_t bytes;
+    uint32_t errors;
+} bench_stream_t;
+
+static uint64_t bench_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+static void bench_send(bench_stream_t *stream, bool show)
+{
+    if (!stream->pending) {
+        return;
+    }
+    if (show) {
+        stream->chunk[1] |= LIGHT_STREAM_FLAG_SHOW;
+    }
+    uint64_t start = bench_clock_ns();
+    esp_err_t err = sim_zigbee_custom_cmd(HA_COLOR_DIMMABLE_LIGHT_ENDPOINT, LIGHT_STREAM_CLUSTER_ID, LIGHT_STREAM_CMD_CHUNK,
+                                          stream->chunk, stream->chunk_size);
+    stream->ns += bench_clock_ns() - start;
+    if (err != ESP_OK) {
+        stream->errors++;
+    }
+    stream->chunks++;
+    stream->bytes += stream->chunk_size;
+    stream->pending = false;
+}
+
+static void bench_chunk_start(bench_stream_t *stream, uint8_t flags, uint16_t first)
+{
+    bench_send(stream, false);
+    stream->chunk[0] = stream->seq++;
+    stream->chunk[1] = flags;
+    stream->chunk[2] = first & 0xff;
+    stream->chunk[3] = first >> 8;
+    stream->chunk_size = LIGHT_STREAM_HEADER_SIZE;
+    stream->pending = true;
+}
+
+static void bench_encode_raw(bench_stream_t *stream, const uint8_t *frame)
+{
+    const uint16_t per_chunk = (BENCH_PAYLOAD_MAX - LIGHT_STREAM_HEADER_SIZE) / 3;
+    for (uint16_t first = 0; first < stream->led_count; first += per_chunk) {
+        uint16_t count = stream->led_count - first < per_chunk ? stream->led_count - first : per_chunk;
+        bench_chunk_start(stream, 0, first);
+        memcpy(stream->chunk + stream->chunk_size, frame + first * 3, count * 3);
+        stream->chunk_size += count * 3;
+    }
+}
+
+static bool bench_same(const uint8_t *a, uint16_t i, const uint8_t *b, uint16_t j)
+{
+    return !memcmp(a + i * 3, b + j * 3, 3);
+}
+
+/* greedy ops: skip pixels equal to prev, repeat runs of two or more, literals
+ * for the rest; a chunk never starts with a skip, it starts further instead */
+static void bench_encode_ops(bench_stream_t *stream, const uint8_t *frame, const uint8_t *prev)
+{
+    uint8_t flags = LIGHT_STREAM_FLAG_OPS | (prev ? LIGHT_STREAM_FLAG_DELTA : 0);
+    uint16_t n = stream->led_count;
+    bool open = false;
+    uint16_t pos = 0;
+    while (pos < n) {
+        uint16_t run = 1;
+        if (prev && bench_same(frame, pos, prev, pos)) {
+            while (pos + run < n && run < LIGHT_STREAM_OP_COUNT_MAX && bench_same(frame, pos + run, prev, pos + run)) {
+                run++;
+            }
+            if (open && stream->chunk_size + 1 <= BENCH_PAYLOAD_MAX) {
+                stream->chunk[stream->chunk_size++] = LIGHT_STREAM_OP_SKIP | (run - 1);
+            } else {
+                open = false;
+            }
+            pos += run;
+            continue;
+        }
+        bool repeat = pos + 1 < n && bench_same(frame, pos, frame, pos + 1);
+        if (repeat) {
+            while (pos + run < n && run < LIGHT_STREAM_OP_COUNT_MAX && bench_same(frame, pos, frame, pos + run)) {
+                run++;
+            }
+        } else {
+            while (pos + run < n && run < LIGHT_STREAM_OP_COUNT_MAX &&
+                    !(pos + run + 1 < n && bench_same(frame, pos + run, frame, pos + run + 1)) &&
+                    !(prev && bench_same(frame, pos + run, prev, pos + run))) {
+                run++;
+            }
+        }
+        if (!open || stream->chunk_size + 4 > BENCH_PAYLOAD_MAX) {
+            bench_chunk_start(stream, flags, pos);
+            open = true;
+        }
+        if (repeat) {
+            stream->chunk[stream->chunk_size++] = LIGHT_STREAM_OP_REPEAT | (run - 1);
+            memcpy(stream->chunk + stream->chunk_size, frame + pos * 3, 3);
+            stream->chunk_size += 3;
+        } else {
+            uint16_t room = (BENCH_PAYLOAD_MAX - stream->chunk_size - 1) / 3;
+            run = run < room ? run : room;
+            stream->chunk[stream->chunk_size++] = LIGHT_STREAM_OP_LITERAL | (run - 1);
+            memcpy(stream->chunk + stream->chunk_size, frame + pos * 3, run * 3);
+            stream->chunk_size += run * 3;
+        }
+        pos += run;
+    }
+    if (!stream->pending) {
+        /* nothing changed, the frame is an empty chunk */
+        bench_chunk_start(stream, flags, 0);
+    }
+}
+
+static uint32_t bench_random(uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/* patterns: frame t from frame t - 1 (in place) */
+static void bench_solid(uint8_t *frame, uint16_t n, uint32_t t, uint32_t *rng)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        frame[i * 3 + 0] = t * 7;
+        frame[i * 3 + 1] = 255 - t;
+        frame[i * 3 + 2] = t * 3;
+    }
+}
+
+static void bench_rainbow(uint8_t *frame, uint16_t n, uint32_t t, uint32_t *rng)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        light_rgb_t rgb;
+        light_color_hsv_to_rgb(i * 256 / n + t * 4, 255, 255, &rgb);
+        frame[i * 3 + 0] = rgb.r;
+        frame[i * 3 + 1] = rgb.g;
+        frame[i * 3 + 2] = rgb.b;
+    }
+}
+
+static void bench_chase(uint8_t *frame, uint16_t n, uint32_t t, uint32_t *rng)
+{
+    memset(frame, 0, n * 3);
+    for (uint16_t k = 0; k < 4 && k <= t; k++) {
+        uint16_t i = (t - k) % n;
+        memset(frame + i * 3, 255 >> (k * 2), 3);
+    }
+}
+
+static void bench_sparkle(uint8_t *frame, uint16_t n, uint32_t t, uint32_t *rng)
+{
+    for (uint16_t k = 0; k < (n + 15) / 16; k++) {
+        uint32_t r = bench_random(rng);
+        uint16_t i = r % n;
+        frame[i * 3 + 0] = r >> 8;
+        frame[i * 3 + 1] = r >> 16;
+        frame[i * 3 + 2] = r >> 24;
+    }
+}
+
+static const struct {
+    const char *name;
+    void (*next)(uint8_t *frame, uint16_t n, uint32_t t, uint32_t *rng);
+} s_patterns[] = {
+    { "solid", bench_solid },
+    { "rainbow", bench_rainbow },
+    { "chase", bench_chase },
+    { "sparkle", bench_sparkle },
+};
+
+/* the frame as the strip shows it, after the power limiter */
+static void bench_limit(uint8_t *frame, uint16_t n)
+{
+    if (!CONFIG_LIGHT_DRIVER_POWER_BUDGET_MA) {
+        return;
+    }
+    uint32_t load = light_power_load((const light_rgb_t *)frame, n);
+    uint8_t scale = light_power_scale(load, light_power_budget_load(CONFIG_LIGHT_DRIVER_POWER_BUDGET_MA, n));
+    for (uint32_t i = 0; scale != UINT8_MAX && i < n * 3U; i++) {
+        frame[i] = light_color_scale(frame[i], scale);
+    }
+}
+
+static void bench_run(bench_stream_t *stream, size_t pattern, bench_encoding_t encoding)
+{
+    uint16_t n = stream->led_count;
+    uint8_t *frame = calloc(n, 3);
+    uint8_t *prev = calloc(n, 3);
+    uint8_t *shown = calloc(n, 3);
+    if (!frame || !prev || !shown) {
+        perror("calloc");
+        exit(1);
+    }
+    uint32_t rng = 0x2545f491;
+    stream->ns = 0;
+    stream->chunks = 0;
+    stream->bytes = 0;
+    stream->errors = 0;
+    for (uint32_t t = 0; t < BENCH_FRAMES; t++) {
+        s_patterns[pattern].next(frame, n, t, &rng);
+        switch (encoding) {
+        case BENCH_RAW:
+            bench_encode_raw(stream, frame);
+            break;
+        case BENCH_OPS:
+            bench_encode_ops(stream, frame, NULL);
+            break;
+        case BENCH_DELTA:
+            bench_encode_ops(stream, frame, t % BENCH_KEY_INTERVAL ? prev : NULL);
+            break;
+        }
+        bench_send(stream, true);
+        memcpy(shown, frame, n * 3);
+        bench_limit(shown, n);
+        uint32_t count;
+        const uint8_t *pixels = sim_led_strip_pixels(&count);
+        if (count != n || memcmp(pixels, shown, n * 3)) {
+            stream->errors++;
+        }
+        memcpy(prev, frame, n * 3);
+    }
+    printf("{\"bench\":\"stream_%s_%s\",\"leds\":%u,\"frames\":%u,\"chunks_per_frame\":%.2f,\"bytes_per_pixel\":%.3f,"
+           "\"frames_per_s\":%.0f,\"errors\":%u}\n", s_patterns[pattern].name, s_encoding_names[encoding], n, BENCH_FRAMES,
+           (double)stream->chunks / BENCH_FRAMES, (double)stream->bytes / ((double)BENCH_FRAMES * n),
+           stream->ns ? BENCH_FRAMES * 1e9 / stream->ns : 0.0, stream->errors);
+    free(frame);
+    free(prev);
+    free(shown);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && !strcmp(argv[1], "-v")) {
+        sim_log_enabled = 1;
+    }
+    app_main();
+    uint16_t led_count = 0;
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(HA_COLOR_DIMMABLE_LIGHT_ENDPOINT, LIGHT_STREAM_CLUSTER_ID,
+                                                       ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, LIGHT_STREAM_ATTR_LED_COUNT);
+    if (!attr) {
+        fprintf(stderr, "no stream cluster, build with CONFIG_LIGHT_DRIVER_STREAM\n");
+        return 1;
+    }
+    memcpy(&led_count, attr->data_p, sizeof(led_count));
+    bench_stream_t stream = {
+        .led_count = led_count,
+    };
+    unsigned errors = 0;
+    for (size_t p = 0; p < sizeof(s_patterns) / sizeof(s_patterns[0]); p++) {
+        for (bench_encoding_t e = BENCH_RAW; e <= BENCH_DELTA; e++) {
+            bench_run(&stream, p, e);
+            errors += stream.errors;
+        }
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation of the light firmware
+ *
+ * The firmware sources are compiled unchanged against the stubs in
+ * host/stubs. Time is virtual, there is no scheduler: the caller advances
+ * the clock and runs the Zigbee alarms that became due, the way the stack
+ * main loop would between two received frames.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+* @brief Move the virtual clock, it never goes backwards
+*/
+void sim_time_set_ms(uint32_t now_ms);
+
+uint32_t sim_time_ms(void);
+
+/**
+* @brief Move the virtual clock forward by some time spent, e.g. waiting for LED I/O
+*/
+void sim_time_advance_us(uint32_t us);
+
+/**
+* @brief Run every scheduler alarm due at the current virtual time
+*
+* Alarms scheduled from a callback with no delay run in the same call.
+*
+* @return number of callbacks run
+*/
+unsigned sim_zigbee_run_alarms(void);
+
+/**
+* @brief Earliest pending alarm
+*
+* @param due_ms when it is due, never before the current virtual time
+* @return false if no alarm is pending
+*/
+bool sim_zigbee_next_alarm(uint32_t *due_ms);
+
+/**
+* @brief Deliver a set-attribute message, as received from the network
+*
+* The attribute store is updated first, then the registered action handler
+* is called with ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID.
+*
+* @return what the action handler returned
+*/
+esp_err_t sim_zigbee_write_attr(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, esp_zb_zcl_attr_type_t type, uint32_t value);
+
+/**
+* @brief Deliver a manufacturer specific cluster command, as received from the network
+*
+* The registered action handler is called with
+* ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID, the payload is passed as is.
+*
+* @return ESP_ERR_NOT_FOUND if the endpoint has no such cluster, else what the action handler returned
+*/
+esp_err_t sim_zigbee_custom_cmd(uint8_t endpoint, uint16_t cluster_id, uint8_t cmd_id, const void *data, uint16_t size);
+
+/**
+* @brief Start or end identifying, as the Identify cluster of the stack does when IdentifyTime changes
+*
+* @return ESP_ERR_NOT_FOUND if no identify handler is registered for the endpoint
+*/
+esp_err_t sim_zigbee_identify(uint8_t endpoint, bool identify_on);
+
+/**
+* @brief Deliver an Identify TriggerEffect command, as received from the network
+*
+* The registered action handler is called with ESP_ZB_CORE_IDENTIFY_EFFECT_CB_ID.
+*
+* @return what the action handler returned
+*/
+esp_err_t sim_zigbee_trigger_effect(uint8_t endpoint, uint8_t effect_id, uint8_t effect_variant);
+
+/**
+* @brief Deliver a Store Scene command, as the Scenes cluster of the stack does after adding the scene to its table
+*
+* The registered action handler is called with ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID.
+*
+* @return ESP_ERR_NOT_FOUND if the endpoint has no Scenes cluster, else what the action handler returned
+*/
+esp_err_t sim_zigbee_store_scene(uint8_t endpoint, uint16_t group_id, uint8_t scene_id);
+
+/**
+* @brief Deliver a Recall Scene command, as the Scenes cluster of the stack does for a scene in its table
+*
+* The registered action handler is called with ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID.
+*
+* @param transition_time the scene's transition time the stack holds, tenths of a second
+* @param field_set       extension fields the stack holds for the scene, from Add Scene or Store Scene, NULL for none
+* @return ESP_ERR_NOT_FOUND if the endpoint has no Scenes cluster, else what the action handler returned
+*/
+esp_err_t sim_zigbee_recall_scene(uint8_t endpoint, uint16_t group_id, uint8_t scene_id, uint16_t transition_time,
+                                  esp_zb_zcl_scenes_extension_field_t *field_set);
+
+/** What the stand-in OTA server of sim_zigbee_ota_serve() does */
+typedef struct {
+    uint32_t block_us;          /*!< Time per block request and response on air, at least the client's MinimumBlockPeriod */
+    uint8_t block_max;          /*!< Largest block the server sends, 0 for what the client asks */
+    uint32_t cut_at;            /*!< Abort before the block that would pass this file offset, 0 never */
+} sim_ota_server_t;
+
+/**
+* @brief Serve an upgrade file to the OTA client of an endpoint, as an OTA Upgrade server would
+*
+* Like the stack: if the file is newer than the client's FileVersion, the
+* action handler gets ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID messages, START,
+* one RECEIVE per block, CHECK, APPLY and FINISH, or ABORT when cut. The
+* download starts at the client's FileOffset if DownloadedFileVersion is the
+* file's. The virtual clock advances and due alarms run before every block.
+*
+* @param file the whole upgrade file, header included
+* @return ESP_ERR_NOT_FOUND if the client does not want the file, ESP_ERR_TIMEOUT when cut, else what the action handler returned
+*/
+esp_err_t sim_zigbee_ota_serve(uint8_t endpoint, const uint8_t *file, uint32_t size, const sim_ota_server_t *server);
+
+/**
+* @brief Raise an application signal, esp_zb_app_signal_handler() runs synchronously
+*/
+void sim_zigbee_signal(esp_zb_app_signal_type_t type, esp_err_t status);
+
+/**
+* @brief Number of strip refreshes (led_strip_refresh() or led_strip_refresh_async()) so far
+*/
+uint32_t sim_led_strip_refresh_count(void);
+
+/**
+* @brief Pixels as of the last refresh, 3 bytes (r, g, b) per LED
+*
+* @param count number of LEDs
+*/
+const uint8_t *sim_led_strip_pixels(uint32_t *count);
+
+/**
+* @brief Number of nvs_set_blob() and nvs_erase_key() calls so far, i.e. flash writes
+*/
+uint32_t sim_nvs_write_count(void);
+
+/**
+* @brief Contents of the OTA update slot
+*
+* @param size slot size
+*/
+const uint8_t *sim_ota_slot(uint32_t *size);
+
+/**
+* @brief Number of 4 KB sectors erased in the OTA update slot so far
+*/
+uint32_t sim_ota_erase_count(void);
+
+/**
+* @brief Number of esp_restart() calls so far, the simulation carries on after each
+*/
+uint32_t sim_restart_count(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
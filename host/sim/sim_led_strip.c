@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation of led_strip: set_pixel writes a staging buffer, refresh
+ * copies it to what the LEDs "show" and counts the frame. The transfer takes
+ * virtual time, SIM_LED_WIRE_US_PER_LED per LED plus the reset code: a
+ * blocking refresh moves the clock past it, an async one leaves the strip
+ * busy until then and set_pixel fails meanwhile, like the real buffer would
+ * be corrupted.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "led_strip.h"
+#include "sim.h"
+
+static const char *TAG = "SIM_LED_STRIP";
+
+/* WS2812 at 800 kHz: 24 bits of 1.25 us, then at least 50 us low */
+#define SIM_LED_WIRE_US_PER_LED 30
+#define SIM_LED_RESET_US 50
+
+struct led_strip_t {
+    uint32_t count;
+    uint8_t *staging;
+    uint8_t *shown;
+    int64_t busy_until_us;
+};
+
+static struct led_strip_t *s_strip;
+static uint32_t s_refresh_count;
+
+static esp_err_t sim_led_strip_new(const led_strip_config_t *led_config, led_strip_handle_t *ret_strip)
+{
+    ESP_RETURN_ON_FALSE(led_config && ret_strip && led_config->max_leds, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    struct led_strip_t *strip = calloc(1, sizeof(*strip));
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_NO_MEM, TAG, "no mem for strip");
+    strip->count = led_config->max_leds;
+    strip->staging = calloc(strip->count, 3);
+    strip->shown = calloc(strip->count, 3);
+    ESP_RETURN_ON_FALSE(strip->staging && strip->shown, ESP_ERR_NO_MEM, TAG, "no mem for pixels");
+    s_strip = strip;
+    *ret_strip = strip;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                   led_strip_handle_t *ret_strip)
+{
+    (void)rmt_config;
+    return sim_led_strip_new(led_config, ret_strip);
+}
+
+esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config,
+                                   led_strip_handle_t *ret_strip)
+{
+    (void)spi_config;
+    return sim_led_strip_new(led_config, ret_strip);
+}
+
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    ESP_RETURN_ON_FALSE(index < strip->count, ESP_ERR_INVALID_ARG, TAG, "index out of range");
+    ESP_RETURN_ON_FALSE(esp_timer_get_time() >= strip->busy_until_us, ESP_ERR_INVALID_STATE, TAG, "pixel written during a transfer");
+    strip->staging[index * 3 + 0] = red & 0xff;
+    strip->staging[index * 3 + 1] = green & 0xff;
+    strip->staging[index * 3 + 2] = blue & 0xff;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(esp_timer_get_time() >= strip->busy_until_us, ESP_ERR_INVALID_STATE, TAG, "refresh during a transfer");
+    memcpy(strip->shown, strip->staging, strip->count * 3);
+    strip->busy_until_us = esp_timer_get_time() + strip->count * SIM_LED_WIRE_US_PER_LED + SIM_LED_RESET_US;
+    s_refresh_count++;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_refresh_wait_done(led_strip_handle_t strip)
+{
+    int64_t now = esp_timer_get_time();
+    if (now < strip->busy_until_us) {
+        sim_time_advance_us((uint32_t)(strip->busy_until_us - now));
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_refresh(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_ERROR(led_strip_refresh_async(strip), TAG, "refresh failed");
+    return led_strip_refresh_wait_done(strip);
+}
+
+esp_err_t led_strip_clear(led_strip_handle_t strip)
+{
+    memset(strip->staging, 0, strip->count * 3);
+    return led_strip_refresh(strip);
+}
+
+esp_err_t led_strip_del(led_strip_handle_t strip)
+{
+    if (strip == s_strip) {
+        s_strip = NULL;
+    }
+    free(strip->staging);
+    free(strip->shown);
+    free(strip);
+    return ESP_OK;
+}
+
+uint32_t sim_led_strip_refresh_count(void)
+{
+    return s_refresh_count;
+}
+
+const uint8_t *sim_led_strip_pixels(uint32_t *count)
+{
+    *count = s_strip ? s_strip->count : 0;
+    return s_strip ? s_strip->shown : NULL;
+}
@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation of NVS: a few blobs in RAM, counting the writes that
+ * would hit flash
+ */
+
+#include <string.h>
+#include "nvs.h"
+#include "sim.h"
+
+#define SIM_NVS_ENTRIES     24
+#define SIM_NVS_NAME_LEN    16
+#define SIM_NVS_BLOB_MAX    64
+
+typedef struct {
+    nvs_handle_t handle;
+    char key[SIM_NVS_NAME_LEN];
+    uint8_t data[SIM_NVS_BLOB_MAX];
+    size_t length;
+} sim_nvs_entry_t;
+
+static char s_namespaces[SIM_NVS_ENTRIES][SIM_NVS_NAME_LEN];
+static sim_nvs_entry_t s_entries[SIM_NVS_ENTRIES];
+static uint32_t s_writes;
+
+static sim_nvs_entry_t *sim_nvs_find(nvs_handle_t handle, const char *key, bool create)
+{
+    for (int i = 0; i < SIM_NVS_ENTRIES; i++) {
+        if (s_entries[i].handle == handle && !strncmp(s_entries[i].key, key, SIM_NVS_NAME_LEN)) {
+            return &s_entries[i];
+        }
+    }
+    for (int i = 0; create && i < SIM_NVS_ENTRIES; i++) {
+        if (!s_entries[i].handle) {
+            s_entries[i].handle = handle;
+            strncpy(s_entries[i].key, key, SIM_NVS_NAME_LEN - 1);
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    (void)open_mode;
+    /* handles are namespace index + 1, zero marks a free entry */
+    for (int i = 0; i < SIM_NVS_ENTRIES; i++) {
+        if (!s_namespaces[i][0] || !strncmp(s_namespaces[i], namespace_name, SIM_NVS_NAME_LEN)) {
+            strncpy(s_namespaces[i], namespace_name, SIM_NVS_NAME_LEN - 1);
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    sim_nvs_entry_t *entry = sim_nvs_find(handle, key, false);
+    if (!entry) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out_value) {
+        if (*length < entry->length) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(out_value, entry->data, entry->length);
+    }
+    *length = entry->length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (length > SIM_NVS_BLOB_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    sim_nvs_entry_t *entry = sim_nvs_find(handle, key, true);
+    if (!entry) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(entry->data, value, length);
+    entry->length = length;
+    s_writes++;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    sim_nvs_entry_t *entry = sim_nvs_find(handle, key, false);
+    if (!entry) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    memset(entry, 0, sizeof(*entry));
+    s_writes++;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+uint32_t sim_nvs_write_count(void)
+{
+    return s_writes;
+}
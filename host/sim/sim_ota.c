@@ -0,0 +1,170 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation of the two OTA app slots of partitions.csv and of the
+ * esp_ota_* calls the light uses. The inactive slot is NOR flash in RAM:
+ * erased to 0xff a sector at a time, a write can only clear bits, so a
+ * missed erase corrupts the image the way it would on the chip.
+ */
+
+#include <string.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "sim.h"
+
+#define SIM_OTA_SLOT_SIZE       0x1c0000
+#define SIM_OTA_SECTOR_SIZE     0x1000
+#define SIM_OTA_IMAGE_MAGIC     0xe9
+#define SIM_OTA_HANDLE          1
+
+static const char *TAG = "SIM_OTA";
+
+static const esp_partition_t s_slots[2] = {
+    {
+        .type = ESP_PARTITION_TYPE_APP,
+        .subtype = ESP_PARTITION_SUBTYPE_APP_OTA_0,
+        .address = 0x10000,
+        .size = SIM_OTA_SLOT_SIZE,
+        .erase_size = SIM_OTA_SECTOR_SIZE,
+        .label = "ota_0",
+    },
+    {
+        .type = ESP_PARTITION_TYPE_APP,
+        .subtype = ESP_PARTITION_SUBTYPE_APP_OTA_1,
+        .address = 0x1e0000,
+        .size = SIM_OTA_SLOT_SIZE,
+        .erase_size = SIM_OTA_SECTOR_SIZE,
+        .label = "ota_1",
+    },
+};
+
+/* contents of ota_1, the one the running app from ota_0 updates */
+static uint8_t s_flash[SIM_OTA_SLOT_SIZE];
+static const esp_partition_t *s_boot = &s_slots[0];
+static bool s_open;
+static bool s_erase_as_written;
+static uint32_t s_wrote;
+static uint32_t s_erases;
+
+static void sim_ota_erase(uint32_t offset, uint32_t size)
+{
+    memset(s_flash + offset, 0xff, size);
+    s_erases += size / SIM_OTA_SECTOR_SIZE;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    ESP_RETURN_ON_FALSE(partition == &s_slots[1], ESP_ERR_NOT_SUPPORTED, TAG, "only the update slot is simulated");
+    ESP_RETURN_ON_FALSE(src_offset <= partition->size && size <= partition->size - src_offset, ESP_ERR_INVALID_SIZE, TAG,
+                        "read beyond the partition");
+    memcpy(dst, s_flash + src_offset, size);
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    return &s_slots[0];
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    (void)start_from;
+    return &s_slots[1];
+}
+
+esp_err_t esp_ota_resume(const esp_partition_t *partition, const size_t erase_size, const size_t image_offset,
+                         esp_ota_handle_t *out_handle)
+{
+    ESP_RETURN_ON_FALSE(partition == &s_slots[1] && out_handle, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(!s_open, ESP_ERR_INVALID_STATE, TAG, "update already in progress");
+    ESP_RETURN_ON_FALSE(image_offset <= partition->size, ESP_ERR_INVALID_ARG, TAG, "offset beyond the partition");
+    s_erase_as_written = erase_size == OTA_WITH_SEQUENTIAL_WRITES;
+    if (!s_erase_as_written) {
+        /* erase the rest up front, up to the image size or the whole partition */
+        uint32_t end = erase_size == OTA_SIZE_UNKNOWN || erase_size > partition->size ? partition->size : erase_size;
+        uint32_t start = image_offset - image_offset % SIM_OTA_SECTOR_SIZE;
+        end = (end + SIM_OTA_SECTOR_SIZE - 1) / SIM_OTA_SECTOR_SIZE * SIM_OTA_SECTOR_SIZE;
+        if (end > start) {
+            sim_ota_erase(start, end - start);
+        }
+    }
+    s_wrote = image_offset;
+    s_open = true;
+    *out_handle = SIM_OTA_HANDLE;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    return esp_ota_resume(partition, image_size, 0, out_handle);
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    ESP_RETURN_ON_FALSE(handle == SIM_OTA_HANDLE && s_open && (data || !size), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(size <= SIM_OTA_SLOT_SIZE - s_wrote, ESP_ERR_INVALID_SIZE, TAG, "image larger than the partition");
+    if (!size) {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_FALSE(s_wrote || ((const uint8_t *)data)[0] == SIM_OTA_IMAGE_MAGIC, ESP_ERR_OTA_VALIDATE_FAILED, TAG,
+                        "not an app image");
+    if (s_erase_as_written) {
+        /* like esp_ota_write(): erase each sector when the first byte of it is written */
+        uint32_t first = s_wrote / SIM_OTA_SECTOR_SIZE;
+        uint32_t last = (s_wrote + size - 1) / SIM_OTA_SECTOR_SIZE;
+        if (s_wrote % SIM_OTA_SECTOR_SIZE) {
+            first++;
+        }
+        if (last >= first) {
+            sim_ota_erase(first * SIM_OTA_SECTOR_SIZE, (last - first + 1) * SIM_OTA_SECTOR_SIZE);
+        }
+    }
+    const uint8_t *in = data;
+    for (size_t i = 0; i < size; i++) {
+        s_flash[s_wrote + i] &= in[i];
+    }
+    s_wrote += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle == SIM_OTA_HANDLE && s_open, ESP_ERR_NOT_FOUND, TAG, "no such update");
+    s_open = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle == SIM_OTA_HANDLE && s_open, ESP_ERR_NOT_FOUND, TAG, "no such update");
+    s_open = false;
+    /* esp_image_verify() checks much more; the magic byte stands in for it */
+    ESP_RETURN_ON_FALSE(s_wrote && s_flash[0] == SIM_OTA_IMAGE_MAGIC, ESP_ERR_OTA_VALIDATE_FAILED, TAG, "image does not validate");
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    ESP_RETURN_ON_FALSE(partition == &s_slots[0] || partition == &s_slots[1], ESP_ERR_INVALID_ARG, TAG, "not an app slot");
+    s_boot = partition;
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_boot_partition(void)
+{
+    return s_boot;
+}
+
+const uint8_t *sim_ota_slot(uint32_t *size)
+{
+    *size = SIM_OTA_SLOT_SIZE;
+    return s_flash;
+}
+
+uint32_t sim_ota_erase_count(void)
+{
+    return s_erases;
+}
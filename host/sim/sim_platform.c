@@ -0,0 +1,241 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation of the ESP-IDF platform pieces: errors, logs, the
+ * virtual clock, randomness, NVS, restarts and FreeRTOS tasks.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_ota_ops.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sim.h"
+
+int sim_log_enabled;
+
+static uint64_t s_now_us;
+static uint32_t s_restarts;
+
+void sim_time_set_ms(uint32_t now_ms)
+{
+    uint64_t now_us = (uint64_t)now_ms * 1000;
+    if (now_us > s_now_us) {
+        s_now_us = now_us;
+    }
+}
+
+void sim_time_advance_us(uint32_t us)
+{
+    s_now_us += us;
+}
+
+uint32_t sim_time_ms(void)
+{
+    return (uint32_t)(s_now_us / 1000);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)s_now_us;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return sim_time_ms();
+}
+
+void sim_log_write(char level, const char *tag, const char *format, ...)
+{
+    if (!sim_log_enabled) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%c (%u) %s: ", level, esp_log_timestamp(), tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_VERSION:
+        return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_OTA_VALIDATE_FAILED:
+        return "ESP_ERR_OTA_VALIDATE_FAILED";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+/* xorshift32 with a fixed seed, replays stay reproducible */
+uint32_t esp_random(void)
+{
+    static uint32_t state = 0x2545f491;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/* there is nothing to reboot into: count it, the caller carries on */
+void esp_restart(void)
+{
+    s_restarts++;
+}
+
+uint32_t sim_restart_count(void)
+{
+    return s_restarts;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    return ESP_OK;
+}
+
+/* no scheduler: a task runs to completion on the caller's thread, so task
+ * functions must return (esp_zb_stack_main_loop() does in the simulation) */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id)
+{
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+    (void)core_id;
+    if (handle) {
+        *handle = NULL;
+    }
+    fn(arg);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+/* static tasks run to completion too; the TCB keeps the name so
+ * xTaskGetHandle() finds them */
+#define SIM_TASK_MAX 8
+static StaticTask_t *s_static_tasks[SIM_TASK_MAX];
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                           UBaseType_t priority, StackType_t *stack, StaticTask_t *task, BaseType_t core_id)
+{
+    (void)priority;
+    (void)core_id;
+    if (!stack || !task) {
+        return NULL;
+    }
+    task->name = name;
+    task->stack_depth = stack_depth;
+    for (int i = 0; i < SIM_TASK_MAX; i++) {
+        if (!s_static_tasks[i] || s_static_tasks[i] == task) {
+            s_static_tasks[i] = task;
+            break;
+        }
+    }
+    fn(arg);
+    return task;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority,
+                               StackType_t *stack, StaticTask_t *task)
+{
+    return xTaskCreateStaticPinnedToCore(fn, name, stack_depth, arg, priority, stack, task, tskNO_AFFINITY);
+}
+
+TaskHandle_t xTaskGetHandle(const char *name)
+{
+    for (int i = 0; i < SIM_TASK_MAX && s_static_tasks[i]; i++) {
+        if (!strcmp(s_static_tasks[i]->name, name)) {
+            return s_static_tasks[i];
+        }
+    }
+    return NULL;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    (void)clear_on_exit;
+    (void)ticks_to_wait;
+    return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    (void)task;
+    return pdPASS;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return sim_time_ms() / portTICK_PERIOD_MS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sim_time_set_ms(sim_time_ms() + ticks * portTICK_PERIOD_MS);
+}
+
+/* nothing runs on the stacks, a static task reports all of it free */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return task ? ((StaticTask_t *)task)->stack_depth : 0;
+}
+
+/* a fixed heap: the numbers only show up in reports */
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return SIM_HEAP_SIZE;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    (void)caps;
+    return SIM_HEAP_SIZE;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void)caps;
+    return SIM_HEAP_SIZE;
+}
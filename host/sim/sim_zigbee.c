@@ -0,0 +1,783 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation of the esp-zigbee-lib pieces the light uses: the
+ * endpoint/cluster/attribute data model, the action handler, signals and
+ * the scheduler alarms. There is no network; sim_zigbee_ota_serve() stands
+ * in for an OTA Upgrade server.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_zigbee_core.h"
+#include "ha/esp_zigbee_ha_standard.h"
+#include "sim.h"
+
+static const char *TAG = "SIM_ZIGBEE";
+
+#define SIM_ATTR_MAX        48
+#define SIM_CLUSTER_MAX     12
+#define SIM_EP_MAX          16
+#define SIM_ATTR_STORAGE    64
+#define SIM_ALARM_MAX       32
+
+typedef struct {
+    esp_zb_zcl_attr_t zcl;
+    uint8_t storage[SIM_ATTR_STORAGE];
+} sim_attr_t;
+
+struct esp_zb_attribute_list_s {
+    uint16_t cluster_id;
+    uint8_t role;
+    uint8_t count;
+    sim_attr_t attrs[SIM_ATTR_MAX];
+};
+
+struct esp_zb_cluster_list_s {
+    uint8_t count;
+    esp_zb_attribute_list_t *clusters[SIM_CLUSTER_MAX];
+};
+
+struct esp_zb_ep_list_s {
+    uint8_t count;
+    uint8_t endpoints[SIM_EP_MAX];
+    esp_zb_cluster_list_t *clusters[SIM_EP_MAX];
+};
+
+typedef struct {
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    esp_zb_zcl_attr_type_t type;
+} sim_attr_desc_t;
+
+/* types of the attributes the application may add or write */
+static const sim_attr_desc_t s_attr_desc[] = {
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID, ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING },
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID, ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING },
+    { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL },
+    { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_GLOBAL_SCENE_CONTROL, ESP_ZB_ZCL_ATTR_TYPE_BOOL },
+    { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_TIME, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_START_UP_ON_OFF, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_START_UP_CURRENT_LEVEL_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_HUE_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_CURRENT_HUE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_ACTIVE_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_DIRECTION_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_START_ENHANCED_HUE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_CAPABILITIES_ID, ESP_ZB_ZCL_ATTR_TYPE_16BITMAP },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMP_PHYSICAL_MIN_MIREDS_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMP_PHYSICAL_MAX_MIREDS_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID, ESP_ZB_ZCL_ATTR_TYPE_U32 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_VERSION_ID, ESP_ZB_ZCL_ATTR_TYPE_U32 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_ID, ESP_ZB_ZCL_ATTR_TYPE_U32 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STATUS_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MIN_BLOCK_REQUE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+};
+
+typedef struct {
+    esp_zb_callback_t cb;
+    uint8_t param;
+    uint32_t due_ms;
+    uint32_t seq;
+} sim_alarm_t;
+
+static esp_zb_ep_list_t *s_device;
+static esp_zb_core_action_callback_t s_action_handler;
+static esp_zb_identify_notify_callback_t s_identify_handlers[SIM_EP_MAX];
+static uint8_t s_identify_endpoints[SIM_EP_MAX];
+static unsigned s_identify_count;
+static sim_alarm_t s_alarms[SIM_ALARM_MAX];
+static unsigned s_alarm_count;
+static uint32_t s_alarm_seq;
+
+static struct {
+    uint32_t signal;
+    uint8_t params[16];
+} s_signal;
+
+/* not an attribute, the stack keeps it aside */
+static esp_zb_zcl_ota_upgrade_client_variable_t s_ota_client;
+
+/* ---- data model ---- */
+
+static size_t sim_attr_size(esp_zb_zcl_attr_type_t type, const void *value)
+{
+    switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_BOOL:
+    case ESP_ZB_ZCL_ATTR_TYPE_8BITMAP:
+    case ESP_ZB_ZCL_ATTR_TYPE_U8:
+    case ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM:
+        return 1;
+    case ESP_ZB_ZCL_ATTR_TYPE_16BITMAP:
+    case ESP_ZB_ZCL_ATTR_TYPE_U16:
+        return 2;
+    case ESP_ZB_ZCL_ATTR_TYPE_U32:
+        return 4;
+    case ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING:
+        /* length prefixed */
+        return value ? 1 + *(const uint8_t *)value : 0;
+    default:
+        return 0;
+    }
+}
+
+static const sim_attr_desc_t *sim_attr_find_desc(uint16_t cluster_id, uint16_t attr_id)
+{
+    for (size_t i = 0; i < sizeof(s_attr_desc) / sizeof(s_attr_desc[0]); i++) {
+        if (s_attr_desc[i].cluster_id == cluster_id && s_attr_desc[i].attr_id == attr_id) {
+            return &s_attr_desc[i];
+        }
+    }
+    return NULL;
+}
+
+static sim_attr_t *sim_attr_find(esp_zb_attribute_list_t *attr_list, uint16_t attr_id)
+{
+    for (uint8_t i = 0; i < attr_list->count; i++) {
+        if (attr_list->attrs[i].zcl.id == attr_id) {
+            return &attr_list->attrs[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t sim_attr_add_typed(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, esp_zb_zcl_attr_type_t type, uint8_t access,
+                                    const void *value_p)
+{
+    ESP_RETURN_ON_FALSE(attr_list && value_p, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(!sim_attr_find(attr_list, attr_id), ESP_ERR_INVALID_ARG, TAG, "attribute 0x%04x already added", attr_id);
+    ESP_RETURN_ON_FALSE(attr_list->count < SIM_ATTR_MAX, ESP_ERR_NO_MEM, TAG, "too many attributes");
+    size_t size = sim_attr_size(type, value_p);
+    ESP_RETURN_ON_FALSE(size > 0 && size <= SIM_ATTR_STORAGE, ESP_ERR_INVALID_SIZE, TAG, "attribute 0x%04x has unsupported size", attr_id);
+    sim_attr_t *attr = &attr_list->attrs[attr_list->count++];
+    attr->zcl.id = attr_id;
+    attr->zcl.type = type;
+    attr->zcl.access = access;
+    attr->zcl.data_p = attr->storage;
+    memcpy(attr->storage, value_p, size);
+    return ESP_OK;
+}
+
+static esp_err_t sim_attr_add(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, const void *value_p)
+{
+    ESP_RETURN_ON_FALSE(attr_list, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    const sim_attr_desc_t *desc = sim_attr_find_desc(attr_list->cluster_id, attr_id);
+    ESP_RETURN_ON_FALSE(desc, ESP_ERR_NOT_SUPPORTED, TAG, "attribute 0x%04x of cluster 0x%04x not simulated", attr_id,
+                        attr_list->cluster_id);
+    return sim_attr_add_typed(attr_list, attr_id, desc->type, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, value_p);
+}
+
+static esp_zb_attribute_list_t *sim_cluster_create(esp_zb_cluster_list_t *cluster_list, uint16_t cluster_id)
+{
+    esp_zb_attribute_list_t *attr_list = calloc(1, sizeof(*attr_list));
+    if (!attr_list || cluster_list->count >= SIM_CLUSTER_MAX) {
+        free(attr_list);
+        return NULL;
+    }
+    attr_list->cluster_id = cluster_id;
+    attr_list->role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE;
+    cluster_list->clusters[cluster_list->count++] = attr_list;
+    return attr_list;
+}
+
+esp_zb_cluster_list_t *esp_zb_color_dimmable_light_clusters_create(esp_zb_color_dimmable_light_cfg_t *light_cfg)
+{
+    esp_zb_cluster_list_t *cluster_list = calloc(1, sizeof(*cluster_list));
+    if (!cluster_list) {
+        return NULL;
+    }
+    sim_cluster_create(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_BASIC);
+    sim_cluster_create(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY);
+    sim_cluster_create(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_GROUPS);
+    sim_cluster_create(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_SCENES);
+    esp_zb_attribute_list_t *on_off = sim_cluster_create(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF);
+    sim_attr_add(on_off, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, &light_cfg->on_off_cfg.on_off);
+    esp_zb_attribute_list_t *level = sim_cluster_create(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL);
+    sim_attr_add(level, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, &light_cfg->level_cfg.current_level);
+    esp_zb_attribute_list_t *color = sim_cluster_create(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL);
+    sim_attr_add(color, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, &light_cfg->color_cfg.current_x);
+    sim_attr_add(color, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, &light_cfg->color_cfg.current_y);
+    sim_attr_add(color, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, &light_cfg->color_cfg.color_mode);
+    sim_attr_add(color, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_CAPABILITIES_ID, &light_cfg->color_cfg.color_capabilities);
+    return cluster_list;
+}
+
+esp_zb_ep_list_t *esp_zb_ep_list_create(void)
+{
+    return calloc(1, sizeof(esp_zb_ep_list_t));
+}
+
+esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list, esp_zb_endpoint_config_t endpoint_config)
+{
+    ESP_RETURN_ON_FALSE(ep_list && cluster_list, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(ep_list->count < SIM_EP_MAX, ESP_ERR_NO_MEM, TAG, "too many endpoints");
+    ESP_RETURN_ON_FALSE(!esp_zb_ep_list_get_ep(ep_list, endpoint_config.endpoint), ESP_ERR_INVALID_ARG, TAG,
+                        "endpoint %d already added", endpoint_config.endpoint);
+    ep_list->endpoints[ep_list->count] = endpoint_config.endpoint;
+    ep_list->clusters[ep_list->count] = cluster_list;
+    ep_list->count++;
+    return ESP_OK;
+}
+
+esp_zb_cluster_list_t *esp_zb_ep_list_get_ep(const esp_zb_ep_list_t *ep_list, uint8_t ep_id)
+{
+    for (uint8_t i = 0; ep_list && i < ep_list->count; i++) {
+        if (ep_list->endpoints[i] == ep_id) {
+            return ep_list->clusters[i];
+        }
+    }
+    return NULL;
+}
+
+esp_zb_attribute_list_t *esp_zb_cluster_list_get_cluster(const esp_zb_cluster_list_t *cluster_list, uint16_t cluster_id, uint8_t role_mask)
+{
+    for (uint8_t i = 0; cluster_list && i < cluster_list->count; i++) {
+        if (cluster_list->clusters[i]->cluster_id == cluster_id && (cluster_list->clusters[i]->role & role_mask)) {
+            return cluster_list->clusters[i];
+        }
+    }
+    return NULL;
+}
+
+esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id)
+{
+    esp_zb_attribute_list_t *attr_list = calloc(1, sizeof(*attr_list));
+    if (attr_list) {
+        attr_list->cluster_id = cluster_id;
+    }
+    return attr_list;
+}
+
+esp_err_t esp_zb_custom_cluster_add_custom_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, uint8_t attr_type, uint8_t attr_access,
+                                                void *value_p)
+{
+    return sim_attr_add_typed(attr_list, attr_id, (esp_zb_zcl_attr_type_t)attr_type, attr_access, value_p);
+}
+
+esp_err_t esp_zb_cluster_list_add_custom_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    ESP_RETURN_ON_FALSE(cluster_list && attr_list, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(cluster_list->count < SIM_CLUSTER_MAX, ESP_ERR_NO_MEM, TAG, "too many clusters");
+    attr_list->role = role_mask;
+    cluster_list->clusters[cluster_list->count++] = attr_list;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_basic_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    return sim_attr_add(attr_list, attr_id, value_p);
+}
+
+esp_err_t esp_zb_on_off_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    return sim_attr_add(attr_list, attr_id, value_p);
+}
+
+esp_err_t esp_zb_level_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    return sim_attr_add(attr_list, attr_id, value_p);
+}
+
+esp_err_t esp_zb_color_control_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    return sim_attr_add(attr_list, attr_id, value_p);
+}
+
+esp_zb_attribute_list_t *esp_zb_ota_cluster_create(esp_zb_ota_cluster_cfg_t *ota_cfg)
+{
+    esp_zb_attribute_list_t *attr_list = ota_cfg ? esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE) : NULL;
+    if (!attr_list) {
+        return NULL;
+    }
+    sim_attr_add(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_VERSION_ID, &ota_cfg->ota_upgrade_file_version);
+    sim_attr_add(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID, &ota_cfg->ota_upgrade_manufacturer);
+    sim_attr_add(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID, &ota_cfg->ota_upgrade_image_type);
+    sim_attr_add(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MIN_BLOCK_REQUE_ID, &ota_cfg->ota_min_block_reque);
+    sim_attr_add(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID, &ota_cfg->ota_upgrade_file_offset);
+    sim_attr_add(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_ID, &ota_cfg->ota_upgrade_downloaded_file_ver);
+    sim_attr_add(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STATUS_ID, &ota_cfg->ota_image_upgrade_status);
+    return attr_list;
+}
+
+esp_err_t esp_zb_ota_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    if (attr_id == ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID) {
+        ESP_RETURN_ON_FALSE(attr_list && value_p, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+        memcpy(&s_ota_client, value_p, sizeof(s_ota_client));
+        return ESP_OK;
+    }
+    return sim_attr_add(attr_list, attr_id, value_p);
+}
+
+esp_err_t esp_zb_cluster_list_add_ota_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return esp_zb_cluster_list_add_custom_cluster(cluster_list, attr_list, role_mask);
+}
+
+esp_zb_zcl_attr_t *esp_zb_zcl_get_attribute(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id)
+{
+    esp_zb_attribute_list_t *attr_list = esp_zb_cluster_list_get_cluster(esp_zb_ep_list_get_ep(s_device, endpoint), cluster_id, cluster_role);
+    sim_attr_t *attr = attr_list ? sim_attr_find(attr_list, attr_id) : NULL;
+    return attr ? &attr->zcl : NULL;
+}
+
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id,
+                                                 void *value_p, bool check)
+{
+    (void)check;
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(endpoint, cluster_id, cluster_role, attr_id);
+    size_t size = attr ? sim_attr_size(attr->type, value_p) : 0;
+    if (!attr || !size || size > SIM_ATTR_STORAGE) {
+        return ESP_ZB_ZCL_STATUS_FAIL;
+    }
+    memcpy(attr->data_p, value_p, size);
+    return ESP_ZB_ZCL_STATUS_SUCCESS;
+}
+
+/* the stack's reporting engine is not simulated; configurations are only checked */
+esp_err_t esp_zb_zcl_update_reporting_info(esp_zb_zcl_reporting_info_t *config)
+{
+    ESP_RETURN_ON_FALSE(config && config->direction == ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(esp_zb_zcl_get_attribute(config->ep, config->cluster_id, config->cluster_role, config->attr_id), ESP_ERR_NOT_FOUND,
+                        TAG, "no attribute 0x%04x in cluster 0x%04x of endpoint %u", config->attr_id, config->cluster_id, config->ep);
+    ESP_RETURN_ON_FALSE(config->u.send_info.min_interval <= config->u.send_info.max_interval, ESP_ERR_INVALID_ARG, TAG,
+                        "minimum interval above the maximum");
+    return ESP_OK;
+}
+
+/* ---- stack ---- */
+
+void esp_zb_init(esp_zb_cfg_t *nwk_cfg)
+{
+    (void)nwk_cfg;
+}
+
+esp_err_t esp_zb_platform_config(esp_zb_platform_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list)
+{
+    s_device = ep_list;
+    return ESP_OK;
+}
+
+void esp_zb_core_action_handler_register(esp_zb_core_action_callback_t cb)
+{
+    s_action_handler = cb;
+}
+
+void esp_zb_identify_notify_handler_register(uint8_t endpoint, esp_zb_identify_notify_callback_t cb)
+{
+    for (unsigned i = 0; i < s_identify_count; i++) {
+        if (s_identify_endpoints[i] == endpoint) {
+            s_identify_handlers[i] = cb;
+            return;
+        }
+    }
+    if (s_identify_count < SIM_EP_MAX) {
+        s_identify_endpoints[s_identify_count] = endpoint;
+        s_identify_handlers[s_identify_count++] = cb;
+    }
+}
+
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask)
+{
+    (void)channel_mask;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_set_secondary_network_channel_set(uint32_t channel_mask)
+{
+    (void)channel_mask;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_start(bool autostart)
+{
+    (void)autostart;
+    return ESP_OK;
+}
+
+/* the simulation drives the stack from the outside, see sim.h */
+void esp_zb_stack_main_loop(void)
+{
+}
+
+void esp_zb_enable_joining_to_distributed(bool enable)
+{
+    (void)enable;
+}
+
+void esp_zb_secur_TC_standard_distributed_key_set(uint8_t *key)
+{
+    (void)key;
+}
+
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask)
+{
+    ESP_LOGI(TAG, "commissioning mode 0x%x", mode_mask);
+    return ESP_OK;
+}
+
+/* behave like a light that is already on a network */
+bool esp_zb_bdb_is_factory_new(void)
+{
+    return false;
+}
+
+void esp_zb_nvram_erase_at_start(bool erase)
+{
+    (void)erase;
+}
+
+void esp_zb_get_extended_pan_id(esp_zb_ieee_addr_t ext_pan_id)
+{
+    memset(ext_pan_id, 0, sizeof(esp_zb_ieee_addr_t));
+}
+
+uint16_t esp_zb_get_pan_id(void)
+{
+    return 0x1a62;
+}
+
+uint8_t esp_zb_get_current_channel(void)
+{
+    return 11;
+}
+
+uint16_t esp_zb_get_short_address(void)
+{
+    return 0x0001;
+}
+
+void *esp_zb_app_signal_get_params(uint32_t *signal_p)
+{
+    (void)signal_p;
+    return s_signal.params;
+}
+
+const char *esp_zb_zdo_signal_to_string(esp_zb_app_signal_type_t signal)
+{
+    (void)signal;
+    return "SIM_SIGNAL";
+}
+
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time)
+{
+    if (s_alarm_count >= SIM_ALARM_MAX) {
+        fprintf(stderr, "sim: scheduler alarm table full\n");
+        abort();
+    }
+    s_alarms[s_alarm_count++] = (sim_alarm_t) {
+        .cb = cb,
+        .param = param,
+        .due_ms = sim_time_ms() + time,
+        .seq = s_alarm_seq++,
+    };
+}
+
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param)
+{
+    for (unsigned i = 0; i < s_alarm_count;) {
+        if (s_alarms[i].cb == cb && s_alarms[i].param == param) {
+            s_alarms[i] = s_alarms[--s_alarm_count];
+        } else {
+            i++;
+        }
+    }
+}
+
+/* ---- simulation control ---- */
+
+bool sim_zigbee_next_alarm(uint32_t *due_ms)
+{
+    if (!s_alarm_count) {
+        return false;
+    }
+    uint32_t now_ms = sim_time_ms();
+    uint32_t first = s_alarms[0].due_ms;
+    for (unsigned i = 1; i < s_alarm_count; i++) {
+        if ((int32_t)(s_alarms[i].due_ms - first) < 0) {
+            first = s_alarms[i].due_ms;
+        }
+    }
+    /* overdue alarms run now */
+    *due_ms = (int32_t)(first - now_ms) < 0 ? now_ms : first;
+    return true;
+}
+
+unsigned sim_zigbee_run_alarms(void)
+{
+    unsigned run = 0;
+    while (true) {
+        int next = -1;
+        uint32_t now_ms = sim_time_ms();
+        for (unsigned i = 0; i < s_alarm_count; i++) {
+            if ((int32_t)(now_ms - s_alarms[i].due_ms) < 0) {
+                continue;
+            }
+            if (next < 0 || (int32_t)(s_alarms[i].due_ms - s_alarms[next].due_ms) < 0 ||
+                    (s_alarms[i].due_ms == s_alarms[next].due_ms && s_alarms[i].seq < s_alarms[next].seq)) {
+                next = i;
+            }
+        }
+        if (next < 0) {
+            return run;
+        }
+        sim_alarm_t alarm = s_alarms[next];
+        s_alarms[next] = s_alarms[--s_alarm_count];
+        alarm.cb(alarm.param);
+        run++;
+    }
+}
+
+esp_err_t sim_zigbee_write_attr(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, esp_zb_zcl_attr_type_t type, uint32_t value)
+{
+    union {
+        bool b;
+        uint8_t u8;
+        uint16_t u16;
+        uint32_t u32;
+    } data;
+    size_t size = sim_attr_size(type, NULL);
+    ESP_RETURN_ON_FALSE(size > 0 && size <= sizeof(data), ESP_ERR_NOT_SUPPORTED, TAG, "attribute type 0x%02x not simulated", type);
+    switch (size) {
+    case 1:
+        data.u8 = (uint8_t)value;
+        break;
+    case 2:
+        data.u16 = (uint16_t)value;
+        break;
+    default:
+        data.u32 = value;
+        break;
+    }
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(endpoint, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id);
+    ESP_RETURN_ON_FALSE(attr, ESP_ERR_NOT_FOUND, TAG, "unsupported attribute 0x%04x on %d/0x%04x", attr_id, endpoint, cluster_id);
+    ESP_RETURN_ON_FALSE(attr->type == type, ESP_ERR_INVALID_ARG, TAG, "attribute 0x%04x has type 0x%02x, not 0x%02x", attr_id, attr->type,
+                        type);
+    memcpy(attr->data_p, &data, size);
+    ESP_RETURN_ON_FALSE(s_action_handler, ESP_ERR_INVALID_STATE, TAG, "no action handler registered");
+    esp_zb_zcl_set_attr_value_message_t message = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .dst_endpoint = endpoint,
+            .cluster = cluster_id,
+        },
+        .attribute = {
+            .id = attr_id,
+            .data = {
+                .type = type,
+                .size = size,
+                .value = attr->data_p,
+            },
+        },
+    };
+    return s_action_handler(ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID, &message);
+}
+
+esp_err_t sim_zigbee_custom_cmd(uint8_t endpoint, uint16_t cluster_id, uint8_t cmd_id, const void *data, uint16_t size)
+{
+    ESP_RETURN_ON_FALSE(esp_zb_cluster_list_get_cluster(esp_zb_ep_list_get_ep(s_device, endpoint), cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE),
+                        ESP_ERR_NOT_FOUND, TAG, "no cluster 0x%04x on endpoint %d", cluster_id, endpoint);
+    ESP_RETURN_ON_FALSE(s_action_handler, ESP_ERR_INVALID_STATE, TAG, "no action handler registered");
+    esp_zb_zcl_custom_cluster_command_message_t message = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .dst_endpoint = endpoint,
+            .cluster = cluster_id,
+            .command = {
+                .id = cmd_id,
+            },
+        },
+        .data = {
+            .size = size,
+            .value = (void *)data,
+        },
+    };
+    return s_action_handler(ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID, &message);
+}
+
+esp_err_t sim_zigbee_identify(uint8_t endpoint, bool identify_on)
+{
+    for (unsigned i = 0; i < s_identify_count; i++) {
+        if (s_identify_endpoints[i] == endpoint && s_identify_handlers[i]) {
+            s_identify_handlers[i](identify_on);
+            return ESP_OK;
+        }
+    }
+    ESP_LOGW(TAG, "no identify handler on endpoint %d", endpoint);
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t sim_zigbee_trigger_effect(uint8_t endpoint, uint8_t effect_id, uint8_t effect_variant)
+{
+    ESP_RETURN_ON_FALSE(s_action_handler, ESP_ERR_INVALID_STATE, TAG, "no action handler registered");
+    esp_zb_zcl_identify_effect_message_t message = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .dst_endpoint = endpoint,
+            .cluster = ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY,
+        },
+        .effect_id = effect_id,
+        .effect_variant = effect_variant,
+    };
+    return s_action_handler(ESP_ZB_CORE_IDENTIFY_EFFECT_CB_ID, &message);
+}
+
+esp_err_t sim_zigbee_store_scene(uint8_t endpoint, uint16_t group_id, uint8_t scene_id)
+{
+    ESP_RETURN_ON_FALSE(esp_zb_cluster_list_get_cluster(esp_zb_ep_list_get_ep(s_device, endpoint), ESP_ZB_ZCL_CLUSTER_ID_SCENES,
+                                                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE),
+                        ESP_ERR_NOT_FOUND, TAG, "no scenes cluster on endpoint %d", endpoint);
+    ESP_RETURN_ON_FALSE(s_action_handler, ESP_ERR_INVALID_STATE, TAG, "no action handler registered");
+    esp_zb_zcl_store_scene_message_t message = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .dst_endpoint = endpoint,
+            .cluster = ESP_ZB_ZCL_CLUSTER_ID_SCENES,
+        },
+        .group_id = group_id,
+        .scene_id = scene_id,
+    };
+    return s_action_handler(ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID, &message);
+}
+
+esp_err_t sim_zigbee_recall_scene(uint8_t endpoint, uint16_t group_id, uint8_t scene_id, uint16_t transition_time,
+                                  esp_zb_zcl_scenes_extension_field_t *field_set)
+{
+    ESP_RETURN_ON_FALSE(esp_zb_cluster_list_get_cluster(esp_zb_ep_list_get_ep(s_device, endpoint), ESP_ZB_ZCL_CLUSTER_ID_SCENES,
+                                                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE),
+                        ESP_ERR_NOT_FOUND, TAG, "no scenes cluster on endpoint %d", endpoint);
+    ESP_RETURN_ON_FALSE(s_action_handler, ESP_ERR_INVALID_STATE, TAG, "no action handler registered");
+    esp_zb_zcl_recall_scene_message_t message = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .dst_endpoint = endpoint,
+            .cluster = ESP_ZB_ZCL_CLUSTER_ID_SCENES,
+        },
+        .group_id = group_id,
+        .scene_id = scene_id,
+        .transition_time = transition_time,
+        .field_set = field_set,
+    };
+    return s_action_handler(ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID, &message);
+}
+
+static uint32_t sim_ota_attr(uint8_t endpoint, uint16_t attr_id)
+{
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(endpoint, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE, attr_id);
+    size_t size = attr ? sim_attr_size(attr->type, NULL) : 0;
+    uint32_t value = 0;
+    /* little endian host */
+    memcpy(&value, attr ? attr->data_p : &value, size);
+    return value;
+}
+
+static esp_err_t sim_ota_notify(uint8_t endpoint, esp_zb_zcl_ota_upgrade_status_t status, const esp_zb_zcl_ota_upgrade_file_header_t *header,
+                                const uint8_t *payload, uint16_t payload_size)
+{
+    esp_zb_zcl_ota_upgrade_value_message_t message = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .dst_endpoint = endpoint,
+            .cluster = ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+        },
+        .upgrade_status = status,
+        .ota_header = *header,
+        .payload_size = payload_size,
+        .payload = (uint8_t *)payload,
+    };
+    return s_action_handler(ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID, &message);
+}
+
+esp_err_t sim_zigbee_ota_serve(uint8_t endpoint, const uint8_t *file, uint32_t size, const sim_ota_server_t *server)
+{
+    ESP_RETURN_ON_FALSE(esp_zb_cluster_list_get_cluster(esp_zb_ep_list_get_ep(s_device, endpoint), ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+                                                        ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE),
+                        ESP_ERR_NOT_FOUND, TAG, "no OTA client on endpoint %d", endpoint);
+    ESP_RETURN_ON_FALSE(s_action_handler, ESP_ERR_INVALID_STATE, TAG, "no action handler registered");
+    ESP_RETURN_ON_FALSE(file && size >= 56 && file[0] == 0x1e && file[1] == 0xf1 && file[2] == 0xee && file[3] == 0x0b,
+                        ESP_ERR_INVALID_ARG, TAG, "not an upgrade file");
+    uint16_t header_size = file[6] | file[7] << 8;
+    uint32_t total = file[52] | file[53] << 8 | file[54] << 16 | (uint32_t)file[55] << 24;
+    ESP_RETURN_ON_FALSE(header_size >= 56 && header_size <= total && total == size, ESP_ERR_INVALID_SIZE, TAG, "bad upgrade file header");
+    esp_zb_zcl_ota_upgrade_file_header_t header = {
+        .manufacturer_code = file[10] | file[11] << 8,
+        .image_type = file[12] | file[13] << 8,
+        .file_version = file[14] | file[15] << 8 | file[16] << 16 | (uint32_t)file[17] << 24,
+        .image_size = total - header_size,
+    };
+
+    /* QueryNextImage: only a newer file for this device */
+    if (header.manufacturer_code != sim_ota_attr(endpoint, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID) ||
+            header.image_type != sim_ota_attr(endpoint, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID) ||
+            header.file_version <= sim_ota_attr(endpoint, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_VERSION_ID)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    /* continue where the client says a download of this file stopped */
+    uint32_t offset = sim_ota_attr(endpoint, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID);
+    if (sim_ota_attr(endpoint, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_ID) != header.file_version || offset < header_size ||
+            offset > total) {
+        offset = header_size;
+    }
+    ESP_RETURN_ON_ERROR(sim_ota_notify(endpoint, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START, &header, NULL, 0), TAG, "download refused");
+
+    uint32_t block_max = s_ota_client.max_data_size ? s_ota_client.max_data_size : 64;
+    if (server->block_max && server->block_max < block_max) {
+        block_max = server->block_max;
+    }
+    /* the server honours MinimumBlockPeriod */
+    uint32_t period_us = sim_ota_attr(endpoint, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MIN_BLOCK_REQUE_ID) * 1000;
+    if (server->block_us > period_us) {
+        period_us = server->block_us;
+    }
+    while (offset < total) {
+        uint32_t block = total - offset < block_max ? total - offset : block_max;
+        sim_time_advance_us(period_us);
+        sim_zigbee_run_alarms();
+        if (server->cut_at && offset + block > server->cut_at) {
+            sim_ota_notify(endpoint, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT, &header, NULL, 0);
+            return ESP_ERR_TIMEOUT;
+        }
+        uint32_t next = offset + block;
+        esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE,
+                                     ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID, &next, false);
+        esp_err_t err = sim_ota_notify(endpoint, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE, &header, file + offset, block);
+        ESP_RETURN_ON_ERROR(err, TAG, "block at %lu refused", (unsigned long)offset);
+        offset = next;
+    }
+    ESP_RETURN_ON_ERROR(sim_ota_notify(endpoint, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK, &header, NULL, 0), TAG, "image refused");
+    ESP_RETURN_ON_ERROR(sim_ota_notify(endpoint, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY, &header, NULL, 0), TAG, "apply refused");
+    return sim_ota_notify(endpoint, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH, &header, NULL, 0);
+}
+
+void sim_zigbee_signal(esp_zb_app_signal_type_t type, esp_err_t status)
+{
+    memset(&s_signal, 0, sizeof(s_signal));
+    s_signal.signal = type;
+    esp_zb_app_signal_t signal = {
+        .p_app_signal = &s_signal.signal,
+        .esp_err_status = status,
+    };
+    esp_zb_app_signal_handler(&signal);
+}
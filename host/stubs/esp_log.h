@@ -0,0 +1,24 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation stub of esp_log.h, logs go to stderr when enabled
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+extern int sim_log_enabled;
+
+uint32_t esp_log_timestamp(void);
+
+/* arguments are always evaluated, as on target where the level check
+ * happens at run time */
+void sim_log_write(char level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, format, ...) sim_log_write('E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) sim_log_write('W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) sim_log_write('I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) sim_log_write('D', tag, format, ##__VA_ARGS__)
@@ -0,0 +1,13 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation stub of esp_random.h
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+uint32_t esp_random(void);
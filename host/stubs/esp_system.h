@@ -0,0 +1,12 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation stub of esp_system.h
+ */
+
+#pragma once
+
+/** Counted by the simulation and returns, see sim_restart_count() */
+void esp_restart(void);
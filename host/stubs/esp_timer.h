@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation stub of esp_timer.h, driven by the virtual clock
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/** Virtual time in microseconds, advanced by the simulation */
+int64_t esp_timer_get_time(void);
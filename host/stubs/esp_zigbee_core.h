@@ -0,0 +1,449 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation stub of the esp-zigbee-lib API used by the light.
+ * Only the names and layouts the application touches are reproduced; the
+ * behavior lives in sim/sim_zigbee.c.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ---- stack configuration ---- */
+
+typedef enum {
+    ESP_ZB_DEVICE_TYPE_COORDINATOR = 0x0,
+    ESP_ZB_DEVICE_TYPE_ROUTER = 0x1,
+    ESP_ZB_DEVICE_TYPE_ED = 0x2,
+} esp_zb_nwk_device_type_t;
+
+typedef struct {
+    uint8_t max_children;
+} esp_zb_zczr_cfg_t;
+
+typedef struct {
+    uint8_t ed_timeout;
+    uint32_t keep_alive;
+} esp_zb_zed_cfg_t;
+
+typedef struct {
+    esp_zb_nwk_device_type_t esp_zb_role;
+    bool install_code_policy;
+    union {
+        esp_zb_zczr_cfg_t zczr_cfg;
+        esp_zb_zed_cfg_t zed_cfg;
+    } nwk_cfg;
+} esp_zb_cfg_t;
+
+typedef enum {
+    ZB_RADIO_MODE_NATIVE = 0x0,
+    ZB_RADIO_MODE_UART_RCP = 0x1,
+} esp_zb_radio_mode_t;
+
+typedef enum {
+    ZB_HOST_CONNECTION_MODE_NONE = 0x0,
+    ZB_HOST_CONNECTION_MODE_UART = 0x1,
+} esp_zb_host_connection_mode_t;
+
+typedef struct {
+    esp_zb_radio_mode_t radio_mode;
+} esp_zb_radio_config_t;
+
+typedef struct {
+    esp_zb_host_connection_mode_t host_connection_mode;
+} esp_zb_host_config_t;
+
+typedef struct {
+    esp_zb_radio_config_t radio_config;
+    esp_zb_host_config_t host_config;
+} esp_zb_platform_config_t;
+
+#define ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK 0x07FFF800U
+
+typedef uint8_t esp_zb_ieee_addr_t[8];
+typedef void (*esp_zb_callback_t)(uint8_t param);
+
+/* ---- signals ---- */
+
+typedef enum {
+    ESP_ZB_ZDO_SIGNAL_DEFAULT_START = 0x00,
+    ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP = 0x01,
+    ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE = 0x02,
+    ESP_ZB_ZDO_SIGNAL_LEAVE = 0x03,
+    ESP_ZB_ZDO_SIGNAL_ERROR = 0x04,
+    ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START = 0x05,
+    ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT = 0x06,
+    ESP_ZB_BDB_SIGNAL_STEERING = 0x0A,
+    ESP_ZB_BDB_SIGNAL_FORMATION = 0x0B,
+    ESP_ZB_NWK_SIGNAL_PERMIT_JOIN_STATUS = 0x36,
+} esp_zb_app_signal_type_t;
+
+typedef struct {
+    uint32_t *p_app_signal;
+    esp_err_t esp_err_status;
+} esp_zb_app_signal_t;
+
+typedef enum {
+    ESP_ZB_NWK_LEAVE_TYPE_RESET = 0x00,
+    ESP_ZB_NWK_LEAVE_TYPE_REJOIN = 0x01,
+} esp_zb_nwk_leave_type_t;
+
+typedef struct {
+    uint8_t leave_type;
+} esp_zb_zdo_signal_leave_params_t;
+
+typedef enum {
+    ESP_ZB_BDB_MODE_INITIALIZATION = 0,
+    ESP_ZB_BDB_MODE_TOUCHLINK_COMMISSIONING = 1,
+    ESP_ZB_BDB_MODE_NETWORK_STEERING = 2,
+    ESP_ZB_BDB_MODE_NETWORK_FORMATION = 4,
+} esp_zb_bdb_commissioning_mode_mask_t;
+
+/* ---- ZCL ---- */
+
+typedef enum {
+    ESP_ZB_ZCL_CLUSTER_ID_BASIC = 0x0000U,
+    ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY = 0x0003U,
+    ESP_ZB_ZCL_CLUSTER_ID_GROUPS = 0x0004U,
+    ESP_ZB_ZCL_CLUSTER_ID_SCENES = 0x0005U,
+    ESP_ZB_ZCL_CLUSTER_ID_ON_OFF = 0x0006U,
+    ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL = 0x0008U,
+    ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE = 0x0019U,
+    ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL = 0x0300U,
+} esp_zb_zcl_cluster_id_t;
+
+typedef enum {
+    ESP_ZB_ZCL_CLUSTER_SERVER_ROLE = 0x01U,
+    ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE = 0x02U,
+} esp_zb_zcl_cluster_role_t;
+
+typedef enum {
+    ESP_ZB_ZCL_ATTR_TYPE_NULL = 0x00U,
+    ESP_ZB_ZCL_ATTR_TYPE_BOOL = 0x10U,
+    ESP_ZB_ZCL_ATTR_TYPE_8BITMAP = 0x18U,
+    ESP_ZB_ZCL_ATTR_TYPE_16BITMAP = 0x19U,
+    ESP_ZB_ZCL_ATTR_TYPE_U8 = 0x20U,
+    ESP_ZB_ZCL_ATTR_TYPE_U16 = 0x21U,
+    ESP_ZB_ZCL_ATTR_TYPE_U32 = 0x23U,
+    ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM = 0x30U,
+    ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING = 0x42U,
+} esp_zb_zcl_attr_type_t;
+
+typedef enum {
+    ESP_ZB_ZCL_STATUS_SUCCESS = 0x00U,
+    ESP_ZB_ZCL_STATUS_FAIL = 0x01U,
+} esp_zb_zcl_status_t;
+
+enum {
+    ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID = 0x0004U,
+    ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID = 0x0005U,
+    ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID = 0x0000U,
+    ESP_ZB_ZCL_ATTR_ON_OFF_GLOBAL_SCENE_CONTROL = 0x4000U,
+    ESP_ZB_ZCL_ATTR_ON_OFF_ON_TIME = 0x4001U,
+    ESP_ZB_ZCL_ATTR_ON_OFF_START_UP_ON_OFF = 0x4003U,
+    ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID = 0x0000U,
+    ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID = 0x0010U,
+    ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_START_UP_CURRENT_LEVEL_ID = 0x4000U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_HUE_ID = 0x0000U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID = 0x0001U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID = 0x0003U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID = 0x0004U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID = 0x0007U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID = 0x0008U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_CURRENT_HUE_ID = 0x4000U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_ACTIVE_ID = 0x4002U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_DIRECTION_ID = 0x4003U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_TIME_ID = 0x4004U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_START_ENHANCED_HUE_ID = 0x4005U,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_CAPABILITIES_ID = 0x400AU,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMP_PHYSICAL_MIN_MIREDS_ID = 0x400BU,
+    ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMP_PHYSICAL_MAX_MIREDS_ID = 0x400CU,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID = 0x0001U,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_VERSION_ID = 0x0002U,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_ID = 0x0004U,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STATUS_ID = 0x0006U,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID = 0x0007U,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID = 0x0008U,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MIN_BLOCK_REQUE_ID = 0x0009U,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID = 0xfff1U,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID = 0xfff2U,
+    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID = 0xfff3U,
+};
+
+#define ESP_ZB_ZCL_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_DEF_VALUE 0xffffffffU
+
+#define ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_X_DEF_VALUE 0x616b
+#define ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_Y_DEF_VALUE 0x607d
+
+enum {
+    ESP_ZB_ZCL_ON_OFF_START_UP_ON_OFF_IS_OFF = 0x00,
+    ESP_ZB_ZCL_ON_OFF_START_UP_ON_OFF_IS_ON = 0x01,
+    ESP_ZB_ZCL_ON_OFF_START_UP_ON_OFF_IS_TOGGLE = 0x02,
+    ESP_ZB_ZCL_ON_OFF_START_UP_ON_OFF_IS_PREVIOUS = 0xff,
+};
+
+enum {
+    ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION = 0x00,
+    ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_CURRENT_X_Y = 0x01,
+    ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_TEMPERATURE = 0x02,
+};
+
+typedef enum {
+    ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY = 0x01U,
+    ESP_ZB_ZCL_ATTR_ACCESS_WRITE_ONLY = 0x02U,
+    ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE = 0x03U,
+    ESP_ZB_ZCL_ATTR_ACCESS_REPORTING = 0x04U,
+} esp_zb_zcl_attr_access_t;
+
+typedef struct {
+    uint16_t id;
+    uint8_t type;
+    uint8_t access;
+    uint16_t manuf_code;
+    void *data_p;
+} esp_zb_zcl_attr_t;
+
+typedef struct {
+    esp_zb_zcl_attr_type_t type;
+    uint16_t size;
+    void *value;
+} esp_zb_zcl_attribute_data_t;
+
+typedef struct {
+    uint16_t id;
+    esp_zb_zcl_attribute_data_t data;
+} esp_zb_zcl_attribute_t;
+
+typedef struct {
+    esp_zb_zcl_status_t status;
+    uint8_t dst_endpoint;
+    uint16_t cluster;
+} esp_zb_device_cb_common_info_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    esp_zb_zcl_attribute_t attribute;
+} esp_zb_zcl_set_attr_value_message_t;
+
+typedef struct {
+    uint8_t id;
+    uint8_t direction;
+    uint8_t is_common;
+} esp_zb_zcl_command_t;
+
+typedef struct {
+    esp_zb_zcl_status_t status;
+    uint8_t src_endpoint;
+    uint8_t dst_endpoint;
+    uint16_t cluster;
+    esp_zb_zcl_command_t command;
+} esp_zb_zcl_cmd_info_t;
+
+typedef struct {
+    esp_zb_zcl_cmd_info_t info;
+    struct {
+        uint16_t size;
+        void *value;
+    } data;
+} esp_zb_zcl_custom_cluster_command_message_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    uint8_t effect_id;
+    uint8_t effect_variant;
+} esp_zb_zcl_identify_effect_message_t;
+
+typedef struct esp_zb_zcl_scenes_extension_field_s {
+    uint16_t cluster_id;
+    uint8_t length;
+    uint8_t *extension_field_attribute_value_list;      /*!< Attribute values in the order of the cluster's scene table extension */
+    struct esp_zb_zcl_scenes_extension_field_s *next;
+} esp_zb_zcl_scenes_extension_field_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    uint16_t group_id;
+    uint8_t scene_id;
+} esp_zb_zcl_store_scene_message_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    uint16_t group_id;
+    uint8_t scene_id;
+    uint16_t transition_time;                           /*!< The scene's transition time as the stack holds it, tenths of a second */
+    esp_zb_zcl_scenes_extension_field_t *field_set;     /*!< What the stack holds for the scene, from Add Scene or Store Scene, NULL if nothing */
+} esp_zb_zcl_recall_scene_message_t;
+
+typedef enum {
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START = 0x0000,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY = 0x0001,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE = 0x0002,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH = 0x0003,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT = 0x0004,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK = 0x0005,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_OK = 0x0006,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR = 0x0007,
+} esp_zb_zcl_ota_upgrade_status_t;
+
+typedef struct {
+    uint16_t manufacturer_code;
+    uint16_t image_type;
+    uint32_t file_version;
+    uint32_t image_size;        /*!< Bytes after the upgrade file header, what the payloads add up to */
+} esp_zb_zcl_ota_upgrade_file_header_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    esp_zb_zcl_ota_upgrade_status_t upgrade_status;
+    esp_zb_zcl_ota_upgrade_file_header_t ota_header;
+    uint16_t payload_size;
+    uint8_t *payload;
+} esp_zb_zcl_ota_upgrade_value_message_t;
+
+typedef struct {
+    uint32_t ota_upgrade_file_version;
+    uint16_t ota_upgrade_manufacturer;
+    uint16_t ota_upgrade_image_type;
+    uint16_t ota_min_block_reque;
+    uint32_t ota_upgrade_file_offset;
+    uint32_t ota_upgrade_downloaded_file_ver;
+    esp_zb_ieee_addr_t ota_upgrade_server_id;
+    uint8_t ota_image_upgrade_status;
+} esp_zb_ota_cluster_cfg_t;
+
+typedef struct {
+    uint16_t timer_query;       /*!< Minutes between QueryNextImage requests */
+    uint16_t hw_version;
+    uint8_t max_data_size;      /*!< Largest block the client asks for */
+} esp_zb_zcl_ota_upgrade_client_variable_t;
+
+#define ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV               0x00U
+#define ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC     0xffffU
+
+typedef union {
+    uint8_t u8;
+    int8_t s8;
+    uint16_t u16;
+    int16_t s16;
+    uint32_t u32;
+    int32_t s32;
+} esp_zb_zcl_attr_var_t;
+
+typedef struct {
+    uint8_t direction;          /*!< ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV: reports this endpoint sends */
+    uint8_t ep;
+    uint16_t cluster_id;
+    uint8_t cluster_role;
+    uint16_t attr_id;
+    uint8_t flags;
+    uint64_t run_time;
+    union {
+        struct {
+            uint16_t min_interval;          /*!< Seconds between two reports at least */
+            uint16_t max_interval;          /*!< Seconds between two reports at most, 0xffff never */
+            esp_zb_zcl_attr_var_t delta;    /*!< Reportable change of analog attributes */
+            esp_zb_zcl_attr_var_t reported_value;
+            uint16_t def_min_interval;
+            uint16_t def_max_interval;
+        } send_info;
+        struct {
+            uint16_t timeout;
+        } recv_info;
+    } u;
+    struct {
+        uint16_t short_addr;
+        uint8_t endpoint;
+        uint16_t profile_id;
+    } dst;
+    uint16_t manuf_code;
+} esp_zb_zcl_reporting_info_t;
+
+typedef enum {
+    ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID = 0x0000,
+    ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID = 0x0001,
+    ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID = 0x0002,
+    ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID = 0x0004,
+    ESP_ZB_CORE_IDENTIFY_EFFECT_CB_ID = 0x0015,
+    ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID = 0x1041,
+} esp_zb_core_action_callback_id_t;
+
+typedef esp_err_t (*esp_zb_core_action_callback_t)(esp_zb_core_action_callback_id_t callback_id, const void *message);
+typedef void (*esp_zb_identify_notify_callback_t)(uint8_t identify_on);
+
+/* ---- data model ---- */
+
+typedef struct esp_zb_attribute_list_s esp_zb_attribute_list_t;
+typedef struct esp_zb_cluster_list_s esp_zb_cluster_list_t;
+typedef struct esp_zb_ep_list_s esp_zb_ep_list_t;
+
+#define ESP_ZB_AF_HA_PROFILE_ID 0x0104U
+#define ESP_ZB_HA_COLOR_DIMMABLE_LIGHT_DEVICE_ID 0x0102U
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t app_profile_id;
+    uint16_t app_device_id;
+    uint32_t app_device_version: 4;
+} esp_zb_endpoint_config_t;
+
+esp_zb_ep_list_t *esp_zb_ep_list_create(void);
+esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list, esp_zb_endpoint_config_t endpoint_config);
+esp_zb_cluster_list_t *esp_zb_ep_list_get_ep(const esp_zb_ep_list_t *ep_list, uint8_t ep_id);
+esp_zb_attribute_list_t *esp_zb_cluster_list_get_cluster(const esp_zb_cluster_list_t *cluster_list, uint16_t cluster_id, uint8_t role_mask);
+esp_err_t esp_zb_basic_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_on_off_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_level_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_color_control_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id);
+esp_err_t esp_zb_custom_cluster_add_custom_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, uint8_t attr_type, uint8_t attr_access,
+                                                void *value_p);
+esp_err_t esp_zb_cluster_list_add_custom_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+esp_zb_attribute_list_t *esp_zb_ota_cluster_create(esp_zb_ota_cluster_cfg_t *ota_cfg);
+esp_err_t esp_zb_ota_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_cluster_list_add_ota_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id,
+                                                 void *value_p, bool check);
+esp_zb_zcl_attr_t *esp_zb_zcl_get_attribute(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id);
+esp_err_t esp_zb_zcl_update_reporting_info(esp_zb_zcl_reporting_info_t *config);
+
+/* ---- stack ---- */
+
+void esp_zb_init(esp_zb_cfg_t *nwk_cfg);
+esp_err_t esp_zb_platform_config(esp_zb_platform_config_t *config);
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list);
+void esp_zb_core_action_handler_register(esp_zb_core_action_callback_t cb);
+void esp_zb_identify_notify_handler_register(uint8_t endpoint, esp_zb_identify_notify_callback_t cb);
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask);
+esp_err_t esp_zb_set_secondary_network_channel_set(uint32_t channel_mask);
+esp_err_t esp_zb_start(bool autostart);
+void esp_zb_stack_main_loop(void);
+void esp_zb_enable_joining_to_distributed(bool enable);
+void esp_zb_secur_TC_standard_distributed_key_set(uint8_t *key);
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask);
+bool esp_zb_bdb_is_factory_new(void);
+void esp_zb_nvram_erase_at_start(bool erase);
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time);
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param);
+void *esp_zb_app_signal_get_params(uint32_t *signal_p);
+const char *esp_zb_zdo_signal_to_string(esp_zb_app_signal_type_t signal);
+void esp_zb_get_extended_pan_id(esp_zb_ieee_addr_t ext_pan_id);
+uint16_t esp_zb_get_pan_id(void);
+uint8_t esp_zb_get_current_channel(void);
+uint16_t esp_zb_get_short_address(void);
+
+/** Implemented by the application */
+void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_s);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation stub of the HA standard device helpers
+ */
+
+#pragma once
+
+#include "esp_zigbee_core.h"
+
+typedef struct {
+    uint8_t zcl_version;
+    uint8_t power_source;
+} esp_zb_basic_cluster_cfg_t;
+
+typedef struct {
+    uint16_t identify_time;
+} esp_zb_identify_cluster_cfg_t;
+
+typedef struct {
+    uint8_t groups_name_support_id;
+} esp_zb_groups_cluster_cfg_t;
+
+typedef struct {
+    uint8_t scenes_count;
+    uint8_t current_scene;
+    uint16_t current_group;
+    bool scene_valid;
+    uint8_t name_support;
+} esp_zb_scenes_cluster_cfg_t;
+
+typedef struct {
+    bool on_off;
+} esp_zb_on_off_cluster_cfg_t;
+
+typedef struct {
+    uint8_t current_level;
+} esp_zb_level_cluster_cfg_t;
+
+typedef struct {
+    uint16_t current_x;
+    uint16_t current_y;
+    uint8_t color_mode;
+    uint8_t options;
+    uint8_t enhanced_color_mode;
+    uint16_t color_capabilities;
+} esp_zb_color_cluster_cfg_t;
+
+typedef struct {
+    esp_zb_basic_cluster_cfg_t basic_cfg;
+    esp_zb_identify_cluster_cfg_t identify_cfg;
+    esp_zb_groups_cluster_cfg_t groups_cfg;
+    esp_zb_scenes_cluster_cfg_t scenes_cfg;
+    esp_zb_on_off_cluster_cfg_t on_off_cfg;
+    esp_zb_level_cluster_cfg_t level_cfg;
+    esp_zb_color_cluster_cfg_t color_cfg;
+} esp_zb_color_dimmable_light_cfg_t;
+
+#define ESP_ZB_DEFAULT_COLOR_DIMMABLE_LIGHT_CONFIG()                                    \
+    {                                                                                   \
+        .basic_cfg = { .zcl_version = 8, .power_source = 0x01, },                       \
+        .identify_cfg = { .identify_time = 0, },                                        \
+        .groups_cfg = { .groups_name_support_id = 0, },                                 \
+        .scenes_cfg = { .scenes_count = 0, .current_scene = 0, .current_group = 0,      \
+                        .scene_valid = false, .name_support = 0, },                     \
+        .on_off_cfg = { .on_off = false, },                                             \
+        .level_cfg = { .current_level = 0xfe, },                                        \
+        .color_cfg = { .current_x = ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_X_DEF_VALUE,       \
+                       .current_y = ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_Y_DEF_VALUE,       \
+                       .color_mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_CURRENT_X_Y,   \
+                       .options = 0, .enhanced_color_mode = 1,                          \
+                       .color_capabilities = 0x0008, },                                 \
+    }
+
+esp_zb_cluster_list_t *esp_zb_color_dimmable_light_clusters_create(esp_zb_color_dimmable_light_cfg_t *light_cfg);
@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation stub of led_strip.h, pixels are kept in memory
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct led_strip_t *led_strip_handle_t;
+
+typedef struct {
+    int strip_gpio_num;
+    uint32_t max_leds;
+} led_strip_config_t;
+
+typedef struct {
+    uint32_t resolution_hz;
+    size_t mem_block_symbols;
+    struct {
+        uint32_t with_dma : 1;
+    } flags;
+} led_strip_rmt_config_t;
+
+typedef enum {
+    SPI_CLK_SRC_DEFAULT,
+} spi_clock_source_t;
+
+typedef enum {
+    SPI2_HOST = 1,
+} spi_host_device_t;
+
+typedef struct {
+    spi_clock_source_t clk_src;
+    spi_host_device_t spi_bus;
+    struct {
+        uint32_t with_dma : 1;
+    } flags;
+} led_strip_spi_config_t;
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                   led_strip_handle_t *ret_strip);
+esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config,
+                                   led_strip_handle_t *ret_strip);
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+esp_err_t led_strip_refresh(led_strip_handle_t strip);
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip);
+esp_err_t led_strip_refresh_wait_done(led_strip_handle_t strip);
+esp_err_t led_strip_clear(led_strip_handle_t strip);
+esp_err_t led_strip_del(led_strip_handle_t strip);
@@ -0,0 +1,142 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation configuration, stands in for the generated sdkconfig.h.
+ * Values can be overridden with -D on the compiler command line.
+ */
+
+#pragma once
+
+#define CONFIG_IDF_TARGET "esp32c6"
+#define CONFIG_ZB_ENABLED 1
+#define CONFIG_ZB_ZCZR 1
+
+#ifndef CONFIG_LIGHT_DRIVER_LED_GPIO
+#define CONFIG_LIGHT_DRIVER_LED_GPIO 8
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_LED_COUNT
+#define CONFIG_LIGHT_DRIVER_LED_COUNT 1
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_SEGMENTS
+#define CONFIG_LIGHT_DRIVER_SEGMENTS 1
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_STREAM
+#define CONFIG_LIGHT_DRIVER_STREAM 1
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_LED_RMT
+#define CONFIG_LIGHT_DRIVER_LED_RMT 1
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_LED_ASYNC
+#define CONFIG_LIGHT_DRIVER_LED_ASYNC 1
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_COLOR_LUT
+#define CONFIG_LIGHT_DRIVER_COLOR_LUT 1
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_XY_GRID_BITS
+#define CONFIG_LIGHT_DRIVER_XY_GRID_BITS 5
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_GAMMA
+#define CONFIG_LIGHT_DRIVER_GAMMA 22
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_POWER_BUDGET_MA
+#define CONFIG_LIGHT_DRIVER_POWER_BUDGET_MA 2000
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_POWER_RED_MA
+#define CONFIG_LIGHT_DRIVER_POWER_RED_MA 12
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_POWER_GREEN_MA
+#define CONFIG_LIGHT_DRIVER_POWER_GREEN_MA 12
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_POWER_BLUE_MA
+#define CONFIG_LIGHT_DRIVER_POWER_BLUE_MA 12
+#endif
+#ifndef CONFIG_LIGHT_DRIVER_POWER_IDLE_MA
+#define CONFIG_LIGHT_DRIVER_POWER_IDLE_MA 1
+#endif
+#ifndef CONFIG_LIGHT_BENCH_SAMPLES
+#define CONFIG_LIGHT_BENCH_SAMPLES 101
+#endif
+#ifndef CONFIG_LIGHT_BENCH_BATCH
+#define CONFIG_LIGHT_BENCH_BATCH 32
+#endif
+#ifndef CONFIG_LIGHT_STEP_SMOOTHING_MS
+#define CONFIG_LIGHT_STEP_SMOOTHING_MS 500
+#endif
+#ifndef CONFIG_LIGHT_TRACE
+#define CONFIG_LIGHT_TRACE 1
+#endif
+#ifndef CONFIG_LIGHT_TRACE_DEPTH
+#define CONFIG_LIGHT_TRACE_DEPTH 128
+#endif
+#ifndef CONFIG_LIGHT_STORE_DEBOUNCE_MS
+#define CONFIG_LIGHT_STORE_DEBOUNCE_MS 2000
+#endif
+#ifndef CONFIG_LIGHT_STORE_MAX_DELAY_MS
+#define CONFIG_LIGHT_STORE_MAX_DELAY_MS 10000
+#endif
+#ifndef CONFIG_LIGHT_COMMISSION_BACKOFF_MIN_MS
+#define CONFIG_LIGHT_COMMISSION_BACKOFF_MIN_MS 1000
+#endif
+#ifndef CONFIG_LIGHT_COMMISSION_BACKOFF_MAX_MS
+#define CONFIG_LIGHT_COMMISSION_BACKOFF_MAX_MS 60000
+#endif
+#ifndef CONFIG_LIGHT_ZB_TASK_STACK_SIZE
+#define CONFIG_LIGHT_ZB_TASK_STACK_SIZE 4096
+#endif
+#ifndef CONFIG_LIGHT_ZB_TASK_PRIORITY
+#define CONFIG_LIGHT_ZB_TASK_PRIORITY 5
+#endif
+#ifndef CONFIG_LIGHT_MEMORY_REPORT_ON_BOOT
+#define CONFIG_LIGHT_MEMORY_REPORT_ON_BOOT 1
+#endif
+#ifndef CONFIG_LIGHT_OTA
+#define CONFIG_LIGHT_OTA 1
+#endif
+#ifndef CONFIG_LIGHT_OTA_MANUFACTURER_CODE
+#define CONFIG_LIGHT_OTA_MANUFACTURER_CODE 0x131B
+#endif
+#ifndef CONFIG_LIGHT_OTA_IMAGE_TYPE
+#define CONFIG_LIGHT_OTA_IMAGE_TYPE 0x0001
+#endif
+#ifndef CONFIG_LIGHT_OTA_FILE_VERSION
+#define CONFIG_LIGHT_OTA_FILE_VERSION 0x00000001
+#endif
+#ifndef CONFIG_LIGHT_OTA_BLOCK_SIZE
+#define CONFIG_LIGHT_OTA_BLOCK_SIZE 64
+#endif
+#ifndef CONFIG_LIGHT_OTA_BLOCK_PERIOD_MS
+#define CONFIG_LIGHT_OTA_BLOCK_PERIOD_MS 250
+#endif
+#ifndef CONFIG_LIGHT_OTA_QUERY_INTERVAL_MIN
+#define CONFIG_LIGHT_OTA_QUERY_INTERVAL_MIN 1440
+#endif
+#ifndef CONFIG_LIGHT_OTA_CHECKPOINT_KB
+#define CONFIG_LIGHT_OTA_CHECKPOINT_KB 64
+#endif
+#ifndef CONFIG_LIGHT_REPORT_MIN_INTERVAL_S
+#define CONFIG_LIGHT_REPORT_MIN_INTERVAL_S 1
+#endif
+#ifndef CONFIG_LIGHT_REPORT_MAX_INTERVAL_S
+#define CONFIG_LIGHT_REPORT_MAX_INTERVAL_S 300
+#endif
+#ifndef CONFIG_LIGHT_REPORT_LEVEL_CHANGE
+#define CONFIG_LIGHT_REPORT_LEVEL_CHANGE 2
+#endif
+#ifndef CONFIG_LIGHT_REPORT_XY_CHANGE
+#define CONFIG_LIGHT_REPORT_XY_CHANGE 256
+#endif
+#ifndef CONFIG_LIGHT_REPORT_CT_CHANGE
+#define CONFIG_LIGHT_REPORT_CT_CHANGE 5
+#endif
+#ifndef CONFIG_LIGHT_SCENE_MAX
+#define CONFIG_LIGHT_SCENE_MAX 32
+#endif
+#ifndef CONFIG_LIGHT_SCENE_SAVE_DELAY_MS
+#define CONFIG_LIGHT_SCENE_SAVE_DELAY_MS 5000
+#endif
+/* no scheduler to run the trace drain task, see light_trace_dump() */
+#undef CONFIG_LIGHT_TRACE_DRAIN_TASK
+/* the simulation renders synchronously, see light_render_submit() */
+#undef CONFIG_LIGHT_DRIVER_RENDER_TASK
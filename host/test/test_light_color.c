@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Checks the integer color conversions of light_color.h against the float
+ * reference macros of light_driver.h and prints one line per check. Fails
+ * if any channel is off by more than 1:
+ *
+ *  - xy_to_rgb: light_color_xy_to_rgb() on a dense x/y grid against
+ *    XYZ_to_RGB(), brightest channel scaled to 255 as the driver does. Only
+ *    colors inside the sRGB gamut count; outside it the driver maps onto the
+ *    gamut triangle where the macro clamps. Needs the srgb LED primaries.
+ *  - hsv_to_rgb: light_color_hsv_to_rgb() for every hue/sat pair against
+ *    HSV_to_RGB() at full value
+ *  - level_scale: light_color_scale() for every channel/level pair against
+ *    the float level ratio the setters used
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "light_color.h"
+#include "light_driver.h"
+
+#define TEST_XY_STEP    37      /* prime, so the grid does not line up with the xy table cells */
+#define TEST_MAX_LSB    1
+
+static int test_diff(uint8_t a, uint8_t b)
+{
+    return abs((int)a - (int)b);
+}
+
+static int test_rgb_diff(const light_rgb_t *rgb, uint8_t r, uint8_t g, uint8_t b)
+{
+    int d = test_diff(rgb->r, r);
+    d = test_diff(rgb->g, g) > d ? test_diff(rgb->g, g) : d;
+    return test_diff(rgb->b, b) > d ? test_diff(rgb->b, b) : d;
+}
+
+static unsigned test_report(const char *name, unsigned checked, int max_lsb)
+{
+    unsigned failed = !checked || max_lsb > TEST_MAX_LSB;
+    printf("%s checked=%u max_lsb=%d %s\n", name, checked, max_lsb, failed ? "FAIL" : "ok");
+    return failed;
+}
+
+static unsigned test_xy_to_rgb(void)
+{
+#if LIGHT_TEST_SRGB_PRIMARIES
+    unsigned checked = 0;
+    int max_lsb = 0;
+    for (uint32_t y = 1; y <= UINT16_MAX; y += TEST_XY_STEP) {
+        for (uint32_t x = 0; x + y <= UINT16_MAX; x += TEST_XY_STEP) {
+            /* X:Y:Z = x:y:z; a quarter keeps every channel below the macro's clamp at 1 */
+            float fx = x / 65535.0f;
+            float fy = y / 65535.0f;
+            float r, g, b;
+            XYZ_to_RGB(fx / 4, fy / 4, (1 - fx - fy) / 4, r, g, b);
+            if (r <= 0 || g <= 0 || b <= 0) {
+                continue;
+            }
+            float peak = fmaxf(r, fmaxf(g, b));
+            light_rgb_t rgb;
+            light_color_xy_to_rgb(x, y, &rgb);
+            int d = test_rgb_diff(&rgb, lroundf(r * 255 / peak), lroundf(g * 255 / peak), lroundf(b * 255 / peak));
+            if (d > TEST_MAX_LSB && max_lsb <= TEST_MAX_LSB) {
+                printf("xy_to_rgb x=%u y=%u got #%02x%02x%02x\n", (unsigned)x, (unsigned)y, rgb.r, rgb.g, rgb.b);
+            }
+            max_lsb = d > max_lsb ? d : max_lsb;
+            checked++;
+        }
+    }
+    return test_report("xy_to_rgb", checked, max_lsb);
+#else
+    printf("xy_to_rgb skipped, the reference macro is sRGB only\n");
+    return 0;
+#endif
+}
+
+static unsigned test_hsv_to_rgb(void)
+{
+    unsigned checked = 0;
+    int max_lsb = 0;
+    for (uint32_t hue = 0; hue <= UINT8_MAX; hue++) {
+        for (uint32_t sat = 0; sat <= UINT8_MAX; sat++) {
+            float r, g, b;
+            HSV_to_RGB(hue, sat, UINT8_MAX, r, g, b);
+            light_rgb_t rgb;
+            light_color_hsv_to_rgb(hue, sat, UINT8_MAX, &rgb);
+            int d = test_rgb_diff(&rgb, (uint8_t)r, (uint8_t)g, (uint8_t)b);
+            if (d > TEST_MAX_LSB && max_lsb <= TEST_MAX_LSB) {
+                printf("hsv_to_rgb hue=%u sat=%u got #%02x%02x%02x\n", (unsigned)hue, (unsigned)sat, rgb.r, rgb.g, rgb.b);
+            }
+            max_lsb = d > max_lsb ? d : max_lsb;
+            checked++;
+        }
+    }
+    return test_report("hsv_to_rgb", checked, max_lsb);
+}
+
+static unsigned test_level_scale(void)
+{
+    unsigned checked = 0;
+    int max_lsb = 0;
+    for (uint32_t value = 0; value <= UINT8_MAX; value++) {
+        for (uint32_t level = 0; level <= UINT8_MAX; level++) {
+            float ratio = (float)level / 255;
+            int d = test_diff(light_color_scale(value, level), (uint8_t)(value * ratio));
+            max_lsb = d > max_lsb ? d : max_lsb;
+            checked++;
+        }
+    }
+    return test_report("level_scale", checked, max_lsb);
+}
+
+int main(void)
+{
+    unsigned failed = test_xy_to_rgb();
+    failed += test_hsv_to_rgb();
+    failed += test_level_scale();
+    return failed ? 1 : 0;
+}
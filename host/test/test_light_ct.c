@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bounds the error of the interpolated color temperature table: for every
+ * mired in [LIGHT_COLOR_CT_MIN_MIREDS..LIGHT_COLOR_CT_MAX_MIREDS],
+ * light_color_ct_to_rgb() against the Planckian locus point converted by
+ * light_color_xy_to_rgb(), which test_light_color checks against the float
+ * reference. The locus is the cubic spline of Kim et al. that
+ * gen_color_tables.py builds the table from, computed in double here. Prints
+ * the max and mean error for the table points alone and for all mireds, and
+ * fails if a channel is off by more than TEST_CT_MAX_LSB.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "light_color.h"
+#include "light_color_tables.h"
+
+#define TEST_CT_MAX_LSB     2   /* 1 from the xy conversion, 1 from the linear interpolation */
+
+static void test_planckian_xy(double kelvin, double *x, double *y)
+{
+    double t = kelvin;
+    if (t <= 4000) {
+        *x = -0.2661239e9 / (t * t * t) - 0.2343589e6 / (t * t) + 0.8776956e3 / t + 0.179910;
+    } else {
+        *x = -3.0258469e9 / (t * t * t) + 2.1070379e6 / (t * t) + 0.2226347e3 / t + 0.240390;
+    }
+    double u = *x;
+    if (t <= 2222) {
+        *y = -1.1063814 * u * u * u - 1.34811020 * u * u + 2.18555832 * u - 0.20219683;
+    } else if (t <= 4000) {
+        *y = -0.9549476 * u * u * u - 1.37418593 * u * u + 2.09137015 * u - 0.16748867;
+    } else {
+        *y = 3.0817580 * u * u * u - 5.87338670 * u * u + 3.75112997 * u - 0.37001483;
+    }
+}
+
+static int test_rgb_diff(const light_rgb_t *a, const light_rgb_t *b)
+{
+    int d = abs(a->r - b->r);
+    d = abs(a->g - b->g) > d ? abs(a->g - b->g) : d;
+    return abs(a->b - b->b) > d ? abs(a->b - b->b) : d;
+}
+
+static unsigned test_report(const char *name, unsigned checked, int max_lsb, unsigned sum_lsb)
+{
+    unsigned failed = !checked || max_lsb > TEST_CT_MAX_LSB;
+    printf("%s checked=%u max_lsb=%d mean_lsb=%.3f %s\n", name, checked, max_lsb,
+           checked ? (double)sum_lsb / checked : 0.0, failed ? "FAIL" : "ok");
+    return failed;
+}
+
+int main(void)
+{
+    unsigned checked[2] = { 0 }, sum_lsb[2] = { 0 };
+    int max_lsb[2] = { 0 };
+    for (uint32_t mireds = LIGHT_COLOR_CT_MIN_MIREDS; mireds <= LIGHT_COLOR_CT_MAX_MIREDS; mireds++) {
+        double x, y;
+        test_planckian_xy(1e6 / mireds, &x, &y);
+        light_rgb_t ref, rgb;
+        light_color_xy_to_rgb((uint16_t)(x * 65535 + 0.5), (uint16_t)(y * 65535 + 0.5), &ref);
+        light_color_ct_to_rgb(mireds, &rgb);
+        int d = test_rgb_diff(&rgb, &ref);
+        if (d > TEST_CT_MAX_LSB) {
+            printf("ct_to_rgb mireds=%u got #%02x%02x%02x want #%02x%02x%02x\n", (unsigned)mireds,
+                   rgb.r, rgb.g, rgb.b, ref.r, ref.g, ref.b);
+        }
+        /* [0]: table points, [1]: every mired */
+        for (int i = (mireds - LIGHT_COLOR_CT_MIN_MIREDS) & ((1U << LIGHT_CT_TABLE_STEP_BITS) - 1) ? 1 : 0; i < 2; i++) {
+            max_lsb[i] = d > max_lsb[i] ? d : max_lsb[i];
+            sum_lsb[i] += d;
+            checked[i]++;
+        }
+    }
+    unsigned failed = test_report("ct_table_points", checked[0], max_lsb[0], sum_lsb[0]);
+    failed += test_report("ct_to_rgb", checked[1], max_lsb[1], sum_lsb[1]);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Drives light_transition_start()/light_transition_step() with a virtual
+ * clock and prints one line per check:
+ *
+ *  - endpoints: the output starts at the old value, ends exactly on the
+ *    target and step() reports the end
+ *  - monotonic: every channel moves towards its target, never back, and
+ *    stays between the endpoints; also across the 32 bit clock wrap and for
+ *    transitions long enough to hit the progress scaling
+ *  - jump: a duration of 0 shows the target at once
+ *  - preemption: a new target mid-fade starts from the current output, not
+ *    from the old endpoints
+ */
+
+#include <stdio.h>
+#include "light_transition.h"
+
+static const light_target_t s_dark = { .rgb = { 0, 0, 0 }, .level = 0 };
+static const light_target_t s_warm = { .rgb = { 255, 147, 41 }, .level = 254 };
+static const light_target_t s_blue = { .rgb = { 10, 40, 255 }, .level = 30 };
+
+static void test_channels(const light_target_t *value, int ch[4])
+{
+    ch[0] = value->rgb.r;
+    ch[1] = value->rgb.g;
+    ch[2] = value->rgb.b;
+    ch[3] = value->level;
+}
+
+static int test_equal(const light_target_t *a, const light_target_t *b)
+{
+    int ca[4], cb[4];
+    test_channels(a, ca);
+    test_channels(b, cb);
+    for (int i = 0; i < 4; i++) {
+        if (ca[i] != cb[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static unsigned test_report(const char *name, unsigned checked, unsigned bad)
+{
+    unsigned failed = !checked || bad;
+    printf("%s checked=%u bad=%u %s\n", name, checked, bad, failed ? "FAIL" : "ok");
+    return failed;
+}
+
+/* Steps a running transition from now_ms to its end in step_ms increments and
+ * counts outputs that move away from the target or leave [from, to]. */
+static unsigned test_fade(light_transition_t *t, const light_target_t *from, const light_target_t *to,
+                          uint32_t now_ms, uint32_t duration_ms, uint32_t step_ms, unsigned *checked)
+{
+    int cf[4], ct[4], prev[4];
+    unsigned bad = 0;
+    test_channels(from, cf);
+    test_channels(to, ct);
+    test_channels(from, prev);
+    for (uint32_t elapsed = 0; elapsed <= duration_ms; elapsed += step_ms) {
+        light_target_t out;
+        light_transition_step(t, now_ms + elapsed, &out);
+        int ch[4];
+        test_channels(&out, ch);
+        for (int i = 0; i < 4; i++) {
+            int dir = ct[i] > cf[i] ? 1 : -1;
+            int lo = cf[i] < ct[i] ? cf[i] : ct[i];
+            int hi = cf[i] < ct[i] ? ct[i] : cf[i];
+            if ((ch[i] - prev[i]) * dir < 0 || ch[i] < lo || ch[i] > hi) {
+                bad++;
+            }
+            prev[i] = ch[i];
+        }
+        (*checked)++;
+    }
+    return bad;
+}
+
+static unsigned test_endpoints(void)
+{
+    light_transition_t t;
+    light_target_t out;
+    unsigned checked = 0, bad = 0;
+    light_transition_init(&t, &s_dark);
+    light_transition_start(&t, &s_warm, 100, 1000);
+
+    bad += !light_transition_step(&t, 100, &out) || !test_equal(&out, &s_dark);
+    bad += !light_transition_step(&t, 600, &out) || test_equal(&out, &s_dark) || test_equal(&out, &s_warm);
+    bad += light_transition_step(&t, 1100, &out) || !test_equal(&out, &s_warm);
+    bad += light_transition_step(&t, 5000, &out) || !test_equal(&out, &s_warm);
+    checked += 4;
+    return test_report("endpoints", checked, bad);
+}
+
+static unsigned test_monotonic(void)
+{
+    light_transition_t t;
+    unsigned checked = 0, bad = 0;
+
+    light_transition_init(&t, &s_dark);
+    light_transition_start(&t, &s_warm, 0, 1000);
+    bad += test_fade(&t, &s_dark, &s_warm, 0, 1000, 1, &checked);
+
+    /* down, across the wrap of the millisecond clock */
+    light_transition_start(&t, &s_blue, UINT32_MAX - 700, 1500);
+    bad += test_fade(&t, &s_warm, &s_blue, UINT32_MAX - 700, 1500, 1, &checked);
+
+    /* a ten minute fade scales elapsed and duration down before dividing */
+    light_transition_start(&t, &s_dark, 0, 600000);
+    bad += test_fade(&t, &s_blue, &s_dark, 0, 600000, 97, &checked);
+    return test_report("monotonic", checked, bad);
+}
+
+static unsigned test_jump(void)
+{
+    light_transition_t t;
+    light_target_t out;
+    unsigned bad = 0;
+    light_transition_init(&t, &s_warm);
+    light_transition_start(&t, &s_blue, 42, 0);
+    bad += light_transition_step(&t, 42, &out) || !test_equal(&out, &s_blue);
+    return test_report("jump", 1, bad);
+}
+
+static unsigned test_preemption(void)
+{
+    light_transition_t t;
+    light_target_t mid, out;
+    unsigned checked = 0, bad = 0;
+    light_transition_init(&t, &s_dark);
+    light_transition_start(&t, &s_warm, 0, 1000);
+    light_transition_step(&t, 400, &mid);
+
+    light_transition_start(&t, &s_blue, 400, 800);
+    bad += !light_transition_step(&t, 400, &out) || !test_equal(&out, &mid);
+    checked++;
+    bad += test_fade(&t, &mid, &s_blue, 400, 800, 1, &checked);
+    bad += light_transition_step(&t, 1200, &out) || !test_equal(&out, &s_blue);
+    checked++;
+
+    /* preempting a finished transition starts from its target */
+    light_transition_start(&t, &s_warm, 3000, 500);
+    bad += !light_transition_step(&t, 3000, &out) || !test_equal(&out, &s_blue);
+    checked++;
+    return test_report("preemption", checked, bad);
+}
+
+int main(void)
+{
+    unsigned failed = test_endpoints();
+    failed += test_monotonic();
+    failed += test_jump();
+    failed += test_preemption();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Benchmark kernel: one call of the code under test for input number @p i */
+typedef struct {
+    const char *name;
+    void (*run)(uint32_t i);
+} light_bench_kernel_t;
+
+/** Per call cost of a kernel, in light_bench_unit() */
+typedef struct {
+    uint32_t min;
+    uint32_t median;
+    uint32_t p99;
+    uint32_t samples;       /*!< Timed batches */
+    uint32_t batch;         /*!< Calls per batch */
+} light_bench_result_t;
+
+/**
+* @brief Unit of the benchmark clock: "cycles" on target, "ns" on the host
+*/
+const char *light_bench_unit(void);
+
+/**
+* @brief Read the benchmark clock
+*
+* esp_cpu_get_cycle_count() on target, CLOCK_MONOTONIC on the host. Only
+* differences are meaningful, they wrap at 32 bits.
+*/
+uint32_t light_bench_clock(void);
+
+/**
+* @brief Ticks of the benchmark clock per second
+*
+* The default CPU frequency on target, 10^9 on the host.
+*/
+uint32_t light_bench_clock_hz(void);
+
+/**
+* @brief Time a kernel over CONFIG_LIGHT_BENCH_SAMPLES batches
+*
+* @param  kernel  kernel to run
+* @param  result  per call cost
+* @return ESP_ERR_NO_MEM if the sample buffer cannot be allocated
+*/
+esp_err_t light_bench_run(const light_bench_kernel_t *kernel, light_bench_result_t *result);
+
+/**
+* @brief Print a result as one JSON line on stdout
+*
+* {"bench":"<name>","unit":"cycles","samples":101,"batch":32,"min":..,"median":..,"p99":..}
+*/
+void light_bench_print(const char *name, const light_bench_result_t *result);
+
+/**
+* @brief Run and print all built-in kernels
+*
+* The color conversion, power limiter and effect kernels always run, old float reference macros next
+* to the integer and table versions. The driver kernels (setter plus
+* light_driver_commit()) need light_driver_init() first and change the
+* driver state. The error of the xy table against the matrix path is
+* printed after the color kernels, as "xy_to_rgb_lut_error", followed by
+* "frame_fill", one color written to every pixel of a
+* LIGHT_DRIVER_LED_COUNT_MAX frame, and "frame_fill_rate", the pixels per
+* second that comes to.
+*
+* @param  with_driver  also run the driver kernels
+*/
+void light_bench_run_all(bool with_driver);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
+#include "esp_check.h"
+#include "light_bench.h"
+
+#if defined(__linux__)
+#include <time.h>
+#else
+#include "esp_cpu.h"
+#endif
+
+static const char *TAG = "LIGHT_BENCH";
+
+const char *light_bench_unit(void)
+{
+#if defined(__linux__)
+    return "ns";
+#else
+    return "cycles";
+#endif
+}
+
+uint32_t light_bench_clock(void)
+{
+#if defined(__linux__)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec);
+#else
+    return (uint32_t)esp_cpu_get_cycle_count();
+#endif
+}
+
+uint32_t light_bench_clock_hz(void)
+{
+#if defined(__linux__)
+    return 1000000000U;
+#else
+    return (uint32_t)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000U;
+#endif
+}
+
+static int light_bench_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+esp_err_t light_bench_run(const light_bench_kernel_t *kernel, light_bench_result_t *result)
+{
+    const uint32_t samples = CONFIG_LIGHT_BENCH_SAMPLES;
+    const uint32_t batch = CONFIG_LIGHT_BENCH_BATCH;
+    uint32_t *cost = malloc(samples * sizeof(uint32_t));
+    ESP_RETURN_ON_FALSE(cost, ESP_ERR_NO_MEM, TAG, "No memory for %u samples", (unsigned)samples);
+    /* warm up caches and branch predictors, not timed */
+    for (uint32_t i = 0; i < batch; i++) {
+        kernel->run(i);
+    }
+    uint32_t input = 0;
+    for (uint32_t s = 0; s < samples; s++) {
+        uint32_t start = light_bench_clock();
+        for (uint32_t i = 0; i < batch; i++) {
+            kernel->run(input++);
+        }
+        cost[s] = (light_bench_clock() - start) / batch;
+    }
+    qsort(cost, samples, sizeof(uint32_t), light_bench_cmp);
+    result->min = cost[0];
+    result->median = cost[samples / 2];
+    /* nearest rank */
+    result->p99 = cost[(samples * 99 + 99) / 100 - 1];
+    result->samples = samples;
+    result->batch = batch;
+    free(cost);
+    return ESP_OK;
+}
+
+void light_bench_print(const char *name, const light_bench_result_t *result)
+{
+    printf("{\"bench\":\"%s\",\"unit\":\"%s\",\"samples\":%u,\"batch\":%u,\"min\":%u,\"median\":%u,\"p99\":%u}\n",
+           name, light_bench_unit(), (unsigned)result->samples, (unsigned)result->batch, (unsigned)result->min,
+           (unsigned)result->median, (unsigned)result->p99);
+}
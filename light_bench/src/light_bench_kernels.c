@@ -0,0 +1,342 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "light_bench.h"
+#include "light_color.h"
+#include "light_driver.h"
+#include "light_effect.h"
+#include "light_power.h"
+
+#define BENCH_INPUTS 256
+#define BENCH_XY_ERROR_STEP 157     /* xy grid the table error is measured on, prime */
+#define BENCH_POWER_LEDS 300
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t mireds;
+    uint8_t hue;
+    uint8_t sat;
+    uint8_t level;
+    light_rgb_t rgb;
+} bench_input_t;
+
+static bench_input_t s_inputs[BENCH_INPUTS];
+static light_rgb_t s_power_frame[BENCH_POWER_LEDS];
+static light_rgb_t s_power_out[BENCH_POWER_LEDS];
+static light_rgb_t s_fill_frame[LIGHT_DRIVER_LED_COUNT_MAX];
+/* results land here so the compiler cannot drop the kernels */
+static volatile uint8_t s_sink;
+
+static void bench_inputs_init(void)
+{
+    uint32_t seed = 0x2545f491;
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        seed = seed * 1664525 + 1013904223;
+        /* xy within the range Hue bridges send: x 0.15..0.70, y 0.05..0.60 */
+        s_inputs[i].x = 0x2666 + (seed >> 16) % 0x8ccd;
+        s_inputs[i].y = 0x0ccd + (seed & 0xffff) % 0x8ccd;
+        seed = seed * 1664525 + 1013904223;
+        s_inputs[i].mireds = LIGHT_COLOR_CT_MIN_MIREDS + (seed >> 16) % (LIGHT_COLOR_CT_MAX_MIREDS - LIGHT_COLOR_CT_MIN_MIREDS + 1);
+        s_inputs[i].hue = seed >> 8;
+        s_inputs[i].sat = seed;
+        seed = seed * 1664525 + 1013904223;
+        s_inputs[i].level = seed >> 24;
+        s_inputs[i].rgb.r = seed >> 16;
+        s_inputs[i].rgb.g = seed >> 8;
+        s_inputs[i].rgb.b = seed;
+    }
+    for (int i = 0; i < BENCH_POWER_LEDS; i++) {
+        s_power_frame[i] = s_inputs[i & (BENCH_INPUTS - 1)].rgb;
+    }
+}
+
+static inline const bench_input_t *bench_input(uint32_t i)
+{
+    return &s_inputs[i & (BENCH_INPUTS - 1)];
+}
+
+static void bench_noop(uint32_t i)
+{
+    s_sink = bench_input(i)->level;
+}
+
+/* the float path light_driver_set_color_xy() used before the fixed-point module */
+static void bench_xy_to_rgb_float(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    float red_f, green_f, blue_f;
+    float color_x = (float)in->x / 65535;
+    float color_y = (float)in->y / 65535;
+    float color_X = color_x / color_y;
+    float color_Z = (1 - color_x - color_y) / color_y;
+    XYZ_to_RGB(color_X, 1, color_Z, red_f, green_f, blue_f);
+    s_sink = (uint8_t)(red_f * 255) ^ (uint8_t)(green_f * 255) ^ (uint8_t)(blue_f * 255);
+}
+
+static void bench_xy_to_rgb_fixed(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    light_rgb_t rgb;
+    light_color_xy_to_rgb(in->x, in->y, &rgb);
+    s_sink = rgb.r ^ rgb.g ^ rgb.b;
+}
+
+/* whites and pastels around 0x5000..0x6fff, inside any LED gamut: the matrix
+ * multiply alone, without the nearest-edge mapping */
+static void bench_xy_to_rgb_fixed_in_gamut(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    light_rgb_t rgb;
+    light_color_xy_to_rgb(0x5000 + (in->x & 0x1fff), 0x5000 + (in->y & 0x1fff), &rgb);
+    s_sink = rgb.r ^ rgb.g ^ rgb.b;
+}
+
+static void bench_xy_to_rgb_lut(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    light_rgb_t rgb;
+    light_color_xy_to_rgb_lut(in->x, in->y, &rgb);
+    s_sink = rgb.r ^ rgb.g ^ rgb.b;
+}
+
+static void bench_hsv_to_rgb_float(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    float red_f, green_f, blue_f;
+    HSV_to_RGB(in->hue, in->sat, UINT8_MAX, red_f, green_f, blue_f);
+    s_sink = (uint8_t)red_f ^ (uint8_t)green_f ^ (uint8_t)blue_f;
+}
+
+static void bench_hsv_to_rgb_fixed(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    light_rgb_t rgb;
+    light_color_hsv_to_rgb(in->hue, in->sat, UINT8_MAX, &rgb);
+    s_sink = rgb.r ^ rgb.g ^ rgb.b;
+}
+
+static void bench_ct_to_rgb(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    light_rgb_t rgb;
+    light_color_ct_to_rgb(in->mireds, &rgb);
+    s_sink = rgb.r ^ rgb.g ^ rgb.b;
+}
+
+/* the float level ratio the setters used before the fixed-point module */
+static void bench_level_scale_float(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    float ratio = (float)in->level / 255;
+    s_sink = (uint8_t)(in->rgb.r * ratio) ^ (uint8_t)(in->rgb.g * ratio) ^ (uint8_t)(in->rgb.b * ratio);
+}
+
+static void bench_level_scale_gamma(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    uint8_t scale = light_color_gamma(in->level);
+    s_sink = light_color_scale(in->rgb.r, scale) ^ light_color_scale(in->rgb.g, scale) ^ light_color_scale(in->rgb.b, scale);
+}
+
+/* power limiter kernels: what the render context adds per frame of a
+ * 300 LED strip with a budget, the estimate alone and, for a frame over
+ * budget, the estimate plus scaling every channel on the way out */
+static void bench_power_load(uint32_t i)
+{
+    uint32_t load = light_power_load(s_power_frame, BENCH_POWER_LEDS);
+    s_sink = light_power_scale(load, load + i);
+}
+
+static void bench_power_limit(uint32_t i)
+{
+    uint32_t load = light_power_load(s_power_frame, BENCH_POWER_LEDS);
+    uint8_t scale = light_power_scale(load, load / 2 + (i & 0xff));
+    for (int p = 0; p < BENCH_POWER_LEDS; p++) {
+        s_power_out[p].r = light_color_scale(s_power_frame[p].r, scale);
+        s_power_out[p].g = light_color_scale(s_power_frame[p].g, scale);
+        s_power_out[p].b = light_color_scale(s_power_frame[p].b, scale);
+    }
+    s_sink = s_power_out[i % BENCH_POWER_LEDS].r;
+}
+
+/* frame fill: what the render context does per segment and frame once the
+ * output is known, the level scaled in and one color written to every pixel
+ * of the configured strip */
+static void bench_frame_fill(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    uint8_t scale = light_color_gamma(in->level);
+    light_rgb_t color = {
+        .r = light_color_scale(in->rgb.r, scale),
+        .g = light_color_scale(in->rgb.g, scale),
+        .b = light_color_scale(in->rgb.b, scale),
+    };
+    for (int p = 0; p < LIGHT_DRIVER_LED_COUNT_MAX; p++) {
+        s_fill_frame[p] = color;
+    }
+    s_sink = s_fill_frame[i % LIGHT_DRIVER_LED_COUNT_MAX].g;
+}
+
+/* effect kernels: what the render task adds per segment and frame while an
+ * effect runs, frame i at 20 ms (CONFIG_LIGHT_DRIVER_TRANSITION_FPS 50) */
+static void bench_effect(const light_effect_params_t *params, light_effect_t *effect, uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    if (!effect->active) {
+        light_effect_start(effect, params, 0);
+    }
+    light_target_t out = {
+        .rgb = in->rgb,
+        .level = in->level,
+    };
+    light_effect_step(effect, i * 20, &out);
+    s_sink = out.rgb.r ^ out.rgb.g ^ out.rgb.b ^ out.level;
+}
+
+static void bench_effect_breathe(uint32_t i)
+{
+    static const light_effect_params_t params = { .id = LIGHT_EFFECT_BREATHE };
+    static light_effect_t effect;
+    bench_effect(&params, &effect, i);
+}
+
+static void bench_effect_colorloop(uint32_t i)
+{
+    static const light_effect_params_t params = { .id = LIGHT_EFFECT_COLORLOOP, .period_s = 25 };
+    static light_effect_t effect;
+    bench_effect(&params, &effect, i);
+}
+
+/* driver kernels: setter plus commit on segment 0, i.e. one attribute write
+ * as the Zigbee task sees it. With the render task this ends at the queue; once the queue
+ * is full the commit is rejected after the color has been resolved. */
+static void bench_driver_set_color_xy(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    light_driver_set_color_xy(0, in->x, in->y);
+    s_sink = light_driver_commit();
+}
+
+static void bench_driver_set_color_hue_sat(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    light_driver_set_color_hue_sat(0, in->hue, in->sat);
+    s_sink = light_driver_commit();
+}
+
+static void bench_driver_set_color_temperature(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    light_driver_set_color_temperature(0, in->mireds);
+    s_sink = light_driver_commit();
+}
+
+static void bench_driver_set_level(uint32_t i)
+{
+    const bench_input_t *in = bench_input(i);
+    light_driver_set_level(0, in->level);
+    s_sink = light_driver_commit();
+}
+
+static const light_bench_kernel_t s_color_kernels[] = {
+    { "noop", bench_noop },
+    { "xy_to_rgb_float", bench_xy_to_rgb_float },
+    { "xy_to_rgb_fixed", bench_xy_to_rgb_fixed },
+    { "xy_to_rgb_fixed_in_gamut", bench_xy_to_rgb_fixed_in_gamut },
+    { "xy_to_rgb_lut", bench_xy_to_rgb_lut },
+    { "hsv_to_rgb_float", bench_hsv_to_rgb_float },
+    { "hsv_to_rgb_fixed", bench_hsv_to_rgb_fixed },
+    { "ct_to_rgb", bench_ct_to_rgb },
+    { "level_scale_float", bench_level_scale_float },
+    { "level_scale_gamma", bench_level_scale_gamma },
+    { "power_load_300", bench_power_load },
+    { "power_limit_300", bench_power_limit },
+    { "effect_breathe", bench_effect_breathe },
+    { "effect_colorloop", bench_effect_colorloop },
+};
+
+static const light_bench_kernel_t s_driver_kernels[] = {
+    { "driver_set_color_xy", bench_driver_set_color_xy },
+    { "driver_set_color_hue_sat", bench_driver_set_color_hue_sat },
+    { "driver_set_color_temperature", bench_driver_set_color_temperature },
+    { "driver_set_level", bench_driver_set_level },
+};
+
+/* error of the xy table against the matrix path it is generated from, on a
+ * grid over the range Hue bridges send; one JSON line per build, as the table
+ * size is a build option */
+static void bench_xy_lut_error(void)
+{
+    uint32_t points = 0;
+    uint32_t max = 0;
+    uint64_t sum = 0;
+    for (uint32_t y = 0x0ccd; y < 0x0ccd + 0x8ccd; y += BENCH_XY_ERROR_STEP) {
+        for (uint32_t x = 0x2666; x < 0x2666 + 0x8ccd; x += BENCH_XY_ERROR_STEP) {
+            light_rgb_t exact, lut;
+            light_color_xy_to_rgb(x, y, &exact);
+            light_color_xy_to_rgb_lut(x, y, &lut);
+            uint32_t err = abs(exact.r - lut.r);
+            err = abs(exact.g - lut.g) > err ? abs(exact.g - lut.g) : err;
+            err = abs(exact.b - lut.b) > err ? abs(exact.b - lut.b) : err;
+            max = err > max ? err : max;
+            sum += err;
+            points++;
+        }
+    }
+    uint32_t grid_points = (1U << CONFIG_LIGHT_DRIVER_XY_GRID_BITS) + 1;
+    uint32_t mean_milli = (uint32_t)((sum * 1000 + points / 2) / points);
+    printf("{\"bench\":\"xy_to_rgb_lut_error\",\"grid_bits\":%d,\"table_bytes\":%u,\"points\":%u,\"max_lsb\":%u,"
+           "\"mean_lsb\":%u.%03u}\n", CONFIG_LIGHT_DRIVER_XY_GRID_BITS, (unsigned)(grid_points * grid_points * 3), (unsigned)points,
+           (unsigned)max, (unsigned)(mean_milli / 1000), (unsigned)(mean_milli % 1000));
+}
+
+/* the frame fill kernel, and the pixels per second its median comes to; one
+ * JSON line per build, as the strip size is a build option */
+static void bench_frame_fill_rate(void)
+{
+    static const light_bench_kernel_t kernel = { "frame_fill", bench_frame_fill };
+    light_bench_result_t result;
+    if (light_bench_run(&kernel, &result) != ESP_OK) {
+        return;
+    }
+    light_bench_print(kernel.name, &result);
+    uint32_t median = result.median ? result.median : 1;
+    uint64_t pixels_per_s = (uint64_t)LIGHT_DRIVER_LED_COUNT_MAX * light_bench_clock_hz() / median;
+    printf("{\"bench\":\"frame_fill_rate\",\"leds\":%d,\"pixels_per_s\":%llu}\n", LIGHT_DRIVER_LED_COUNT_MAX,
+           (unsigned long long)pixels_per_s);
+}
+
+static void bench_run_table(const light_bench_kernel_t *kernels, size_t count)
+{
+    light_bench_result_t result;
+    for (size_t i = 0; i < count; i++) {
+        if (light_bench_run(&kernels[i], &result) == ESP_OK) {
+            light_bench_print(kernels[i].name, &result);
+        }
+    }
+}
+
+void light_bench_run_all(bool with_driver)
+{
+    bench_inputs_init();
+    bench_run_table(s_color_kernels, sizeof(s_color_kernels) / sizeof(s_color_kernels[0]));
+    bench_xy_lut_error();
+    bench_frame_fill_rate();
+    if (with_driver) {
+        bench_run_table(s_driver_kernels, sizeof(s_driver_kernels) / sizeof(s_driver_kernels[0]));
+    }
+}
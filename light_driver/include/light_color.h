@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Color temperature range covered by light_color_ct_to_rgb() */
+#define LIGHT_COLOR_CT_MIN_MIREDS 153   /* 6536 K */
+#define LIGHT_COLOR_CT_MAX_MIREDS 500   /* 2000 K */
+
+/** 8-bit per channel RGB color */
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} light_rgb_t;
+
+/**
+* @brief Convert CIE xy chromaticity to RGB (integer only)
+*
+* Q16 3x3 matrix generated from the board's LED primaries, see
+* CONFIG_LIGHT_DRIVER_LED_PRIMARIES. Colors outside the LED gamut are first
+* mapped to the nearest point of its triangle, as Hue bulbs do. The brightest
+* channel is always 255, the level does the dimming.
+*
+* @param  x    The color x [0..0xffff]
+* @param  y    The color y [0..0xffff]
+* @param  rgb  Resulting color
+*/
+void light_color_xy_to_rgb(uint16_t x, uint16_t y, light_rgb_t *rgb);
+
+/**
+* @brief Convert CIE xy chromaticity to RGB from the precomputed xy grid
+*
+* Bilinear interpolation of the build-time generated table, see
+* CONFIG_LIGHT_DRIVER_XY_GRID for the size/accuracy trade-off.
+*
+* @param  x    The color x [0..0xffff]
+* @param  y    The color y [0..0xffff]
+* @param  rgb  Resulting color
+*/
+void light_color_xy_to_rgb_lut(uint16_t x, uint16_t y, light_rgb_t *rgb);
+
+/**
+* @brief Convert hue/saturation/value to RGB (integer only)
+*
+* Fixed-point equivalent of HSV_to_RGB(), using the same six 42-step sectors.
+*
+* @param  hue  The hue [0..0xff]
+* @param  sat  The saturation [0..0xff]
+* @param  val  The value [0..0xff]
+* @param  rgb  Resulting color
+*/
+void light_color_hsv_to_rgb(uint8_t hue, uint8_t sat, uint8_t val, light_rgb_t *rgb);
+
+/**
+* @brief Convert a color temperature to RGB from the precomputed table
+*
+* Linear interpolation of a build-time Planckian locus table; the brightest
+* channel is always 255. Out of range values are clamped to
+* [LIGHT_COLOR_CT_MIN_MIREDS..LIGHT_COLOR_CT_MAX_MIREDS].
+*
+* @param  mireds  The color temperature in mireds
+* @param  rgb     Resulting color
+*/
+void light_color_ct_to_rgb(uint16_t mireds, light_rgb_t *rgb);
+
+/**
+* @brief Map a light level to a channel scale with the dimming gamma applied
+*
+* @param  level  The light level
+*/
+uint8_t light_color_gamma(uint8_t level);
+
+/**
+* @brief Color of the hue wheel at full saturation from the precomputed table
+*
+* Linear interpolation between the 256 points of the build-time table.
+*
+* @param  hue  The position on the wheel, one turn per 0x10000 (EnhancedCurrentHue)
+* @param  rgb  Resulting color
+*/
+void light_color_hue_wheel(uint16_t hue, light_rgb_t *rgb);
+
+/**
+* @brief Breathe waveform from the precomputed table, a sin^2 pulse
+*
+* @param  phase  The position in the cycle, one cycle per 0x10000
+* @return level scale, 0 at both ends of the cycle and 255 half way
+*/
+uint8_t light_color_breathe(uint16_t phase);
+
+/**
+* @brief Scale a channel by a light level, i.e. value * level / 255 (truncated)
+*
+* @param  value  The channel value
+* @param  level  The light level
+*/
+static inline uint8_t light_color_scale(uint8_t value, uint8_t level)
+{
+    uint32_t v = (uint32_t)value * level;
+    /* exact v / 255 for v <= 255 * 255 */
+    return (uint8_t)((v + 1 + (v >> 8)) >> 8);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
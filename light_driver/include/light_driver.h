@@ -16,7 +16,11 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <math.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "light_effect.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,12 +30,71 @@ extern "C" {
 #define LIGHT_DEFAULT_ON  1
 #define LIGHT_DEFAULT_OFF 0
 
-/* LED strip configuration */
-#define CONFIG_EXAMPLE_STRIP_LED_GPIO   8
-#define CONFIG_EXAMPLE_STRIP_LED_NUMBER 1
+/* segments the driver keeps state for and pixels it has frame buffers for,
+ * both statically allocated, see light_driver_config_t */
+#define LIGHT_DRIVER_SEGMENTS_MAX CONFIG_LIGHT_DRIVER_SEGMENTS
+#define LIGHT_DRIVER_LED_COUNT_MAX CONFIG_LIGHT_DRIVER_LED_COUNT
 
+/**
+* @brief Called from the render context once a frame has been clocked out to the strip
+*
+* @param  frame     frame number, counting from 1 since light_driver_init()
+* @param  wire_us   time from the start of the transfer until it was seen done
+* @param  user_ctx  light_driver_config_t::user_ctx
+*/
+typedef void (*light_driver_frame_done_cb_t)(uint32_t frame, uint32_t wire_us, void *user_ctx);
+
+/** LED strip configuration */
+typedef struct {
+    int gpio;               /*!< GPIO of the strip data line */
+    uint16_t led_count;     /*!< Number of pixels in the strip, at most LIGHT_DRIVER_LED_COUNT_MAX */
+    uint8_t segment_count;  /*!< Equally long segments, 1..LIGHT_DRIVER_SEGMENTS_MAX; the last one takes the remainder */
+    uint16_t power_budget_ma;   /*!< Current the strip may draw, frames over it are scaled down; 0 for no limit, else more than the dark strip draws */
+    light_driver_frame_done_cb_t on_frame_done;     /*!< Frame completion callback, may be NULL */
+    void *user_ctx;         /*!< Passed to on_frame_done */
+} light_driver_config_t;
+
+#define LIGHT_DRIVER_DEFAULT_CONFIG()                           \
+    {                                                           \
+        .gpio = CONFIG_LIGHT_DRIVER_LED_GPIO,                   \
+        .led_count = CONFIG_LIGHT_DRIVER_LED_COUNT,             \
+        .segment_count = CONFIG_LIGHT_DRIVER_SEGMENTS,          \
+        .power_budget_ma = CONFIG_LIGHT_DRIVER_POWER_BUDGET_MA, \
+    }
+
+/* log2 latency histograms: bucket 0 holds values below 2^base_bits, each
+ * following bucket spans twice the previous one, the last is open-ended */
+#define LIGHT_DRIVER_HIST_BUCKETS 8
+
+static inline uint8_t light_driver_hist_bucket(uint32_t value, uint8_t base_bits)
+{
+    uint32_t v = value >> base_bits;
+    uint8_t bucket = v ? 32 - __builtin_clz(v) : 0;
+    return bucket < LIGHT_DRIVER_HIST_BUCKETS ? bucket : LIGHT_DRIVER_HIST_BUCKETS - 1;
+}
+
+/* strip wait histogram starts at 256 us */
+#define LIGHT_DRIVER_REFRESH_HIST_BASE_BITS 8
+
+/** Render counters, see light_driver_get_stats() */
+typedef struct {
+    uint32_t frames;            /*!< Frames pushed to the strip */
+    uint32_t frames_done;       /*!< Frames seen clocked out, see light_driver_frame_done_cb_t */
+    uint32_t refresh_us_max;    /*!< Longest wait of the render context for the strip in one frame */
+    uint32_t refresh_hist[LIGHT_DRIVER_HIST_BUCKETS];   /*!< Strip wait per frame in us, see light_driver_hist_bucket() */
+    uint32_t wait_us;           /*!< Total strip wait in us, wraps: the whole refresh when blocking, with
+                                     CONFIG_LIGHT_DRIVER_LED_ASYNC only what is left of the previous frame */
+    uint32_t queued;            /*!< Commands queued for the render task */
+    uint32_t dropped;           /*!< Commands rejected because the render queue was full */
+    uint32_t overwritten;       /*!< Queued commands superseded by a newer one before rendering */
+    uint32_t power_limited;     /*!< Frames scaled down to light_driver_config_t::power_budget_ma */
+    uint32_t power_ma_max;      /*!< Highest estimated strip current of a frame before limiting, 0 without a budget */
+    uint16_t queue_depth;       /*!< Commands currently queued */
+    uint16_t queue_high_water;  /*!< Highest queue depth seen */
+} light_driver_stats_t;
 
 /** Convert Hue,Saturation,V to RGB
+ * Float reference for light_color_hsv_to_rgb(), not used by the driver.
  * RGB - [0..0xffff]
  * hue - [0..0xff]
  * Sat - [0..0xff]
@@ -64,6 +127,10 @@ extern "C" {
   }                                             \
 }
 
+/** Convert XYZ to linear sRGB
+ * Float reference for light_color_xy_to_rgb() with the srgb primaries,
+ * not used by the driver. Out of gamut colors are clamped, not mapped.
+*/
 #define XYZ_to_RGB(X, Y, Z, r, g, b)                        \
 {                                                           \
   r = (float)( 3.240479*(X) -1.537150*(Y) -0.498535*(Z));   \
@@ -72,53 +139,163 @@ extern "C" {
   if(r>1){r=1;}                                             \
   if(g>1){g=1;}                                             \
   if(b>1){b=1;}                                             \
+  if(r<0){r=0;}                                             \
+  if(g<0){g=0;}                                             \
+  if(b<0){b=0;}                                             \
 }
 
+/*
+ * The setters below only update the light state of one segment; nothing
+ * reaches the strip until light_driver_commit(), so several attribute
+ * changes, on any number of segments, render as one frame. They may be
+ * called before light_driver_init() to choose the first frame. Out of range
+ * segments are ignored.
+ */
+
 /**
 * @brief Set light power (on/off).
 *
-* @param  power  The light power to be set
+* @param  segment  Segment index
+* @param  power    The light power to be set
 */
-void light_driver_set_power(bool power);
+void light_driver_set_power(uint8_t segment, bool power);
 
 /**
 * @brief color light driver init, be invoked where you want to use color light
 *
-* @param power power on/off
+* Uses LIGHT_DRIVER_DEFAULT_CONFIG() and renders the state set so far;
+* segments start out off.
 */
-void light_driver_init(bool power);
+void light_driver_init(void);
+
+/**
+* @brief color light driver init with an explicit strip configuration
+*
+* @param config strip configuration
+*/
+void light_driver_init_with_config(const light_driver_config_t *config);
 
 /**
 * @brief Set light level
 *
-* @param  level  The light level to be set
+* @param  segment  Segment index
+* @param  level    The light level to be set
 */
-void light_driver_set_level(uint8_t level);
+void light_driver_set_level(uint8_t segment, uint8_t level);
 
 /**
 * @brief Set light color from RGB
 *
-* @param  red    The red color to be set
-* @param  green  The green color to be set
-* @param  blue   The blue color to be set
+* @param  segment  Segment index
+* @param  red      The red color to be set
+* @param  green    The green color to be set
+* @param  blue     The blue color to be set
 */
-void light_driver_set_color_RGB(uint8_t red, uint8_t green, uint8_t blue);
+void light_driver_set_color_RGB(uint8_t segment, uint8_t red, uint8_t green, uint8_t blue);
 
 /**
 * @brief Set light color from color xy
 *
+* @param  segment         Segment index
 * @param  color_currentx  The color x to be set
 * @param  color_currenty  The color y to be set
 */
-void light_driver_set_color_xy(uint16_t color_current_x, uint16_t color_current_y);
+void light_driver_set_color_xy(uint8_t segment, uint16_t color_current_x, uint16_t color_current_y);
 
 /**
 * @brief Set light color from hue saturation
 *
-* @param  hue  The hue to be set
-* @param  sat  The sat to be set
+* @param  segment  Segment index
+* @param  hue      The hue to be set
+* @param  sat      The sat to be set
+*/
+void light_driver_set_color_hue_sat(uint8_t segment, uint8_t hue, uint8_t sat);
+
+/**
+* @brief Set light color from color temperature
+*
+* @param  segment  Segment index
+* @param  mireds   The color temperature in mireds
+*/
+void light_driver_set_color_temperature(uint8_t segment, uint16_t mireds);
+
+/**
+* @brief Set the transition time of the next commit
+*
+* The render task interpolates color and level towards the committed state
+* at CONFIG_LIGHT_DRIVER_TRANSITION_FPS; a newer commit preempts a running
+* transition of the same segment. Reset to 0 after each commit.
+*
+* @param  segment        Segment index
+* @param  transition_ms  The transition time in milliseconds
+*/
+void light_driver_set_transition(uint8_t segment, uint32_t transition_ms);
+
+/**
+* @brief Start, finish or stop an effect at the next commit
+*
+* The render task runs the effect on top of the segment's light state, which
+* keeps changing underneath and shows as is again once the effect ends.
+* The color loop has a layer of its own between the two: the other effects
+* run on top of it and uncover it again when they end or are stopped.
+* Effects run from precomputed waveforms at CONFIG_LIGHT_DRIVER_TRANSITION_FPS;
+* without the render task only their first frame shows.
+*
+* @param  segment  Segment index
+* @param  effect   The effect; LIGHT_EFFECT_NONE stops the running one,
+*                  LIGHT_EFFECT_COLORLOOP_STOP the color loop
+*/
+void light_driver_set_effect(uint8_t segment, const light_effect_params_t *effect);
+
+/**
+* @brief Render the light state of all segments set since the last commit
+*
+* Queues one command per changed segment, all or none. Never waits for LED
+* I/O when CONFIG_LIGHT_DRIVER_RENDER_TASK is enabled.
+*
+* @return
+*      - ESP_OK: Frame queued, or nothing changed
+*      - ESP_ERR_NO_MEM: Render queue full, the state is kept for the next commit
+*/
+esp_err_t light_driver_commit(void);
+
+#if CONFIG_LIGHT_DRIVER_STREAM
+/**
+* @brief Pixel buffer of the next streamed frame
+*
+* 3 bytes (r, g, b) per LED, shown as is by light_driver_stream_show(). The
+* buffer keeps what was last written to it, so a frame may change only some
+* pixels.
+*
+* @param  led_count  Number of pixels in the buffer
+* @return NULL while the last shown frame is still being rendered, do not write then
+*/
+uint8_t *light_driver_stream_buffer(uint16_t *led_count);
+
+/**
+* @brief Show the stream buffer in place of the segment colors
+*
+* The strip shows streamed frames until the next light_driver_commit() that
+* changes a segment. Never waits for LED I/O when CONFIG_LIGHT_DRIVER_RENDER_TASK
+* is enabled.
+*
+* @return
+*      - ESP_OK: Frame queued
+*      - ESP_ERR_NO_MEM: Render queue full, the frame is dropped
+*/
+esp_err_t light_driver_stream_show(void);
+#endif
+
+/**
+* @brief Read the render counters
+*
+* Safe from any task while the render task runs. Every counter is read
+* whole; counters of the render task and of the committing task may be a
+* frame apart.
+*
+* @param stats counters snapshot
 */
-void light_driver_set_color_hue_sat(uint8_t hue, uint8_t sat);
+void light_driver_get_stats(light_driver_stats_t *stats);
 
 #ifdef __cplusplus
 } // extern "C"
@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "light_transition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Effects, after the ZCL Identify effects and the color loop */
+typedef enum {
+    LIGHT_EFFECT_NONE = 0,          /*!< Stop the running effect right away */
+    LIGHT_EFFECT_BLINK,             /*!< On for half a second, off for half a second */
+    LIGHT_EFFECT_BREATHE,           /*!< Fade up and down in one second */
+    LIGHT_EFFECT_OKAY,              /*!< Green for one second */
+    LIGHT_EFFECT_CHANNEL_CHANGE,    /*!< Orange for eight seconds */
+    LIGHT_EFFECT_COLORLOOP,         /*!< Turn around the hue wheel, period_s per turn */
+    LIGHT_EFFECT_FINISH,            /*!< Let the running effect end its current cycle, then stop */
+    LIGHT_EFFECT_COLORLOOP_STOP,    /*!< Stop the color loop right away */
+} light_effect_id_t;
+
+/** Effect to start, see light_driver_set_effect() */
+typedef struct {
+    uint16_t start_hue;     /*!< COLORLOOP: wheel position to start from, one turn per 0x10000 */
+    uint16_t period_s;      /*!< COLORLOOP: seconds per turn, 0 is taken as 1 */
+    uint8_t id;             /*!< light_effect_id_t */
+    uint8_t cycles;         /*!< BLINK, BREATHE: cycles to run, 0 until stopped; the others run once or until stopped */
+    bool reverse;           /*!< COLORLOOP: hue goes down */
+} light_effect_params_t;
+
+/** Effect running on one output, integer only.
+ *  Time is passed in by the caller, like for light_transition_t. */
+typedef struct {
+    light_effect_params_t params;
+    uint32_t start_ms;
+    uint32_t end_ms;        /*!< Valid with ends */
+    bool ends;              /*!< Stops at end_ms, else runs until stopped */
+    bool active;
+} light_effect_t;
+
+/**
+* @brief Start, finish or stop an effect
+*
+* A running effect is replaced, except by LIGHT_EFFECT_FINISH which only
+* moves its end to the end of the current cycle.
+*
+* @param  e       effect
+* @param  params  effect to start
+* @param  now_ms  current time
+*/
+void light_effect_start(light_effect_t *e, const light_effect_params_t *params, uint32_t now_ms);
+
+/**
+* @brief Apply the effect at a point in time to an output
+*
+* Blink, breathe, okay and channel change show at the output's level, or at
+* full level if it is off; the color loop keeps the level, so an off light
+* stays off. @p out is left alone once the effect has ended.
+*
+* @param  e       effect
+* @param  now_ms  current time
+* @param  out     output without the effect in, with the effect out
+* @return true while the effect is still running
+*/
+bool light_effect_step(light_effect_t *e, uint32_t now_ms, light_target_t *out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
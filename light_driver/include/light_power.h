@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "light_color.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Strip current model of the power limiter: a channel at 255 draws
+ * CONFIG_LIGHT_DRIVER_POWER_{RED,GREEN,BLUE}_MA and proportionally less
+ * below, every LED draws CONFIG_LIGHT_DRIVER_POWER_IDLE_MA on top. Loads are
+ * channel values times channel mA, i.e. in 1/255 mA, so estimating a frame
+ * takes sums and no division per pixel. */
+
+/**
+* @brief Load of a frame: the sum over all pixels of channel value times channel mA
+*
+* One integer pass, three running sums; at most 1024 pixels.
+*
+* @param  pixels  The frame
+* @param  count   Number of pixels
+*/
+uint32_t light_power_load(const light_rgb_t *pixels, uint32_t count);
+
+/**
+* @brief Load the channels of a strip may draw within a current budget
+*
+* @param  budget_ma  Current budget of the whole strip in mA
+* @param  led_count  Number of pixels, their idle current comes off the budget
+* @return 0 if the idle current alone exceeds the budget
+*/
+uint32_t light_power_budget_load(uint32_t budget_ma, uint32_t led_count);
+
+/**
+* @brief Channel scale that brings a frame within budget, for light_color_scale()
+*
+* Every channel of the frame scaled by it gives a load of at most budget_load.
+*
+* @param  load         Load of the frame, see light_power_load()
+* @param  budget_load  See light_power_budget_load()
+* @return UINT8_MAX if the frame is within budget as it is
+*/
+uint8_t light_power_scale(uint32_t load, uint32_t budget_load);
+
+/**
+* @brief Estimated strip current in mA, rounded up
+*
+* @param  load       Load of the frame, see light_power_load()
+* @param  led_count  Number of pixels
+*/
+static inline uint32_t light_power_ma(uint32_t load, uint32_t led_count)
+{
+    return (load + 254) / 255 + led_count * CONFIG_LIGHT_DRIVER_POWER_IDLE_MA;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
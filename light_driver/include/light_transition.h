@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "light_color.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Light output before level scaling: the color and the level (0 when off) */
+typedef struct {
+    light_rgb_t rgb;
+    uint8_t level;
+} light_target_t;
+
+/** Linear transition of color and level, integer only.
+ *  Time is passed in by the caller, so any clock (or a virtual one) works. */
+typedef struct {
+    uint16_t from[4];       /*!< r, g, b, level in Q8 */
+    uint16_t to[4];         /*!< r, g, b, level in Q8 */
+    uint32_t start_ms;
+    uint32_t duration_ms;
+    bool active;
+} light_transition_t;
+
+/**
+* @brief Set the transition to a fixed value, no interpolation
+*
+* @param  t      transition
+* @param  value  current output
+*/
+void light_transition_init(light_transition_t *t, const light_target_t *value);
+
+/**
+* @brief Start moving towards a new target
+*
+* A running transition is preempted: the new one starts from wherever the
+* output is at @p now_ms.
+*
+* @param  t            transition
+* @param  target       output to reach
+* @param  now_ms       current time
+* @param  duration_ms  transition time, 0 jumps to the target
+*/
+void light_transition_start(light_transition_t *t, const light_target_t *target, uint32_t now_ms, uint32_t duration_ms);
+
+/**
+* @brief Compute the output at a point in time
+*
+* @param  t       transition
+* @param  now_ms  current time
+* @param  out     output at @p now_ms
+* @return true while the transition is still running
+*/
+bool light_transition_step(light_transition_t *t, uint32_t now_ms, light_target_t *out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,200 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <stdbool.h>
+#include "light_color.h"
+#include "light_color_tables.h"
+
+_Static_assert(LIGHT_WAVE_POINTS == 256, "waveforms are indexed by the top byte of a 16-bit phase");
+_Static_assert(LIGHT_CT_TABLE_MIN_MIREDS == LIGHT_COLOR_CT_MIN_MIREDS && LIGHT_CT_TABLE_MAX_MIREDS == LIGHT_COLOR_CT_MAX_MIREDS,
+               "color temperature table range does not match light_color.h");
+
+/* linear RGB of the LEDs at chromaticity x, y, with the matrix generated from
+ * their primaries (CONFIG_LIGHT_DRIVER_LED_PRIMARIES). X:Y:Z = x:y:z, the
+ * brightness drops out in linear_to_rgb().
+ * @return false if a channel is negative, i.e. x, y is outside the LED gamut */
+static inline bool xy_to_linear(int32_t x, int32_t y, int64_t v[3])
+{
+    int64_t z = (int64_t)UINT16_MAX - x - y;
+    v[0] = LIGHT_XYZ_RX * (int64_t)x + LIGHT_XYZ_RY * (int64_t)y + LIGHT_XYZ_RZ * z;
+    v[1] = LIGHT_XYZ_GX * (int64_t)x + LIGHT_XYZ_GY * (int64_t)y + LIGHT_XYZ_GZ * z;
+    v[2] = LIGHT_XYZ_BX * (int64_t)x + LIGHT_XYZ_BY * (int64_t)y + LIGHT_XYZ_BZ * z;
+    return v[0] >= 0 && v[1] >= 0 && v[2] >= 0;
+}
+
+/* brightest channel to 255, the level does the dimming; negative channels
+ * (rounding at the gamut edge) are 0 */
+static void linear_to_rgb(const int64_t v[3], light_rgb_t *rgb)
+{
+    int64_t peak = v[0] > v[1] ? v[0] : v[1];
+    peak = peak > v[2] ? peak : v[2];
+    if (peak <= 0) {
+        rgb->r = rgb->g = rgb->b = 0;
+        return;
+    }
+    /* down to 23 bits, so the divides are 32-bit and v * 255 cannot overflow */
+    int shift = 64 - __builtin_clzll((uint64_t)peak) - 23;
+    shift = shift > 0 ? shift : 0;
+    uint32_t p = (uint32_t)(peak >> shift);
+    uint8_t out[3];
+    for (int c = 0; c < 3; c++) {
+        out[c] = v[c] <= 0 ? 0 : (uint8_t)(((uint32_t)(v[c] >> shift) * UINT8_MAX + p / 2) / p);
+    }
+    rgb->r = out[0];
+    rgb->g = out[1];
+    rgb->b = out[2];
+}
+
+/* point of the segment a-b nearest to p
+ * @return its squared distance to p */
+static int64_t gamut_edge_nearest(int32_t px, int32_t py, int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t *qx, int32_t *qy)
+{
+    int64_t dx = bx - ax;
+    int64_t dy = by - ay;
+    int64_t num = (px - ax) * dx + (py - ay) * dy;
+    int64_t den = dx * dx + dy * dy;
+    if (num <= 0) {
+        *qx = ax;
+        *qy = ay;
+    } else if (num >= den) {
+        *qx = bx;
+        *qy = by;
+    } else {
+        *qx = ax + (int32_t)(dx * num / den);
+        *qy = ay + (int32_t)(dy * num / den);
+    }
+    int64_t ex = px - *qx;
+    int64_t ey = py - *qy;
+    return ex * ex + ey * ey;
+}
+
+/* nearest point of the LED gamut triangle's edges, what Hue bulbs do with
+ * colors they cannot make */
+static void gamut_map(int32_t x, int32_t y, int32_t *gx, int32_t *gy)
+{
+    static const int32_t corners[4][2] = {
+        { LIGHT_GAMUT_RED_X, LIGHT_GAMUT_RED_Y },
+        { LIGHT_GAMUT_GREEN_X, LIGHT_GAMUT_GREEN_Y },
+        { LIGHT_GAMUT_BLUE_X, LIGHT_GAMUT_BLUE_Y },
+        { LIGHT_GAMUT_RED_X, LIGHT_GAMUT_RED_Y },
+    };
+    int64_t best = INT64_MAX;
+    for (int i = 0; i < 3; i++) {
+        int32_t qx, qy;
+        int64_t d = gamut_edge_nearest(x, y, corners[i][0], corners[i][1], corners[i + 1][0], corners[i + 1][1], &qx, &qy);
+        if (d < best) {
+            best = d;
+            *gx = qx;
+            *gy = qy;
+        }
+    }
+}
+
+void light_color_xy_to_rgb(uint16_t x, uint16_t y, light_rgb_t *rgb)
+{
+    int64_t v[3];
+    if (!xy_to_linear(x, y, v)) {
+        int32_t gx, gy;
+        gamut_map(x, y, &gx, &gy);
+        xy_to_linear(gx, gy, v);
+    }
+    linear_to_rgb(v, rgb);
+}
+
+void light_color_xy_to_rgb_lut(uint16_t x, uint16_t y, light_rgb_t *rgb)
+{
+    const int32_t shift = 16 - LIGHT_XY_GRID_BITS;
+    const int32_t one = 1 << shift;
+    const int32_t half = one >> 1;
+    int32_t fx = x & (one - 1);
+    int32_t fy = y & (one - 1);
+    const uint8_t *p0 = &light_xy_grid[((y >> shift) * LIGHT_XY_GRID_POINTS + (x >> shift)) * 3];
+    const uint8_t *p1 = p0 + LIGHT_XY_GRID_POINTS * 3;
+    uint8_t out[3];
+    for (int c = 0; c < 3; c++) {
+        int32_t top = (p0[c] * (one - fx) + p0[c + 3] * fx + half) >> shift;
+        int32_t bottom = (p1[c] * (one - fx) + p1[c + 3] * fx + half) >> shift;
+        int32_t v = (top * (one - fy) + bottom * fy + half) >> shift;
+        out[c] = v <= 0 ? 0 : (v >= UINT8_MAX ? UINT8_MAX : (uint8_t)v);
+    }
+    rgb->r = out[0];
+    rgb->g = out[1];
+    rgb->b = out[2];
+}
+
+void light_color_ct_to_rgb(uint16_t mireds, light_rgb_t *rgb)
+{
+    if (mireds < LIGHT_COLOR_CT_MIN_MIREDS) {
+        mireds = LIGHT_COLOR_CT_MIN_MIREDS;
+    } else if (mireds > LIGHT_COLOR_CT_MAX_MIREDS) {
+        mireds = LIGHT_COLOR_CT_MAX_MIREDS;
+    }
+    const uint32_t one = 1U << LIGHT_CT_TABLE_STEP_BITS;
+    uint32_t offset = mireds - LIGHT_COLOR_CT_MIN_MIREDS;
+    uint32_t frac = offset & (one - 1);
+    const uint8_t *p = &light_ct_table[(offset >> LIGHT_CT_TABLE_STEP_BITS) * 3];
+    rgb->r = (uint8_t)((p[0] * (one - frac) + p[3] * frac + one / 2) >> LIGHT_CT_TABLE_STEP_BITS);
+    rgb->g = (uint8_t)((p[1] * (one - frac) + p[4] * frac + one / 2) >> LIGHT_CT_TABLE_STEP_BITS);
+    rgb->b = (uint8_t)((p[2] * (one - frac) + p[5] * frac + one / 2) >> LIGHT_CT_TABLE_STEP_BITS);
+}
+
+uint8_t light_color_gamma(uint8_t level)
+{
+    return light_gamma_lut[level];
+}
+
+/* waveform point p and the next one, weighted by frac / 256 */
+static inline uint8_t light_wave_lerp(const uint8_t *p, const uint8_t *next, uint32_t frac)
+{
+    return (uint8_t)((*p * (256 - frac) + *next * frac + 128) >> 8);
+}
+
+void light_color_hue_wheel(uint16_t hue, light_rgb_t *rgb)
+{
+    const uint8_t *p = &light_hue_wheel[(hue >> 8) * 3];
+    const uint8_t *next = &light_hue_wheel[(((hue >> 8) + 1) & (LIGHT_WAVE_POINTS - 1)) * 3];
+    uint32_t frac = hue & 0xff;
+    rgb->r = light_wave_lerp(&p[0], &next[0], frac);
+    rgb->g = light_wave_lerp(&p[1], &next[1], frac);
+    rgb->b = light_wave_lerp(&p[2], &next[2], frac);
+}
+
+uint8_t light_color_breathe(uint16_t phase)
+{
+    return light_wave_lerp(&light_breathe[phase >> 8], &light_breathe[((phase >> 8) + 1) & (LIGHT_WAVE_POINTS - 1)], phase & 0xff);
+}
+
+void light_color_hsv_to_rgb(uint8_t hue, uint8_t sat, uint8_t val, light_rgb_t *rgb)
+{
+    if (sat == 0) { /* achromatic (grey) */
+        rgb->r = rgb->g = rgb->b = val;
+        return;
+    }
+    const uint32_t sector = UINT8_MAX / 6;
+    const uint32_t den = UINT8_MAX * sector;
+    uint32_t i = hue / sector; /* sector 0 to 6, 6 behaves as 5 */
+    uint32_t f = hue % sector;
+    uint8_t p = (uint8_t)(val * (UINT8_MAX - sat) / UINT8_MAX);
+    uint8_t q = (uint8_t)(val * (den - sat * f) / den);
+    uint8_t t = (uint8_t)(val * (den - sat * (sector - f)) / den);
+    switch (i) {
+    case 0: rgb->r = val; rgb->g = t; rgb->b = p; break;
+    case 1: rgb->r = q; rgb->g = val; rgb->b = p; break;
+    case 2: rgb->r = p; rgb->g = val; rgb->b = t; break;
+    case 3: rgb->r = p; rgb->g = q; rgb->b = val; break;
+    case 4: rgb->r = t; rgb->g = p; rgb->b = val; break;
+    case 5:
+    default: rgb->r = val; rgb->g = p; rgb->b = q; break;
+    }
+}
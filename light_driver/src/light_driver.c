@@ -13,77 +13,222 @@
  */
 
 
+#include "sdkconfig.h"
 #include "esp_log.h"
-#include "led_strip.h"
 #include "light_driver.h"
+#include "light_color.h"
+#include "light_render.h"
 
-static led_strip_handle_t s_led_strip;
-static uint8_t s_red = 255, s_green = 255, s_blue = 255, s_level = 255;
+typedef enum {
+    LIGHT_COLOR_RGB,
+    LIGHT_COLOR_XY,
+    LIGHT_COLOR_HUE_SAT,
+    LIGHT_COLOR_TEMPERATURE,
+} light_color_source_t;
 
-void light_driver_set_color_xy(uint16_t color_current_x, uint16_t color_current_y)
+/* light state of one segment as set by the setters, rendered by
+ * light_driver_commit(); ordered by size, 28 bytes */
+typedef struct {
+    uint32_t transition_ms;
+    light_effect_params_t effect;   /*!< Valid with effect_dirty */
+    uint16_t color_x;
+    uint16_t color_y;
+    uint16_t mireds;
+    light_rgb_t rgb;
+    uint8_t level;
+    uint8_t source;         /*!< light_color_source_t */
+    uint8_t hue;
+    uint8_t sat;
+    bool power;
+    bool dirty;
+    bool effect_dirty;
+} light_state_t;
+
+static light_state_t s_state[LIGHT_DRIVER_SEGMENTS_MAX] = {
+    [0 ... LIGHT_DRIVER_SEGMENTS_MAX - 1] = {
+        .level = 255,
+        .source = LIGHT_COLOR_RGB,
+        .rgb = { .r = 255, .g = 255, .b = 255 },
+    },
+};
+static uint8_t s_segment_count = LIGHT_DRIVER_SEGMENTS_MAX;
+
+/* resolve the color source, conversions run once per commit */
+static void light_driver_resolve_color(light_state_t *state)
+{
+    switch (state->source) {
+    case LIGHT_COLOR_XY:
+        /* assume color_Y is full light level value 1, linear RGB NOT sRGB */
+#if CONFIG_LIGHT_DRIVER_COLOR_LUT
+        light_color_xy_to_rgb_lut(state->color_x, state->color_y, &state->rgb);
+#else
+        light_color_xy_to_rgb(state->color_x, state->color_y, &state->rgb);
+#endif
+        break;
+    case LIGHT_COLOR_HUE_SAT:
+        light_color_hsv_to_rgb(state->hue, state->sat, UINT8_MAX, &state->rgb);
+        break;
+    case LIGHT_COLOR_TEMPERATURE:
+        light_color_ct_to_rgb(state->mireds, &state->rgb);
+        break;
+    case LIGHT_COLOR_RGB:
+    default:
+        break;
+    }
+    state->source = LIGHT_COLOR_RGB;
+}
+
+/* NULL for segments out of range, so the setters ignore them */
+static light_state_t *light_driver_segment(uint8_t segment)
+{
+    return segment < s_segment_count ? &s_state[segment] : NULL;
+}
+
+esp_err_t light_driver_commit(void)
 {
-    float red_f = 0, green_f = 0, blue_f = 0, color_x, color_y;
-    color_x = (float)color_current_x / 65535;
-    color_y = (float)color_current_y / 65535;
-    /* assume color_Y is full light level value 1  (0-1.0) */
-    float color_X = color_x / color_y;
-    float color_Z = (1 - color_x - color_y) / color_y;
-    /* change from xy to linear RGB NOT sRGB */
-    XYZ_to_RGB(color_X, 1, color_Z, red_f, green_f, blue_f);
-    float ratio = (float)s_level / 255;
-    s_red = (uint8_t)(red_f * (float)255);
-    s_green = (uint8_t)(green_f * (float)255);
-    s_blue = (uint8_t)(blue_f * (float)255);
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, s_red * ratio, s_green * ratio, s_blue * ratio));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    light_render_cmd_t cmds[LIGHT_DRIVER_SEGMENTS_MAX];
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < s_segment_count; i++) {
+        light_state_t *state = &s_state[i];
+        if (!state->dirty && !state->effect_dirty) {
+            continue;
+        }
+        light_driver_resolve_color(state);
+        cmds[count++] = (light_render_cmd_t) {
+            .target = {
+                .rgb = state->rgb,
+                .level = state->power ? state->level : 0,
+            },
+            .transition_ms = state->transition_ms,
+            .effect = state->effect,
+            .segment = i,
+            .flags = (state->dirty ? LIGHT_RENDER_CMD_TARGET : 0) | (state->effect_dirty ? LIGHT_RENDER_CMD_EFFECT : 0),
+        };
+    }
+    if (!count) {
+        return ESP_OK;
+    }
+    if (!light_render_submit(cmds, count)) {
+        /* states stay dirty, the next commit carries them */
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        s_state[cmds[i].segment].dirty = false;
+        s_state[cmds[i].segment].effect_dirty = false;
+        s_state[cmds[i].segment].transition_ms = 0;
+    }
+    return ESP_OK;
 }
 
-void light_driver_set_color_hue_sat(uint8_t hue, uint8_t sat)
+#if CONFIG_LIGHT_DRIVER_STREAM
+uint8_t *light_driver_stream_buffer(uint16_t *led_count)
 {
-    float red_f, green_f, blue_f;
-    HSV_to_RGB(hue, sat, UINT8_MAX, red_f, green_f, blue_f);
-    float ratio = (float)s_level / 255;
-    s_red = (uint8_t)red_f;
-    s_green = (uint8_t)green_f;
-    s_blue = (uint8_t)blue_f;
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, s_red * ratio, s_green * ratio, s_blue * ratio));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    return light_render_stream_claim(led_count);
 }
 
-void light_driver_set_color_RGB(uint8_t red, uint8_t green, uint8_t blue)
+esp_err_t light_driver_stream_show(void)
 {
-    float ratio = (float)s_level / 255;
-    s_red = red;
-    s_green = green;
-    s_blue = blue;
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, red * ratio, green * ratio, blue * ratio));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    return light_render_stream_show() ? ESP_OK : ESP_ERR_NO_MEM;
 }
+#endif
 
-void light_driver_set_power(bool power)
+void light_driver_get_stats(light_driver_stats_t *stats)
 {
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, s_red * power, s_green * power, s_blue * power));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    light_render_get_stats(stats);
 }
 
-void light_driver_set_level(uint8_t level)
+void light_driver_set_color_xy(uint8_t segment, uint16_t color_current_x, uint16_t color_current_y)
 {
-    s_level = level;
-    float ratio = (float)s_level / 255;
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, s_red * ratio, s_green * ratio, s_blue * ratio));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    light_state_t *state = light_driver_segment(segment);
+    if (state) {
+        state->color_x = color_current_x;
+        state->color_y = color_current_y;
+        state->source = LIGHT_COLOR_XY;
+        state->dirty = true;
+    }
 }
 
-void light_driver_init(bool power)
+void light_driver_set_color_hue_sat(uint8_t segment, uint8_t hue, uint8_t sat)
 {
-    led_strip_config_t led_strip_conf = {
-        .max_leds = CONFIG_EXAMPLE_STRIP_LED_NUMBER,
-        .strip_gpio_num = CONFIG_EXAMPLE_STRIP_LED_GPIO,
-    };
-    led_strip_rmt_config_t rmt_conf = {
-        .resolution_hz = 10 * 1000 * 1000, // 10MHz
-    };
-    ESP_ERROR_CHECK(led_strip_new_rmt_device(&led_strip_conf, &rmt_conf, &s_led_strip));
+    light_state_t *state = light_driver_segment(segment);
+    if (state) {
+        state->hue = hue;
+        state->sat = sat;
+        state->source = LIGHT_COLOR_HUE_SAT;
+        state->dirty = true;
+    }
+}
+
+void light_driver_set_color_temperature(uint8_t segment, uint16_t mireds)
+{
+    light_state_t *state = light_driver_segment(segment);
+    if (state) {
+        state->mireds = mireds;
+        state->source = LIGHT_COLOR_TEMPERATURE;
+        state->dirty = true;
+    }
+}
 
-    light_driver_set_power(power);
+void light_driver_set_color_RGB(uint8_t segment, uint8_t red, uint8_t green, uint8_t blue)
+{
+    light_state_t *state = light_driver_segment(segment);
+    if (state) {
+        state->rgb.r = red;
+        state->rgb.g = green;
+        state->rgb.b = blue;
+        state->source = LIGHT_COLOR_RGB;
+        state->dirty = true;
+    }
+}
+
+void light_driver_set_power(uint8_t segment, bool power)
+{
+    light_state_t *state = light_driver_segment(segment);
+    if (state) {
+        state->power = power;
+        state->dirty = true;
+    }
+}
+
+void light_driver_set_level(uint8_t segment, uint8_t level)
+{
+    light_state_t *state = light_driver_segment(segment);
+    if (state) {
+        state->level = level;
+        state->dirty = true;
+    }
+}
+
+void light_driver_set_transition(uint8_t segment, uint32_t transition_ms)
+{
+    light_state_t *state = light_driver_segment(segment);
+    if (state) {
+        state->transition_ms = transition_ms;
+    }
+}
+
+void light_driver_set_effect(uint8_t segment, const light_effect_params_t *effect)
+{
+    light_state_t *state = light_driver_segment(segment);
+    if (state) {
+        state->effect = *effect;
+        state->effect_dirty = true;
+    }
+}
+
+void light_driver_init(void)
+{
+    light_driver_config_t config = LIGHT_DRIVER_DEFAULT_CONFIG();
+    light_driver_init_with_config(&config);
+}
+
+void light_driver_init_with_config(const light_driver_config_t *config)
+{
+    ESP_ERROR_CHECK(light_render_init(config));
+    s_segment_count = config->segment_count;
+    for (uint8_t i = 0; i < s_segment_count; i++) {
+        /* the first frame shows every segment, set or not */
+        s_state[i].dirty = true;
+    }
+    light_driver_commit();
 }
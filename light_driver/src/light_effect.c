@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "light_effect.h"
+
+#define EFFECT_CYCLE_MS             1000
+#define EFFECT_CHANNEL_CHANGE_MS    8000
+
+static const light_rgb_t s_okay_rgb = { .r = 0, .g = 255, .b = 0 };
+static const light_rgb_t s_channel_change_rgb = { .r = 255, .g = 96, .b = 0 };
+
+static uint32_t effect_cycle_ms(const light_effect_params_t *params)
+{
+    switch (params->id) {
+    case LIGHT_EFFECT_CHANNEL_CHANGE:
+        return EFFECT_CHANNEL_CHANGE_MS;
+    case LIGHT_EFFECT_COLORLOOP:
+        return (params->period_s ? params->period_s : 1) * 1000U;
+    default:
+        return EFFECT_CYCLE_MS;
+    }
+}
+
+void light_effect_start(light_effect_t *e, const light_effect_params_t *params, uint32_t now_ms)
+{
+    if (params->id == LIGHT_EFFECT_FINISH) {
+        if (e->active) {
+            uint32_t cycle = effect_cycle_ms(&e->params);
+            uint32_t end = now_ms + cycle - (now_ms - e->start_ms) % cycle;
+            if (!e->ends || (int32_t)(end - e->end_ms) < 0) {
+                e->end_ms = end;
+                e->ends = true;
+            }
+        }
+        return;
+    }
+    e->params = *params;
+    e->start_ms = now_ms;
+    e->active = params->id != LIGHT_EFFECT_NONE && params->id != LIGHT_EFFECT_COLORLOOP_STOP;
+    switch (params->id) {
+    case LIGHT_EFFECT_BLINK:
+    case LIGHT_EFFECT_BREATHE:
+        e->ends = params->cycles > 0;
+        e->end_ms = now_ms + params->cycles * EFFECT_CYCLE_MS;
+        break;
+    case LIGHT_EFFECT_OKAY:
+    case LIGHT_EFFECT_CHANNEL_CHANGE:
+        e->ends = true;
+        e->end_ms = now_ms + effect_cycle_ms(params);
+        break;
+    default:
+        e->ends = false;
+        break;
+    }
+}
+
+bool light_effect_step(light_effect_t *e, uint32_t now_ms, light_target_t *out)
+{
+    if (!e->active) {
+        return false;
+    }
+    if (e->ends && (int32_t)(now_ms - e->end_ms) >= 0) {
+        e->active = false;
+        return false;
+    }
+    uint32_t elapsed = now_ms - e->start_ms;
+    uint32_t cycle = effect_cycle_ms(&e->params);
+    /* position in the current cycle, one cycle per 0x10000 */
+    uint16_t phase = (uint16_t)(((uint64_t)(elapsed % cycle) << 16) / cycle);
+    /* identify effects must show on a light that is off */
+    uint8_t level = out->level ? out->level : UINT8_MAX;
+    switch (e->params.id) {
+    case LIGHT_EFFECT_BLINK:
+        out->level = phase < 0x8000 ? level : 0;
+        break;
+    case LIGHT_EFFECT_BREATHE:
+        out->level = light_color_scale(level, light_color_breathe(phase));
+        break;
+    case LIGHT_EFFECT_OKAY:
+        out->rgb = s_okay_rgb;
+        out->level = level;
+        break;
+    case LIGHT_EFFECT_CHANNEL_CHANGE:
+        out->rgb = s_channel_change_rgb;
+        out->level = level;
+        break;
+    case LIGHT_EFFECT_COLORLOOP:
+        light_color_hue_wheel(e->params.reverse ? e->params.start_hue - phase : e->params.start_hue + phase, &out->rgb);
+        break;
+    default:
+        break;
+    }
+    return true;
+}
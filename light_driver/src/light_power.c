@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "light_driver.h"
+#include "light_power.h"
+
+/* the largest load, 1024 pixels at 255 and 100 mA per channel, fits 32 bits */
+_Static_assert(LIGHT_DRIVER_LED_COUNT_MAX <= 1024, "light_power_load() sums at most 1024 pixels");
+
+uint32_t light_power_load(const light_rgb_t *pixels, uint32_t count)
+{
+    /* no multiply in the loop: the channel currents apply to the sums */
+    uint32_t r = 0, g = 0, b = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        r += pixels[i].r;
+        g += pixels[i].g;
+        b += pixels[i].b;
+    }
+    return r * CONFIG_LIGHT_DRIVER_POWER_RED_MA + g * CONFIG_LIGHT_DRIVER_POWER_GREEN_MA + b * CONFIG_LIGHT_DRIVER_POWER_BLUE_MA;
+}
+
+uint32_t light_power_budget_load(uint32_t budget_ma, uint32_t led_count)
+{
+    uint32_t idle_ma = led_count * CONFIG_LIGHT_DRIVER_POWER_IDLE_MA;
+    return budget_ma > idle_ma ? (budget_ma - idle_ma) * 255 : 0;
+}
+
+uint8_t light_power_scale(uint32_t load, uint32_t budget_load)
+{
+    if (load <= budget_load) {
+        return UINT8_MAX;
+    }
+    /* light_color_scale() truncates every channel, so the scaled load stays
+     * at or below load * scale / 255 */
+    return (uint8_t)((uint64_t)budget_load * 255 / load);
+}
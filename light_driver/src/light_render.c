@@ -0,0 +1,453 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "led_strip.h"
+#include "light_power.h"
+#include "light_render.h"
+
+static const char *TAG = "LIGHT_RENDER";
+
+/* pixel range of a segment in the frame */
+typedef struct {
+    uint16_t first;
+    uint16_t count;
+} light_segment_range_t;
+
+/* counters of light_driver_stats_t, each with a single writer: the render
+ * context, or for the queue ones the producer. Other tasks read them through
+ * light_render_get_stats(), so they are atomic words; a single writer needs
+ * no read-modify-write, see light_render_count() */
+typedef struct {
+    atomic_uint frames;
+    atomic_uint frames_done;
+    atomic_uint refresh_us_max;
+    atomic_uint refresh_hist[LIGHT_DRIVER_HIST_BUCKETS];
+    atomic_uint wait_us;
+    atomic_uint overwritten;
+    atomic_uint power_limited;
+    atomic_uint power_ma_max;
+} light_render_counters_t;
+
+typedef struct {
+    atomic_uint queued;
+    atomic_uint dropped;
+    atomic_uint queue_high_water;
+} light_submit_counters_t;
+
+/* two frame buffers: the one being rendered (s_frame or s_stream) and the
+ * strip's own, being clocked out meanwhile with CONFIG_LIGHT_DRIVER_LED_ASYNC */
+static led_strip_handle_t s_led_strip;
+static light_rgb_t s_frame[LIGHT_DRIVER_LED_COUNT_MAX];
+static uint16_t s_led_count;
+static uint16_t s_power_budget_ma;  /* 0: frames go out as rendered */
+static uint32_t s_power_budget_load;
+static light_render_counters_t s_render_stats;    /* render context only */
+static light_submit_counters_t s_submit_stats;    /* light_render_submit() only */
+static light_driver_frame_done_cb_t s_on_frame_done;
+static void *s_user_ctx;
+static int64_t s_wire_start_us;     /* transfer of frame s_render_stats.frames started */
+static bool s_in_flight;            /* render context only: a frame is being clocked out */
+static uint8_t s_segment_count;
+static light_segment_range_t s_segments[LIGHT_DRIVER_SEGMENTS_MAX];
+static light_transition_t s_transitions[LIGHT_DRIVER_SEGMENTS_MAX];
+static light_effect_t s_color_loops[LIGHT_DRIVER_SEGMENTS_MAX];
+static light_effect_t s_effects[LIGHT_DRIVER_SEGMENTS_MAX];     /* on top of the color loop */
+#if CONFIG_LIGHT_DRIVER_STREAM
+_Static_assert(sizeof(light_rgb_t) == 3, "the stream buffer is packed r, g, b");
+static light_rgb_t s_stream[LIGHT_DRIVER_LED_COUNT_MAX];
+static atomic_bool s_stream_busy;   /* shown, not yet rendered; the writer keeps off */
+static bool s_streaming;            /* render context only: the stream buffer replaces the segments */
+#endif
+
+static inline uint32_t light_render_read(atomic_uint *counter)
+{
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+/* the writer's own increment, readers see the old or the new value */
+static inline void light_render_count(atomic_uint *counter, uint32_t n)
+{
+    atomic_store_explicit(counter, light_render_read(counter) + n, memory_order_relaxed);
+}
+
+static inline void light_render_count_max(atomic_uint *counter, uint32_t value)
+{
+    if (value > light_render_read(counter)) {
+        atomic_store_explicit(counter, value, memory_order_relaxed);
+    }
+}
+
+static void light_render_fill(const light_segment_range_t *segment, light_rgb_t color)
+{
+    for (uint32_t i = segment->first; i < segment->first + segment->count; i++) {
+        s_frame[i] = color;
+    }
+}
+
+/* wait until the frame in flight is on the strip, then report it done */
+static void light_render_wait_done(void)
+{
+    if (!s_in_flight) {
+        return;
+    }
+    int64_t start = esp_timer_get_time();
+#if CONFIG_LIGHT_DRIVER_LED_ASYNC
+    ESP_ERROR_CHECK(led_strip_refresh_wait_done(s_led_strip));
+#else
+    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+#endif
+    int64_t end = esp_timer_get_time();
+    uint32_t wait_us = (uint32_t)(end - start);
+    light_render_count(&s_render_stats.refresh_hist[light_driver_hist_bucket(wait_us, LIGHT_DRIVER_REFRESH_HIST_BASE_BITS)], 1);
+    light_render_count_max(&s_render_stats.refresh_us_max, wait_us);
+    light_render_count(&s_render_stats.wait_us, wait_us);
+    light_render_count(&s_render_stats.frames_done, 1);
+    s_in_flight = false;
+    if (s_on_frame_done) {
+        s_on_frame_done(light_render_read(&s_render_stats.frames), (uint32_t)(end - s_wire_start_us), s_user_ctx);
+    }
+}
+
+/* channel scale that keeps the frame within the power budget, UINT8_MAX if it is */
+static uint8_t light_render_power_limit(const light_rgb_t *frame)
+{
+    if (!s_power_budget_ma) {
+        return UINT8_MAX;
+    }
+    uint32_t load = light_power_load(frame, s_led_count);
+    light_render_count_max(&s_render_stats.power_ma_max, light_power_ma(load, s_led_count));
+    uint8_t scale = light_power_scale(load, s_power_budget_load);
+    light_render_count(&s_render_stats.power_limited, scale != UINT8_MAX);
+    return scale;
+}
+
+/* push a frame buffer to the strip, one refresh per frame; without
+ * CONFIG_LIGHT_DRIVER_LED_ASYNC this waits for the transfer, with it only
+ * for the previous one, and frame may be rendered into again on return.
+ * A frame over the power budget is scaled on the way, the buffer keeps it
+ * as rendered (the stream buffer must not change) */
+static void light_render_flush(const light_rgb_t *frame)
+{
+    uint8_t scale = light_render_power_limit(frame);
+    light_render_wait_done();
+    if (scale == UINT8_MAX) {
+        for (uint32_t i = 0; i < s_led_count; i++) {
+            ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, i, frame[i].r, frame[i].g, frame[i].b));
+        }
+    } else {
+        for (uint32_t i = 0; i < s_led_count; i++) {
+            ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, i, light_color_scale(frame[i].r, scale),
+                                                light_color_scale(frame[i].g, scale), light_color_scale(frame[i].b, scale)));
+        }
+    }
+    light_render_count(&s_render_stats.frames, 1);
+    s_wire_start_us = esp_timer_get_time();
+    s_in_flight = true;
+#if CONFIG_LIGHT_DRIVER_LED_ASYNC
+    ESP_ERROR_CHECK(led_strip_refresh_async(s_led_strip));
+#else
+    light_render_wait_done();
+#endif
+}
+
+static uint32_t light_render_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static bool light_render_is_color_loop(const light_effect_params_t *params)
+{
+    return params->id == LIGHT_EFFECT_COLORLOOP || params->id == LIGHT_EFFECT_COLORLOOP_STOP;
+}
+
+/* the color loop has its own layer, so identify effects leave it running */
+static void light_render_effect_start(uint8_t segment, const light_effect_params_t *params, uint32_t now_ms)
+{
+    light_effect_start(light_render_is_color_loop(params) ? &s_color_loops[segment] : &s_effects[segment], params, now_ms);
+}
+
+/* render every segment at now_ms into one frame
+ * @return true while any segment is still in transition or running an effect */
+static bool light_render_frame(uint32_t now_ms)
+{
+#if CONFIG_LIGHT_DRIVER_STREAM
+    if (s_streaming) {
+        /* segment transitions are not shown meanwhile, they resume where their clock is */
+        light_render_flush(s_stream);
+        return false;
+    }
+#endif
+    bool active = false;
+    for (uint8_t i = 0; i < s_segment_count; i++) {
+        light_target_t output;
+        active |= light_transition_step(&s_transitions[i], now_ms, &output);
+        active |= light_effect_step(&s_color_loops[i], now_ms, &output);
+        active |= light_effect_step(&s_effects[i], now_ms, &output);
+        uint8_t scale = light_color_gamma(output.level);
+        light_rgb_t color = {
+            .r = light_color_scale(output.rgb.r, scale),
+            .g = light_color_scale(output.rgb.g, scale),
+            .b = light_color_scale(output.rgb.b, scale),
+        };
+        light_render_fill(&s_segments[i], color);
+    }
+    light_render_flush(s_frame);
+    return active;
+}
+
+#if CONFIG_LIGHT_DRIVER_RENDER_TASK
+
+#define RENDER_QUEUE_DEPTH CONFIG_LIGHT_DRIVER_RENDER_QUEUE_DEPTH
+_Static_assert((RENDER_QUEUE_DEPTH & (RENDER_QUEUE_DEPTH - 1)) == 0, "render queue depth must be a power of two");
+_Static_assert(RENDER_QUEUE_DEPTH >= LIGHT_DRIVER_SEGMENTS_MAX, "a commit of every segment must fit the render queue");
+_Static_assert(LIGHT_DRIVER_SEGMENTS_MAX <= 32, "the render task tracks segments in a 32-bit mask");
+
+/* single producer (light_driver_commit caller), single consumer (render task);
+ * head and tail run freely and are masked on access */
+static light_render_cmd_t s_queue[RENDER_QUEUE_DEPTH];
+static atomic_uint s_queue_head;
+static atomic_uint s_queue_tail;
+static TaskHandle_t s_render_task;
+static StackType_t s_render_task_stack[CONFIG_LIGHT_DRIVER_RENDER_TASK_STACK_SIZE];
+static StaticTask_t s_render_task_tcb;
+
+bool light_render_submit(const light_render_cmd_t *cmds, uint8_t count)
+{
+    unsigned head = atomic_load_explicit(&s_queue_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&s_queue_tail, memory_order_acquire);
+    if (head - tail > RENDER_QUEUE_DEPTH - count) {
+        light_render_count(&s_submit_stats.dropped, count);
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        s_queue[(head + i) & (RENDER_QUEUE_DEPTH - 1)] = cmds[i];
+    }
+    /* published together, the render task sees all of them or none */
+    atomic_store_explicit(&s_queue_head, head + count, memory_order_release);
+    light_render_count(&s_submit_stats.queued, count);
+    light_render_count_max(&s_submit_stats.queue_high_water, head + count - tail);
+    xTaskNotifyGive(s_render_task);
+    return true;
+}
+
+static void light_render_task(void *arg)
+{
+    const TickType_t frame_ticks = pdMS_TO_TICKS(1000 / CONFIG_LIGHT_DRIVER_TRANSITION_FPS);
+    TickType_t wait = portMAX_DELAY;
+    bool active = false;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, wait);
+        uint32_t now = light_render_now_ms();
+        unsigned tail = atomic_load_explicit(&s_queue_tail, memory_order_relaxed);
+        unsigned head = atomic_load_explicit(&s_queue_head, memory_order_acquire);
+        /* every command is a whole target and/or a whole effect, only the newest
+         * one of each per segment matters; the color loop counts apart */
+        uint32_t seen = 0;
+        uint32_t seen_effect = 0;
+        uint32_t seen_loop = 0;
+        bool stream = false;
+        for (unsigned i = head; i != tail; i--) {
+            const light_render_cmd_t *cmd = &s_queue[(i - 1) & (RENDER_QUEUE_DEPTH - 1)];
+#if CONFIG_LIGHT_DRIVER_STREAM
+            /* the newest command decides: a stream frame replaces the segments, a segment command ends streaming */
+            if (cmd->segment == LIGHT_RENDER_SEGMENT_STREAM) {
+                s_streaming |= !seen && !seen_effect && !seen_loop && !stream;
+                stream = true;
+                continue;
+            }
+            s_streaming &= seen || seen_effect || seen_loop || stream;
+#endif
+            uint32_t bit = 1UL << cmd->segment;
+            uint32_t *seen_layer = light_render_is_color_loop(&cmd->effect) ? &seen_loop : &seen_effect;
+            bool target = (cmd->flags & LIGHT_RENDER_CMD_TARGET) && !(seen & bit);
+            bool effect = (cmd->flags & LIGHT_RENDER_CMD_EFFECT) && !(*seen_layer & bit);
+            if (!target && !effect) {
+                light_render_count(&s_render_stats.overwritten, 1);
+                continue;
+            }
+            if (target) {
+                seen |= bit;
+                light_transition_start(&s_transitions[cmd->segment], &cmd->target, now, cmd->transition_ms);
+            }
+            if (effect) {
+                *seen_layer |= bit;
+                light_render_effect_start(cmd->segment, &cmd->effect, now);
+            }
+        }
+        atomic_store_explicit(&s_queue_tail, head, memory_order_release);
+        if (!seen && !seen_effect && !seen_loop && !stream && !active) {
+            /* woken without a new target and nothing is moving: the frame in flight is due */
+            light_render_wait_done();
+            wait = portMAX_DELAY;
+            continue;
+        }
+        active = light_render_frame(now);
+#if CONFIG_LIGHT_DRIVER_STREAM
+        if (stream) {
+            atomic_store_explicit(&s_stream_busy, false, memory_order_release);
+        }
+#endif
+        /* a frame in flight is reported done a tick later at the latest */
+        wait = active ? frame_ticks : s_in_flight ? 1 : portMAX_DELAY;
+    }
+}
+
+#else
+
+/* without the render task there is nobody to run transitions, jump instead;
+ * effects show their first frame only. A frame is seen done when the next one starts */
+bool light_render_submit(const light_render_cmd_t *cmds, uint8_t count)
+{
+    uint32_t now = light_render_now_ms();
+    for (uint8_t i = 0; i < count; i++) {
+#if CONFIG_LIGHT_DRIVER_STREAM
+        s_streaming = cmds[i].segment == LIGHT_RENDER_SEGMENT_STREAM;
+        if (s_streaming) {
+            continue;
+        }
+#endif
+        if (cmds[i].flags & LIGHT_RENDER_CMD_TARGET) {
+            light_transition_start(&s_transitions[cmds[i].segment], &cmds[i].target, now, 0);
+        }
+        if (cmds[i].flags & LIGHT_RENDER_CMD_EFFECT) {
+            light_render_effect_start(cmds[i].segment, &cmds[i].effect, now);
+        }
+    }
+    light_render_frame(now);
+#if CONFIG_LIGHT_DRIVER_STREAM
+    atomic_store_explicit(&s_stream_busy, false, memory_order_release);
+#endif
+    return true;
+}
+
+#endif
+
+#if CONFIG_LIGHT_DRIVER_STREAM
+uint8_t *light_render_stream_claim(uint16_t *led_count)
+{
+    *led_count = s_led_count;
+    if (atomic_load_explicit(&s_stream_busy, memory_order_acquire)) {
+        return NULL;
+    }
+    return (uint8_t *)s_stream;
+}
+
+bool light_render_stream_show(void)
+{
+    const light_render_cmd_t cmd = {
+        .segment = LIGHT_RENDER_SEGMENT_STREAM,
+    };
+    atomic_store_explicit(&s_stream_busy, true, memory_order_relaxed);
+    if (!light_render_submit(&cmd, 1)) {
+        atomic_store_explicit(&s_stream_busy, false, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+#endif
+
+void light_render_get_stats(light_driver_stats_t *stats)
+{
+    *stats = (light_driver_stats_t) {
+        .frames = light_render_read(&s_render_stats.frames),
+        .frames_done = light_render_read(&s_render_stats.frames_done),
+        .refresh_us_max = light_render_read(&s_render_stats.refresh_us_max),
+        .wait_us = light_render_read(&s_render_stats.wait_us),
+        .queued = light_render_read(&s_submit_stats.queued),
+        .dropped = light_render_read(&s_submit_stats.dropped),
+        .overwritten = light_render_read(&s_render_stats.overwritten),
+        .power_limited = light_render_read(&s_render_stats.power_limited),
+        .power_ma_max = light_render_read(&s_render_stats.power_ma_max),
+        .queue_high_water = (uint16_t)light_render_read(&s_submit_stats.queue_high_water),
+    };
+    for (int i = 0; i < LIGHT_DRIVER_HIST_BUCKETS; i++) {
+        stats->refresh_hist[i] = light_render_read(&s_render_stats.refresh_hist[i]);
+    }
+#if CONFIG_LIGHT_DRIVER_RENDER_TASK
+    stats->queue_depth = atomic_load(&s_queue_head) - atomic_load(&s_queue_tail);
+#endif
+}
+
+esp_err_t light_render_init(const light_driver_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(config->led_count >= 1 && config->led_count <= LIGHT_DRIVER_LED_COUNT_MAX, ESP_ERR_INVALID_ARG, TAG,
+                        "%d LEDs do not fit the frame buffers (at most %d)", config->led_count, LIGHT_DRIVER_LED_COUNT_MAX);
+    ESP_RETURN_ON_FALSE(config->segment_count >= 1 && config->segment_count <= LIGHT_DRIVER_SEGMENTS_MAX &&
+                        config->segment_count <= config->led_count, ESP_ERR_INVALID_ARG, TAG,
+                        "%d segments do not fit %d LEDs (at most %d)", config->segment_count, config->led_count, LIGHT_DRIVER_SEGMENTS_MAX);
+    /* a budget the dark strip already takes would scale every frame to black */
+    ESP_RETURN_ON_FALSE(!config->power_budget_ma || light_power_budget_load(config->power_budget_ma, config->led_count), ESP_ERR_INVALID_ARG,
+                        TAG, "Power budget %d mA leaves nothing above the %d mA of %d dark LEDs", config->power_budget_ma,
+                        config->led_count * CONFIG_LIGHT_DRIVER_POWER_IDLE_MA, config->led_count);
+    const light_target_t off = { 0 };
+    s_led_count = config->led_count;
+    s_power_budget_ma = config->power_budget_ma;
+    s_power_budget_load = light_power_budget_load(config->power_budget_ma, config->led_count);
+    s_on_frame_done = config->on_frame_done;
+    s_user_ctx = config->user_ctx;
+    s_segment_count = config->segment_count;
+    uint16_t per_segment = s_led_count / s_segment_count;
+    for (uint8_t i = 0; i < s_segment_count; i++) {
+        light_transition_init(&s_transitions[i], &off);
+        s_color_loops[i] = (light_effect_t) { 0 };
+        s_effects[i] = (light_effect_t) { 0 };
+        s_segments[i].first = i * per_segment;
+        s_segments[i].count = i + 1 < s_segment_count ? per_segment : s_led_count - i * per_segment;
+    }
+    ESP_LOGI(TAG, "%d segments of %d LEDs, %d bytes of render state each", s_segment_count, per_segment,
+             (int)(sizeof(light_segment_range_t) + sizeof(light_transition_t) + 2 * sizeof(light_effect_t)));
+    if (s_power_budget_ma) {
+        const light_rgb_t white = { .r = 255, .g = 255, .b = 255 };
+        ESP_LOGI(TAG, "Power budget %d mA, full white draws %d mA", s_power_budget_ma,
+                 (int)light_power_ma(light_power_load(&white, 1) * s_led_count, s_led_count));
+    }
+    led_strip_config_t led_strip_conf = {
+        .max_leds = config->led_count,
+        .strip_gpio_num = config->gpio,
+    };
+#if CONFIG_LIGHT_DRIVER_LED_SPI
+    led_strip_spi_config_t spi_conf = {
+        .clk_src = SPI_CLK_SRC_DEFAULT,
+        .spi_bus = SPI2_HOST,
+#if CONFIG_LIGHT_DRIVER_LED_DMA
+        .flags.with_dma = true,
+#endif
+    };
+    ESP_RETURN_ON_ERROR(led_strip_new_spi_device(&led_strip_conf, &spi_conf, &s_led_strip), TAG, "Failed to create LED strip");
+#else
+    led_strip_rmt_config_t rmt_conf = {
+        .resolution_hz = 10 * 1000 * 1000, // 10MHz
+#if CONFIG_LIGHT_DRIVER_LED_DMA
+        /* a DMA buffer this large needs a fraction of the encoder refills per frame */
+        .mem_block_symbols = 1024,
+        .flags.with_dma = true,
+#endif
+    };
+    ESP_RETURN_ON_ERROR(led_strip_new_rmt_device(&led_strip_conf, &rmt_conf, &s_led_strip), TAG, "Failed to create LED strip");
+#endif
+#if CONFIG_LIGHT_DRIVER_RENDER_TASK
+    s_render_task = xTaskCreateStaticPinnedToCore(light_render_task, "light_render", CONFIG_LIGHT_DRIVER_RENDER_TASK_STACK_SIZE, NULL,
+                                                  CONFIG_LIGHT_DRIVER_RENDER_TASK_PRIORITY, s_render_task_stack, &s_render_task_tcb,
+                                                  CONFIG_LIGHT_DRIVER_RENDER_TASK_CORE);
+    ESP_RETURN_ON_FALSE(s_render_task, ESP_ERR_INVALID_STATE, TAG, "Failed to create render task");
+#endif
+    return ESP_OK;
+}
@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "light_color.h"
+#include "light_driver.h"
+#include "light_effect.h"
+#include "light_transition.h"
+
+/** segment of the command that shows the stream buffer */
+#define LIGHT_RENDER_SEGMENT_STREAM UINT8_MAX
+
+/** light_render_cmd_t::flags, what the command carries */
+#define LIGHT_RENDER_CMD_TARGET     0x01
+#define LIGHT_RENDER_CMD_EFFECT     0x02
+
+/** New output of one segment, queued from light_driver_commit() */
+typedef struct {
+    uint32_t transition_ms;         /*!< Time to reach it, 0 jumps */
+    light_target_t target;          /*!< Color and level to reach */
+    light_effect_params_t effect;   /*!< Effect to start */
+    uint8_t segment;                /*!< Segment index, or LIGHT_RENDER_SEGMENT_STREAM */
+    uint8_t flags;                  /*!< LIGHT_RENDER_CMD_TARGET, LIGHT_RENDER_CMD_EFFECT */
+} light_render_cmd_t;
+
+/**
+* @brief Create the strip, the frame buffer, the segments and (if enabled) the render task
+*
+* @param config strip configuration
+*/
+esp_err_t light_render_init(const light_driver_config_t *config);
+
+/**
+* @brief Queue segment outputs for rendering as one frame, never blocks
+*
+* @param cmds   one command per changed segment
+* @param count  number of commands, at most the number of segments
+* @return false if the render queue cannot take all of them, none is queued then
+*/
+bool light_render_submit(const light_render_cmd_t *cmds, uint8_t count);
+
+#if CONFIG_LIGHT_DRIVER_STREAM
+/**
+* @brief Claim the stream buffer for writing
+*
+* @param led_count number of pixels in the buffer
+* @return NULL while the last shown stream frame is still being rendered
+*/
+uint8_t *light_render_stream_claim(uint16_t *led_count);
+
+/**
+* @brief Show the claimed stream buffer as the next frame, never blocks
+*
+* @return false if the render queue is full, the buffer is released then
+*/
+bool light_render_stream_show(void);
+#endif
+
+/**
+* @brief Read the render queue counters
+*/
+void light_render_get_stats(light_driver_stats_t *stats);
@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "light_transition.h"
+
+#define PROGRESS_Q 15
+
+static void target_to_q8(const light_target_t *value, uint16_t q8[4])
+{
+    q8[0] = value->rgb.r << 8;
+    q8[1] = value->rgb.g << 8;
+    q8[2] = value->rgb.b << 8;
+    q8[3] = value->level << 8;
+}
+
+/* rounds Q8 back to 8 bits */
+static void q8_to_target(const uint16_t q8[4], light_target_t *value)
+{
+    value->rgb.r = (q8[0] + 0x80) >> 8;
+    value->rgb.g = (q8[1] + 0x80) >> 8;
+    value->rgb.b = (q8[2] + 0x80) >> 8;
+    value->level = (q8[3] + 0x80) >> 8;
+}
+
+/* progress in Q15, saturates at 1.0 */
+static uint32_t transition_progress(const light_transition_t *t, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - t->start_ms;
+    uint32_t duration = t->duration_ms;
+    if (elapsed >= duration) {
+        return 1U << PROGRESS_Q;
+    }
+    /* keep elapsed << PROGRESS_Q within 32 bits for long transitions */
+    while (duration > (UINT32_MAX >> PROGRESS_Q)) {
+        elapsed >>= 1;
+        duration >>= 1;
+    }
+    return (elapsed << PROGRESS_Q) / duration;
+}
+
+static void transition_value(const light_transition_t *t, uint32_t now_ms, uint16_t q8[4])
+{
+    if (!t->active) {
+        for (int i = 0; i < 4; i++) {
+            q8[i] = t->to[i];
+        }
+        return;
+    }
+    int32_t progress = (int32_t)transition_progress(t, now_ms);
+    for (int i = 0; i < 4; i++) {
+        /* |to - from| < 2^16, times progress <= 2^15 stays below 2^31 */
+        int32_t delta = (int32_t)t->to[i] - t->from[i];
+        q8[i] = (uint16_t)(t->from[i] + ((delta * progress) >> PROGRESS_Q));
+    }
+}
+
+void light_transition_init(light_transition_t *t, const light_target_t *value)
+{
+    target_to_q8(value, t->from);
+    target_to_q8(value, t->to);
+    t->start_ms = 0;
+    t->duration_ms = 0;
+    t->active = false;
+}
+
+void light_transition_start(light_transition_t *t, const light_target_t *target, uint32_t now_ms, uint32_t duration_ms)
+{
+    transition_value(t, now_ms, t->from);
+    target_to_q8(target, t->to);
+    t->start_ms = now_ms;
+    t->duration_ms = duration_ms;
+    t->active = duration_ms > 0;
+}
+
+bool light_transition_step(light_transition_t *t, uint32_t now_ms, light_target_t *out)
+{
+    uint16_t q8[4];
+    transition_value(t, now_ms, q8);
+    q8_to_target(q8, out);
+    if (t->active && now_ms - t->start_ms >= t->duration_ms) {
+        t->active = false;
+    }
+    return t->active;
+}
@@ -0,0 +1,228 @@
+#!/usr/bin/env python
+#
+# SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+#
+
+"""
+Generate the light driver color tables (light_color_tables.h).
+
+The tables are emitted as static const arrays so they land in flash:
+  - light_gamma_lut: light level -> channel scale, with gamma applied
+  - light_xy_grid:   (x, y) grid -> RGB, as light_color_xy_to_rgb() computes it
+  - light_ct_table:  color temperature in mireds -> RGB, on the Planckian locus
+  - light_breathe:   one breathe cycle -> level scale, for light_effect.c
+  - light_hue_wheel: hue -> RGB at full saturation, for the color loop
+
+and as defines, for light_color_xy_to_rgb():
+  - LIGHT_XYZ_*:     XYZ to linear RGB of the LEDs in Q16, from their primaries
+  - LIGHT_GAMUT_*:   the LED primaries in 16-bit xy, the gamut triangle
+
+Colors are for the LEDs of one board, whose measured primaries and white
+are a row of led_primaries.csv.
+"""
+
+import argparse
+import colorsys
+import math
+import os
+
+XYZ_Q = 16
+
+
+def load_primaries(path, name):
+    with open(path) as f:
+        for line in f:
+            fields = [v.strip() for v in line.split('#', 1)[0].split(',')]
+            if fields[0] == name:
+                if len(fields) != 9:
+                    raise ValueError('%s: %s needs 8 coordinates' % (path, name))
+                v = [float(c) for c in fields[1:]]
+                return [(v[0], v[1]), (v[2], v[3]), (v[4], v[5])], (v[6], v[7])
+    raise ValueError('%s: no primaries named %s' % (path, name))
+
+
+def det3(m):
+    return (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+            m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+            m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]))
+
+
+def inv3(m):
+    d = det3(m)
+    return [[(m[(j + 1) % 3][(i + 1) % 3] * m[(j + 2) % 3][(i + 2) % 3] -
+              m[(j + 1) % 3][(i + 2) % 3] * m[(j + 2) % 3][(i + 1) % 3]) / d for j in range(3)] for i in range(3)]
+
+
+def xyz_to_rgb_matrix(primaries, white):
+    # columns: XYZ of each primary at Y = 1, scaled so that full R, G and B make the white
+    cols = [(x / y, 1.0, (1 - x - y) / y) for x, y in primaries]
+    p = [[cols[c][r] for c in range(3)] for r in range(3)]
+    wx, wy = white
+    w = (wx / wy, 1.0, (1 - wx - wy) / wy)
+    s = [sum(row[k] * w[k] for k in range(3)) for row in inv3(p)]
+    return inv3([[p[r][c] * s[c] for c in range(3)] for r in range(3)])
+
+
+def closest_on_segment(p, a, b):
+    dx, dy = b[0] - a[0], b[1] - a[1]
+    t = ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / (dx * dx + dy * dy)
+    t = min(max(t, 0.0), 1.0)
+    return (a[0] + t * dx, a[1] + t * dy)
+
+
+def gamut_map(x, y, primaries):
+    # inside the LED triangle as is, else the nearest point on its edges
+    def cross(o, a, b):
+        return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0])
+    r, g, b = primaries
+    sides = [cross(r, g, (x, y)), cross(g, b, (x, y)), cross(b, r, (x, y))]
+    if all(v >= 0 for v in sides) or all(v <= 0 for v in sides):
+        return x, y
+    points = [closest_on_segment((x, y), e0, e1) for e0, e1 in ((r, g), (g, b), (b, r))]
+    return min(points, key=lambda q: (q[0] - x) ** 2 + (q[1] - y) ** 2)
+
+
+def xy_to_rgb(x, y, matrix, primaries):
+    # what light_color_xy_to_rgb() computes: gamut mapped, brightest channel 255
+    x, y = gamut_map(x, y, primaries)
+    v = [max(row[0] * x + row[1] * y + row[2] * (1 - x - y), 0.0) for row in matrix]
+    peak = max(v)
+    return [int(round(c / peak * 255)) if peak > 0 else 0 for c in v]
+
+
+def planckian_xy(kelvin):
+    # Kim et al., "Design of advanced color temperature control system for
+    # HDTV applications", cubic spline approximation of the Planckian locus
+    t = float(kelvin)
+    if t <= 4000:
+        x = -0.2661239e9 / t ** 3 - 0.2343589e6 / t ** 2 + 0.8776956e3 / t + 0.179910
+    else:
+        x = -3.0258469e9 / t ** 3 + 2.1070379e6 / t ** 2 + 0.2226347e3 / t + 0.240390
+    if t <= 2222:
+        y = -1.1063814 * x ** 3 - 1.34811020 * x ** 2 + 2.18555832 * x - 0.20219683
+    elif t <= 4000:
+        y = -0.9549476 * x ** 3 - 1.37418593 * x ** 2 + 2.09137015 * x - 0.16748867
+    else:
+        y = 3.0817580 * x ** 3 - 5.87338670 * x ** 2 + 3.75112997 * x - 0.37001483
+    return x, y
+
+
+def ct_table(min_mireds, max_mireds, step_bits, matrix, primaries):
+    entries = ((max_mireds - min_mireds) >> step_bits) + 2
+    table = []
+    for i in range(entries):
+        x, y = planckian_xy(1e6 / (min_mireds + (i << step_bits)))
+        # full brightness at every temperature, the level does the dimming
+        table.extend(xy_to_rgb(x, y, matrix, primaries))
+    return entries, table
+
+
+def gamma_table(gamma):
+    table = []
+    for level in range(256):
+        v = int(round(255 * (level / 255.0) ** gamma))
+        # never switch a lit level fully off
+        table.append(max(v, 1) if level else 0)
+    return table
+
+
+def xy_grid(bits, matrix, primaries):
+    points = (1 << bits) + 1
+    step = 1 << (16 - bits)
+    grid = []
+    for iy in range(points):
+        for ix in range(points):
+            grid.extend(xy_to_rgb(min(ix * step, 65535) / 65535.0, min(iy * step, 65535) / 65535.0, matrix, primaries))
+    return points, grid
+
+
+def breathe_table(points):
+    # sin^2 starts and ends dark with no kink, so cycles join smoothly
+    return [int(round(255 * math.sin(math.pi * i / points) ** 2)) for i in range(points)]
+
+
+def hue_wheel(points):
+    table = []
+    for i in range(points):
+        table.extend(int(round(v * 255)) for v in colorsys.hsv_to_rgb(i / float(points), 1.0, 1.0))
+    return table
+
+
+def format_array(decl, values, per_line=16):
+    lines = ['%s = {' % decl]
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join('%d' % v for v in values[i:i + per_line]) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate light driver color tables')
+    parser.add_argument('--xy-grid-bits', type=int, default=5, choices=range(4, 9),
+                        help='xy grid has (1 << bits) + 1 points per axis')
+    parser.add_argument('--gamma', type=int, default=22, help='dimming gamma, in tenths')
+    parser.add_argument('--ct-min-mireds', type=int, default=153, help='coldest color temperature in the table')
+    parser.add_argument('--ct-max-mireds', type=int, default=500, help='warmest color temperature in the table')
+    parser.add_argument('--ct-step-bits', type=int, default=2, help='table step is 1 << bits mireds')
+    parser.add_argument('--primaries', default='srgb', help='LED primaries, a row of --primaries-file')
+    parser.add_argument('--primaries-file', default=os.path.join(os.path.dirname(os.path.abspath(__file__)), 'led_primaries.csv'),
+                        help='table of LED primaries per board')
+    parser.add_argument('--output', required=True, help='header file to write')
+    args = parser.parse_args()
+
+    primaries, white = load_primaries(args.primaries_file, args.primaries)
+    matrix = xyz_to_rgb_matrix(primaries, white)
+    q = [[int(round(v * (1 << XYZ_Q))) for v in row] for row in matrix]
+    if max(abs(v) for row in q for v in row) >= 1 << 23:
+        raise ValueError('%s: primaries too close together for a Q%d matrix' % (args.primaries, XYZ_Q))
+    points, grid = xy_grid(args.xy_grid_bits, matrix, primaries)
+    ct_entries, ct = ct_table(args.ct_min_mireds, args.ct_max_mireds, args.ct_step_bits, matrix, primaries)
+    out = [
+        '/* Generated by %s, do not edit. */' % os.path.basename(__file__),
+        '',
+        '#pragma once',
+        '',
+        '#include <stdint.h>',
+        '',
+        '/* LED primaries "%s": red (%.4f, %.4f), green (%.4f, %.4f), blue (%.4f, %.4f), white (%.4f, %.4f) */' % (
+            (args.primaries,) + primaries[0] + primaries[1] + primaries[2] + white),
+        '#define LIGHT_XYZ_Q  %d' % XYZ_Q,
+    ] + ['#define LIGHT_XYZ_%s%s %7d   /* %9.6f */' % ('RGB'[r], 'XYZ'[c], q[r][c], matrix[r][c])
+         for r in range(3) for c in range(3)] + [
+        '',
+    ] + ['#define %-19s %5d' % ('LIGHT_GAMUT_%s_%s' % (name, axis), int(round(v * 65535)))
+         for name, point in zip(('RED', 'GREEN', 'BLUE'), primaries) for axis, v in zip('XY', point)] + [
+        '',
+        '#define LIGHT_XY_GRID_BITS   %d' % args.xy_grid_bits,
+        '#define LIGHT_XY_GRID_POINTS %d' % points,
+        '',
+        '/* gamma %.1f */' % (args.gamma / 10.0),
+        format_array('static const uint8_t light_gamma_lut[256]', gamma_table(args.gamma / 10.0)),
+        '',
+        '/* RGB per point, row-major in y */',
+        format_array('static const uint8_t light_xy_grid[%d * %d * 3]' % (points, points), grid, per_line=15),
+        '',
+        '#define LIGHT_CT_TABLE_MIN_MIREDS %d' % args.ct_min_mireds,
+        '#define LIGHT_CT_TABLE_MAX_MIREDS %d' % args.ct_max_mireds,
+        '#define LIGHT_CT_TABLE_STEP_BITS  %d' % args.ct_step_bits,
+        '',
+        '/* RGB per mired step, starting at LIGHT_CT_TABLE_MIN_MIREDS */',
+        format_array('static const uint8_t light_ct_table[%d * 3]' % ct_entries, ct, per_line=15),
+        '',
+        '/* waveforms have LIGHT_WAVE_POINTS points per period and wrap around */',
+        '#define LIGHT_WAVE_POINTS 256',
+        '',
+        '/* level scale over one breathe cycle */',
+        format_array('static const uint8_t light_breathe[LIGHT_WAVE_POINTS]', breathe_table(256)),
+        '',
+        '/* RGB per 1/256 turn of the hue wheel, red first */',
+        format_array('static const uint8_t light_hue_wheel[LIGHT_WAVE_POINTS * 3]', hue_wheel(256), per_line=15),
+        '',
+    ]
+    with open(args.output, 'w') as f:
+        f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -13,8 +13,19 @@
  */
 
 #include "esp_zb_light.h"
+#include "light_commission.h"
+#include "light_memory.h"
+#include "light_metrics.h"
+#include "light_store.h"
+#include "light_ota.h"
+#include "light_report.h"
+#include "light_scene.h"
+#include "light_stream.h"
+#include "light_trace.h"
 #include "esp_check.h"
+#include "esp_cpu.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -25,16 +36,314 @@
 #endif
 
 static const char *TAG = "ESP_ZB_COLOR_DIMM_LIGHT";
+
+/* Attributes a bridge steps through to fake a transition, see light_step_note() */
+enum
+{
+    LIGHT_STEP_LEVEL = 0x01,
+    LIGHT_STEP_X = 0x02,
+    LIGHT_STEP_Y = 0x04,
+    LIGHT_STEP_MIREDS = 0x08,
+    LIGHT_STEP_HUE = 0x10,
+    LIGHT_STEP_SAT = 0x20,
+};
+
+/* One light per strip segment, segment i is endpoint HA_COLOR_DIMMABLE_LIGHT_ENDPOINT + i.
+ * CurrentX/CurrentY and CurrentHue/CurrentSaturation arrive as separate
+ * attribute callbacks, so both halves are kept in the state; the whole state
+ * is handed to light_store after every commit. The color loop runs as a
+ * driver effect and is not saved. 36 bytes per segment. */
+typedef struct
+{
+    light_store_state_t state;  /* as last set */
+    uint16_t color_loop_time_s; /* ColorLoopTime */
+    uint16_t color_loop_hue;    /* ColorLoopStartEnhancedHue */
+    bool color_loop_active;     /* ColorLoopActive */
+    bool color_loop_up;         /* ColorLoopDirection: hue goes up */
+    bool commit_pending;        /* changed since the last commit */
+    uint8_t step_changed;       /* LIGHT_STEP_* changed since the last commit */
+    uint8_t step_up;            /* of those, the ones that went up */
+    uint8_t step_last;          /* LIGHT_STEP_* changed in the last commit */
+    uint8_t step_last_up;       /* of those, the ones that went up */
+    bool step_break;            /* changed since the last commit in a way that never fades, e.g. on/off */
+    uint32_t transition_ms;     /* fade of the next commit, 0 for step smoothing */
+    uint32_t last_commit_ms;
+} light_segment_t;
+
+static const light_store_state_t s_light_default_state = {
+    .color_x = ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_X_DEF_VALUE,
+    .color_y = ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_Y_DEF_VALUE,
+    .mireds = LIGHT_COLOR_CT_DEFAULT_MIREDS,
+    .power = LIGHT_DEFAULT_OFF,
+    .level = LIGHT_LEVEL_DEFAULT,
+    .color_mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_CURRENT_X_Y,
+    .startup_on_off = ESP_ZB_ZCL_ON_OFF_START_UP_ON_OFF_IS_PREVIOUS,
+    .startup_level = LIGHT_START_UP_LEVEL_PREVIOUS,
+};
+
+static light_segment_t s_segments[LIGHT_SEGMENT_COUNT];
+static bool s_light_commit_scheduled = false;
+
 /********************* Define functions **************************/
+/* a stepping attribute of a segment changes from old to new */
+static void light_step_note(uint8_t index, uint8_t step, uint32_t old, uint32_t new)
+{
+    light_segment_t *segment = &s_segments[index];
+    if (new != old)
+    {
+        segment->step_changed |= step;
+        segment->step_up = new > old ? segment->step_up | step : segment->step_up & ~step;
+    }
+}
+
+/* Stepped transitions (from the stack or a bridge writing intermediate
+ * values) arrive as a stream of writes; fade over the step interval so the
+ * render task turns them into one continuous transition. A commit is a step
+ * when it comes within CONFIG_LIGHT_STEP_SMOOTHING_MS of the last one and
+ * changes only attributes that changed then, each in the same direction. */
+static uint32_t light_step_transition_ms(const light_segment_t *segment, uint32_t since_last_ms)
+{
+    bool step = since_last_ms < CONFIG_LIGHT_STEP_SMOOTHING_MS && !segment->step_break && segment->step_changed &&
+                !(segment->step_changed & ~segment->step_last) &&
+                !((segment->step_up ^ segment->step_last_up) & segment->step_changed);
+    return step ? since_last_ms : 0;
+}
+
+static void light_commit_cb(uint8_t param)
+{
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++)
+    {
+        light_segment_t *segment = &s_segments[i];
+        if (segment->commit_pending)
+        {
+            light_driver_set_transition(i, segment->transition_ms ? segment->transition_ms
+                                        : light_step_transition_ms(segment, now_ms - segment->last_commit_ms));
+        }
+    }
+    if (light_driver_commit() == ESP_ERR_NO_MEM)
+    {
+        /* render queue full, never wait on it from the Zigbee task */
+        esp_zb_scheduler_alarm(light_commit_cb, 0, LIGHT_COMMIT_RETRY_MS);
+        return;
+    }
+    s_light_commit_scheduled = false;
+    light_scene_committed();
+    for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++)
+    {
+        light_segment_t *segment = &s_segments[i];
+        if (segment->commit_pending)
+        {
+            segment->commit_pending = false;
+            segment->transition_ms = 0;
+            segment->last_commit_ms = now_ms;
+            segment->step_last = segment->step_changed;
+            segment->step_last_up = segment->step_up;
+            segment->step_changed = 0;
+            segment->step_up = 0;
+            segment->step_break = false;
+            light_store_update(i, &segment->state);
+        }
+    }
+}
+
+/* render once per stack tick, no matter how many attributes of how many segments changed */
+static void light_schedule_render(void)
+{
+    if (!s_light_commit_scheduled)
+    {
+        s_light_commit_scheduled = true;
+        esp_zb_scheduler_alarm(light_commit_cb, 0, 0);
+    }
+}
+
+static void light_schedule_commit(uint8_t index)
+{
+    s_segments[index].commit_pending = true;
+    light_schedule_render();
+}
+
+/* Effects run in the render task on top of the segment state and change no
+ * attribute, so they cost no radio traffic and no flash writes. */
+static void light_start_effect(uint8_t index, const light_effect_params_t *effect)
+{
+    light_driver_set_effect(index, effect);
+    light_schedule_render();
+}
+
+/* ColorLoopActive, ColorLoopDirection or ColorLoopTime changed: (re)start or stop the loop */
+static void light_color_loop_update(uint8_t index)
+{
+    const light_segment_t *segment = &s_segments[index];
+    const light_effect_params_t effect = {
+        .id = segment->color_loop_active ? LIGHT_EFFECT_COLORLOOP : LIGHT_EFFECT_COLORLOOP_STOP,
+        .start_hue = segment->color_loop_hue,
+        .period_s = segment->color_loop_time_s,
+        .reverse = !segment->color_loop_up,
+    };
+    LIGHT_LOGI(ATTR_COLOR_LOOP, segment->color_loop_active, segment->color_loop_up, segment->color_loop_time_s);
+    light_start_effect(index, &effect);
+}
+
+/* the Identify cluster counts IdentifyTime down itself and calls back when identifying starts and ends */
+static void light_identify(uint8_t index, uint8_t identify_on)
+{
+    const light_effect_params_t effect = {
+        .id = identify_on ? LIGHT_EFFECT_BLINK : LIGHT_EFFECT_NONE,
+    };
+    LIGHT_LOGI(IDENTIFY, index, identify_on);
+    light_start_effect(index, &effect);
+}
+
+/* the identify callback has no endpoint argument, one trampoline per segment */
+#define LIGHT_IDENTIFY_CB(index)                                \
+    static void light_identify_cb_##index(uint8_t identify_on)  \
+    {                                                           \
+        light_identify(index, identify_on);                     \
+    }
+
+LIGHT_IDENTIFY_CB(0)  LIGHT_IDENTIFY_CB(1)  LIGHT_IDENTIFY_CB(2)  LIGHT_IDENTIFY_CB(3)
+LIGHT_IDENTIFY_CB(4)  LIGHT_IDENTIFY_CB(5)  LIGHT_IDENTIFY_CB(6)  LIGHT_IDENTIFY_CB(7)
+LIGHT_IDENTIFY_CB(8)  LIGHT_IDENTIFY_CB(9)  LIGHT_IDENTIFY_CB(10) LIGHT_IDENTIFY_CB(11)
+LIGHT_IDENTIFY_CB(12) LIGHT_IDENTIFY_CB(13) LIGHT_IDENTIFY_CB(14) LIGHT_IDENTIFY_CB(15)
+
+static const esp_zb_identify_notify_callback_t s_identify_cbs[] = {
+    light_identify_cb_0,  light_identify_cb_1,  light_identify_cb_2,  light_identify_cb_3,
+    light_identify_cb_4,  light_identify_cb_5,  light_identify_cb_6,  light_identify_cb_7,
+    light_identify_cb_8,  light_identify_cb_9,  light_identify_cb_10, light_identify_cb_11,
+    light_identify_cb_12, light_identify_cb_13, light_identify_cb_14, light_identify_cb_15,
+};
+_Static_assert(sizeof(s_identify_cbs) / sizeof(s_identify_cbs[0]) >= LIGHT_SEGMENT_COUNT, "one identify callback per segment");
+
+static void *light_zcl_attr_value(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id)
+{
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(endpoint, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id);
+    return attr ? attr->data_p : NULL;
+}
+
+/* load the saved state and apply StartUpOnOff/StartUpCurrentLevel, before the clusters are created */
+static void light_load_state(uint8_t index)
+{
+    light_store_state_t *state = &s_segments[index].state;
+    *state = s_light_default_state;
+    s_segments[index].color_loop_time_s = LIGHT_COLOR_LOOP_TIME_DEFAULT_S;
+    s_segments[index].color_loop_hue = LIGHT_COLOR_LOOP_HUE_DEFAULT;
+    esp_err_t err = light_store_init(index, state);
+    if (err != ESP_OK)
+    {
+        ESP_LOGI(TAG, "No saved light state for segment %d (%s), using defaults", index, esp_err_to_name(err));
+    }
+    switch (state->startup_on_off)
+    {
+    case ESP_ZB_ZCL_ON_OFF_START_UP_ON_OFF_IS_OFF:
+        state->power = false;
+        break;
+    case ESP_ZB_ZCL_ON_OFF_START_UP_ON_OFF_IS_ON:
+        state->power = true;
+        break;
+    case ESP_ZB_ZCL_ON_OFF_START_UP_ON_OFF_IS_TOGGLE:
+        state->power = !state->power;
+        break;
+    default:
+        break;
+    }
+    if (state->startup_level == LIGHT_START_UP_LEVEL_MINIMUM)
+    {
+        state->level = LIGHT_LEVEL_MIN;
+    }
+    else if (state->startup_level != LIGHT_START_UP_LEVEL_PREVIOUS)
+    {
+        state->level = state->startup_level;
+    }
+}
+
+/* set the driver to the segment state, without committing */
+static void light_apply_state(uint8_t index)
+{
+    const light_store_state_t *state = &s_segments[index].state;
+    switch (state->color_mode)
+    {
+    case ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_TEMPERATURE:
+        light_driver_set_color_temperature(index, state->mireds);
+        break;
+    case ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION:
+        light_driver_set_color_hue_sat(index, state->hue, state->sat);
+        break;
+    default:
+        light_driver_set_color_xy(index, state->color_x, state->color_y);
+        break;
+    }
+    light_driver_set_level(index, state->level);
+    light_driver_set_power(index, state->power);
+}
+
+/* boot milestones, in ms since esp_timer started; ROM and bootloader time come on top */
+static void light_boot_mark(const char *milestone)
+{
+    ESP_LOGI(TAG, "Boot: %s after %lu ms", milestone, (unsigned long)(esp_timer_get_time() / 1000));
+}
+
+/* make the ZCL attributes match what is already showing, reads and reports start from there */
+static void light_publish_state(uint8_t index)
+{
+    uint8_t endpoint = LIGHT_SEGMENT_ENDPOINT(index);
+    light_store_state_t *state = &s_segments[index].state;
+    esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, &state->power, false);
+    esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, &state->level, false);
+    esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, &state->color_x, false);
+    esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, &state->color_y, false);
+    esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_HUE_ID, &state->hue, false);
+    esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID, &state->sat, false);
+    esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID, &state->mireds, false);
+    esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, &state->color_mode, false);
+}
+
+/* the driver has been showing the segment states since app_main(), the stack takes over from here */
 static esp_err_t deferred_driver_init(void)
 {
-    light_driver_init(LIGHT_DEFAULT_OFF);
+    static bool handed_off = false;
+    if (handed_off)
+    {
+        return ESP_OK;
+    }
+    handed_off = true;
+    light_boot_mark("Zigbee stack up");
+#if CONFIG_LIGHT_BENCH_ON_BOOT
+    /* the driver kernels overwrite the light state of segment 0, restore it afterwards */
+    light_bench_run_all(true);
+    light_apply_state(0);
+    light_driver_commit();
+#endif
+    for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++)
+    {
+        light_publish_state(i);
+        /* a toggling or forced start up state is the new state */
+        light_store_update(i, &s_segments[i].state);
+        light_report_update(i, &s_segments[i].state);
+    }
+    light_metrics_start();
+#if CONFIG_LIGHT_MEMORY_REPORT_ON_BOOT
+    light_memory_report("Zigbee stack up");
+#endif
     return ESP_OK;
 }
 
-static void bdb_start_top_level_commissioning_cb(uint8_t mode_mask)
+static void light_joined(void)
 {
-    ESP_RETURN_ON_FALSE(esp_zb_bdb_start_top_level_commissioning(mode_mask) == ESP_OK, , TAG, "Failed to start Zigbee commissioning");
+    static bool joined = false;
+    if (!joined)
+    {
+        joined = true;
+        light_boot_mark("joined");
+    }
 }
 
 void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
@@ -57,11 +366,13 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
             if (esp_zb_bdb_is_factory_new())
             {
                 ESP_LOGI(TAG, "Start network steering");
-                esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
+                light_commission_start();
             }
             else
             {
                 ESP_LOGI(TAG, "Device rebooted");
+                light_metrics_rejoin();
+                light_joined();
             }
         }
         else
@@ -74,15 +385,18 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
         {
             esp_zb_ieee_addr_t extended_pan_id;
             esp_zb_get_extended_pan_id(extended_pan_id);
-            ESP_LOGI(TAG, "Joined network successfully (Extended PAN ID: %02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x, PAN ID: 0x%04hx, Channel:%d, Short Address: 0x%04hx)",
-                     extended_pan_id[7], extended_pan_id[6], extended_pan_id[5], extended_pan_id[4],
-                     extended_pan_id[3], extended_pan_id[2], extended_pan_id[1], extended_pan_id[0],
-                     esp_zb_get_pan_id(), esp_zb_get_current_channel(), esp_zb_get_short_address());
+            LIGHT_LOGI(NWK_JOINED,
+                       (unsigned)extended_pan_id[7] << 24 | extended_pan_id[6] << 16 | extended_pan_id[5] << 8 | extended_pan_id[4],
+                       (unsigned)extended_pan_id[3] << 24 | extended_pan_id[2] << 16 | extended_pan_id[1] << 8 | extended_pan_id[0],
+                       esp_zb_get_pan_id(), esp_zb_get_current_channel(), esp_zb_get_short_address());
+            light_metrics_joined(light_commission_joined());
+            light_joined();
         }
         else
         {
             ESP_LOGI(TAG, "Network steering was not successful (status: %s)", esp_err_to_name(err_status));
-            esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, ESP_ZB_BDB_MODE_NETWORK_STEERING, 1000);
+            light_metrics_steering_retry();
+            light_commission_failed();
         }
         break;
     case ESP_ZB_NWK_SIGNAL_PERMIT_JOIN_STATUS:
@@ -101,13 +415,14 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
     case ESP_ZB_ZDO_SIGNAL_LEAVE:
         // https://github.com/espressif/esp-zigbee-sdk/issues/66#issuecomment-1667314481
         esp_zb_zdo_signal_leave_params_t *leave_params = (esp_zb_zdo_signal_leave_params_t *)esp_zb_app_signal_get_params(p_sg_p);
+        light_metrics_leave();
         if (leave_params)
         {
             if (leave_params->leave_type == ESP_ZB_NWK_LEAVE_TYPE_RESET)
             {
                 ESP_LOGI(TAG, "ZDO leave: with reset, status: %s", esp_err_to_name(err_status));
                 esp_zb_nvram_erase_at_start(true);                                          // erase previous network information.
-                esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING); // steering a new network.
+                light_commission_start();                                                   // steering a new network.
             }
             else
             {
@@ -130,79 +445,294 @@ static esp_err_t zb_attribute_handler(const esp_zb_zcl_set_attr_value_message_t
     esp_err_t ret = ESP_OK;
     bool light_state = 0;
     uint8_t light_level = 0;
-    uint16_t light_color_x = 0;
-    uint16_t light_color_y = 0;
     ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
     ESP_RETURN_ON_FALSE(message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS, ESP_ERR_INVALID_ARG, TAG, "Received message: error status(%d)",
                         message->info.status);
-    ESP_LOGI(TAG, "Received message: endpoint(%d), cluster(0x%x), attribute(0x%x), data size(%d)", message->info.dst_endpoint, message->info.cluster,
-             message->attribute.id, message->attribute.data.size);
-    if (message->info.dst_endpoint == HA_COLOR_DIMMABLE_LIGHT_ENDPOINT)
+    LIGHT_LOGI(ATTR_RX, message->info.dst_endpoint, message->info.cluster, message->attribute.id, message->attribute.data.size);
+    uint8_t index = message->info.dst_endpoint - HA_COLOR_DIMMABLE_LIGHT_ENDPOINT;
+    if (message->info.dst_endpoint >= HA_COLOR_DIMMABLE_LIGHT_ENDPOINT && index < LIGHT_SEGMENT_COUNT)
     {
+        light_store_state_t *state = &s_segments[index].state;
         switch (message->info.cluster)
         {
         case ESP_ZB_ZCL_CLUSTER_ID_ON_OFF:
             if (message->attribute.id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_BOOL)
             {
                 light_state = message->attribute.data.value ? *(bool *)message->attribute.data.value : light_state;
-                ESP_LOGI(TAG, "Light sets to %s", light_state ? "On" : "Off");
-                light_driver_set_power(light_state);
+                LIGHT_LOGI(ATTR_ON_OFF, light_state);
+                s_segments[index].step_break |= state->power != light_state;
+                state->power = light_state;
+                uint16_t *on_off_transition = light_zcl_attr_value(message->info.dst_endpoint, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                                                                   ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID);
+                /* OnOffTransitionTime is in tenths of a second */
+                s_segments[index].transition_ms = on_off_transition ? *on_off_transition * 100U : 0;
+                light_driver_set_power(index, light_state);
+                light_schedule_commit(index);
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_ON_OFF_START_UP_ON_OFF &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM && message->attribute.data.value)
+            {
+                state->startup_on_off = *(uint8_t *)message->attribute.data.value;
+                light_store_update(index, state);
+                LIGHT_LOGI(ATTR_START_UP_ON_OFF, state->startup_on_off);
             }
             else
             {
-                ESP_LOGW(TAG, "On/Off cluster data: attribute(0x%x), type(0x%x)", message->attribute.id, message->attribute.data.type);
+                LIGHT_LOGW(ATTR_UNKNOWN_ON_OFF, message->attribute.id, message->attribute.data.type);
             }
             break;
         case ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL:
             if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U16)
             {
-                light_color_x = message->attribute.data.value ? *(uint16_t *)message->attribute.data.value : light_color_x;
-                light_color_y = *(uint16_t *)esp_zb_zcl_get_attribute(message->info.dst_endpoint, message->info.cluster,
-                                                                      ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID)
-                                     ->data_p;
-                ESP_LOGI(TAG, "Light color x changes to 0x%x", light_color_x);
+                uint16_t x = message->attribute.data.value ? *(uint16_t *)message->attribute.data.value : state->color_x;
+                light_step_note(index, LIGHT_STEP_X, state->color_x, x);
+                state->color_x = x;
+                state->color_mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_CURRENT_X_Y;
+                light_driver_set_color_xy(index, state->color_x, state->color_y);
+                light_schedule_commit(index);
+                LIGHT_LOGI(ATTR_COLOR_X, state->color_x);
             }
             else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID &&
                      message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U16)
             {
-                light_color_y = message->attribute.data.value ? *(uint16_t *)message->attribute.data.value : light_color_y;
-                light_color_x = *(uint16_t *)esp_zb_zcl_get_attribute(message->info.dst_endpoint, message->info.cluster,
-                                                                      ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID)
-                                     ->data_p;
-                ESP_LOGI(TAG, "Light color y changes to 0x%x", light_color_y);
+                uint16_t y = message->attribute.data.value ? *(uint16_t *)message->attribute.data.value : state->color_y;
+                light_step_note(index, LIGHT_STEP_Y, state->color_y, y);
+                state->color_y = y;
+                state->color_mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_CURRENT_X_Y;
+                light_driver_set_color_xy(index, state->color_x, state->color_y);
+                light_schedule_commit(index);
+                LIGHT_LOGI(ATTR_COLOR_Y, state->color_y);
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U16 && message->attribute.data.value)
+            {
+                light_step_note(index, LIGHT_STEP_MIREDS, state->mireds, *(uint16_t *)message->attribute.data.value);
+                state->mireds = *(uint16_t *)message->attribute.data.value;
+                state->color_mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_TEMPERATURE;
+                light_driver_set_color_temperature(index, state->mireds);
+                light_schedule_commit(index);
+                LIGHT_LOGI(ATTR_COLOR_TEMPERATURE, state->mireds);
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_HUE_ID &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U8)
+            {
+                uint8_t hue = message->attribute.data.value ? *(uint8_t *)message->attribute.data.value : state->hue;
+                light_step_note(index, LIGHT_STEP_HUE, state->hue, hue);
+                state->hue = hue;
+                state->color_mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION;
+                light_driver_set_color_hue_sat(index, state->hue, state->sat);
+                light_schedule_commit(index);
+                LIGHT_LOGI(ATTR_HUE, state->hue);
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_CURRENT_HUE_ID &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U16)
+            {
+                /* EnhancedCurrentHue is 16-bit, CurrentHue is its top byte */
+                uint8_t hue = message->attribute.data.value ? *(uint16_t *)message->attribute.data.value >> 8 : state->hue;
+                light_step_note(index, LIGHT_STEP_HUE, state->hue, hue);
+                state->hue = hue;
+                state->color_mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION;
+                light_driver_set_color_hue_sat(index, state->hue, state->sat);
+                light_schedule_commit(index);
+                LIGHT_LOGI(ATTR_ENHANCED_HUE, state->hue);
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U8)
+            {
+                uint8_t sat = message->attribute.data.value ? *(uint8_t *)message->attribute.data.value : state->sat;
+                light_step_note(index, LIGHT_STEP_SAT, state->sat, sat);
+                state->sat = sat;
+                state->color_mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION;
+                light_driver_set_color_hue_sat(index, state->hue, state->sat);
+                light_schedule_commit(index);
+                LIGHT_LOGI(ATTR_SATURATION, state->sat);
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_ACTIVE_ID &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U8 && message->attribute.data.value)
+            {
+                s_segments[index].color_loop_active = *(uint8_t *)message->attribute.data.value;
+                light_color_loop_update(index);
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_DIRECTION_ID &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U8 && message->attribute.data.value)
+            {
+                s_segments[index].color_loop_up = *(uint8_t *)message->attribute.data.value;
+                if (s_segments[index].color_loop_active)
+                {
+                    light_color_loop_update(index);
+                }
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_TIME_ID &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U16 && message->attribute.data.value)
+            {
+                s_segments[index].color_loop_time_s = *(uint16_t *)message->attribute.data.value;
+                if (s_segments[index].color_loop_active)
+                {
+                    light_color_loop_update(index);
+                }
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_START_ENHANCED_HUE_ID &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U16 && message->attribute.data.value)
+            {
+                /* used from the next activation on */
+                s_segments[index].color_loop_hue = *(uint16_t *)message->attribute.data.value;
             }
             else
             {
-                ESP_LOGW(TAG, "Color control cluster data: attribute(0x%x), type(0x%x)", message->attribute.id, message->attribute.data.type);
+                LIGHT_LOGW(ATTR_UNKNOWN_COLOR, message->attribute.id, message->attribute.data.type);
             }
-            light_driver_set_color_xy(light_color_x, light_color_y);
             break;
         case ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL:
             if (message->attribute.id == ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U8)
             {
                 light_level = message->attribute.data.value ? *(uint8_t *)message->attribute.data.value : light_level;
-                light_driver_set_level((uint8_t)light_level);
-                ESP_LOGI(TAG, "Light level changes to %d", light_level);
+                light_step_note(index, LIGHT_STEP_LEVEL, state->level, light_level);
+                state->level = light_level;
+                light_driver_set_level(index, (uint8_t)light_level);
+                light_schedule_commit(index);
+                LIGHT_LOGI(ATTR_LEVEL, light_level);
+            }
+            else if (message->attribute.id == ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_START_UP_CURRENT_LEVEL_ID &&
+                     message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U8 && message->attribute.data.value)
+            {
+                state->startup_level = *(uint8_t *)message->attribute.data.value;
+                light_store_update(index, state);
+                LIGHT_LOGI(ATTR_START_UP_LEVEL, state->startup_level);
             }
             else
             {
-                ESP_LOGW(TAG, "Level Control cluster data: attribute(0x%x), type(0x%x)", message->attribute.id, message->attribute.data.type);
+                LIGHT_LOGW(ATTR_UNKNOWN_LEVEL, message->attribute.id, message->attribute.data.type);
             }
             break;
         default:
-            ESP_LOGI(TAG, "Message data: cluster(0x%x), attribute(0x%x)  ", message->info.cluster, message->attribute.id);
+            LIGHT_LOGI(ATTR_OTHER_CLUSTER, message->info.cluster, message->attribute.id);
         }
+        light_report_update(index, state);
     }
     return ret;
 }
 
+static esp_err_t zb_custom_cmd_handler(const esp_zb_zcl_custom_cluster_command_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    if (message->info.cluster == LIGHT_STREAM_CLUSTER_ID && message->info.command.id == LIGHT_STREAM_CMD_CHUNK)
+    {
+        /* dropped chunks are counted and traced, a lost frame is no error for the stack */
+        light_stream_handle(message->data.value, message->data.size);
+        return ESP_OK;
+    }
+    if (message->info.cluster == LIGHT_METRICS_CLUSTER_ID && message->info.command.id == LIGHT_METRICS_CMD_REFRESH)
+    {
+        light_metrics_refresh();
+        light_memory_report("Refresh");
+        return ESP_OK;
+    }
+    ESP_LOGW(TAG, "Unhandled command 0x%x of cluster 0x%04x", message->info.command.id, message->info.cluster);
+    return ESP_OK;
+}
+
+static esp_err_t zb_identify_effect_handler(const esp_zb_zcl_identify_effect_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    uint8_t index = message->info.dst_endpoint - HA_COLOR_DIMMABLE_LIGHT_ENDPOINT;
+    ESP_RETURN_ON_FALSE(message->info.dst_endpoint >= HA_COLOR_DIMMABLE_LIGHT_ENDPOINT && index < LIGHT_SEGMENT_COUNT, ESP_ERR_INVALID_ARG,
+                        TAG, "Effect for endpoint %d", message->info.dst_endpoint);
+    LIGHT_LOGI(EFFECT, message->effect_id, message->effect_variant, index);
+    light_effect_params_t effect = { 0 };
+    switch (message->effect_id)
+    {
+    case LIGHT_IDENTIFY_EFFECT_BLINK:
+        effect.id = LIGHT_EFFECT_BLINK;
+        effect.cycles = 1;
+        break;
+    case LIGHT_IDENTIFY_EFFECT_BREATHE:
+        effect.id = LIGHT_EFFECT_BREATHE;
+        effect.cycles = LIGHT_BREATHE_CYCLES;
+        break;
+    case LIGHT_IDENTIFY_EFFECT_OKAY:
+        effect.id = LIGHT_EFFECT_OKAY;
+        break;
+    case LIGHT_IDENTIFY_EFFECT_CHANNEL_CHANGE:
+        effect.id = LIGHT_EFFECT_CHANNEL_CHANGE;
+        break;
+    case LIGHT_IDENTIFY_EFFECT_FINISH:
+        effect.id = LIGHT_EFFECT_FINISH;
+        break;
+    case LIGHT_IDENTIFY_EFFECT_STOP:
+        effect.id = LIGHT_EFFECT_NONE;
+        break;
+    default:
+        ESP_LOGW(TAG, "Unsupported effect 0x%x", message->effect_id);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    light_start_effect(index, &effect);
+    return ESP_OK;
+}
+
+static esp_err_t zb_store_scene_handler(const esp_zb_zcl_store_scene_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    uint8_t index = message->info.dst_endpoint - HA_COLOR_DIMMABLE_LIGHT_ENDPOINT;
+    ESP_RETURN_ON_FALSE(message->info.dst_endpoint >= HA_COLOR_DIMMABLE_LIGHT_ENDPOINT && index < LIGHT_SEGMENT_COUNT, ESP_ERR_INVALID_ARG,
+                        TAG, "No light on endpoint %d", message->info.dst_endpoint);
+    return light_scene_store(index, message->group_id, message->scene_id, &s_segments[index].state);
+}
+
+/* the whole scene in one commit, rather than an attribute write per value */
+static esp_err_t zb_recall_scene_handler(const esp_zb_zcl_recall_scene_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    uint8_t index = message->info.dst_endpoint - HA_COLOR_DIMMABLE_LIGHT_ENDPOINT;
+    ESP_RETURN_ON_FALSE(message->info.dst_endpoint >= HA_COLOR_DIMMABLE_LIGHT_ENDPOINT && index < LIGHT_SEGMENT_COUNT, ESP_ERR_INVALID_ARG,
+                        TAG, "No light on endpoint %d", message->info.dst_endpoint);
+    if (message->field_set)
+    {
+        ESP_RETURN_ON_ERROR(light_scene_describe(index, message->group_id, message->scene_id, message->field_set),
+                            TAG, "Failed to take over scene %d", message->scene_id);
+    }
+    light_segment_t *segment = &s_segments[index];
+    uint32_t transition_ms;
+    ESP_RETURN_ON_ERROR(light_scene_recall(index, message->group_id, message->scene_id, message->transition_time, &segment->state,
+                                           &transition_ms),
+                        TAG, "No scene %d of group 0x%04x on endpoint %d", message->scene_id, message->group_id, message->info.dst_endpoint);
+    light_apply_state(index);
+    segment->transition_ms = transition_ms;
+    light_schedule_commit(index);
+    light_publish_state(index);
+    light_report_update(index, &segment->state);
+    return ESP_OK;
+}
+
 static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const void *message)
 {
     esp_err_t ret = ESP_OK;
     switch (callback_id)
     {
     case ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID:
-        ret = zb_attribute_handler((esp_zb_zcl_set_attr_value_message_t *)message);
+    {
+        const esp_zb_zcl_set_attr_value_message_t *attr_message = message;
+        uint32_t start = esp_cpu_get_cycle_count();
+        ret = zb_attribute_handler(attr_message);
+        if (attr_message)
+        {
+            light_metrics_attr_write(attr_message->info.cluster, esp_cpu_get_cycle_count() - start);
+        }
+        break;
+    }
+    case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID:
+        ret = zb_custom_cmd_handler(message);
+        break;
+    case ESP_ZB_CORE_IDENTIFY_EFFECT_CB_ID:
+        ret = zb_identify_effect_handler(message);
+        break;
+    case ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID:
+        ret = zb_store_scene_handler(message);
+        break;
+    case ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID:
+        ret = zb_recall_scene_handler(message);
+        break;
+    case ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID:
+        ret = light_ota_handle(message);
         break;
     default:
         ESP_LOGW(TAG, "Receive Zigbee action(0x%x) callback", callback_id);
@@ -211,6 +741,80 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
     return ret;
 }
 
+/* endpoint factory: one color dimmable light per segment, with the segment's saved state */
+static esp_err_t light_add_endpoint(esp_zb_ep_list_t *ep_list, uint8_t index)
+{
+    const light_store_state_t *state = &s_segments[index].state;
+    uint8_t endpoint = LIGHT_SEGMENT_ENDPOINT(index);
+    esp_zb_color_dimmable_light_cfg_t light_cfg = ESP_ZB_DEFAULT_COLOR_DIMMABLE_LIGHT_CONFIG();
+    light_cfg.color_cfg.color_capabilities = LIGHT_COLOR_CAPABILITIES;
+    light_cfg.on_off_cfg.on_off = state->power;
+    light_cfg.level_cfg.current_level = state->level;
+    light_cfg.color_cfg.current_x = state->color_x;
+    light_cfg.color_cfg.current_y = state->color_y;
+    light_cfg.color_cfg.color_mode = state->color_mode;
+    esp_zb_endpoint_config_t endpoint_config = {
+        .endpoint = endpoint,
+        .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        .app_device_id = ESP_ZB_HA_COLOR_DIMMABLE_LIGHT_DEVICE_ID,
+        .app_device_version = 1, // maybe important for Hue? Oh HELL yes.
+    };
+    esp_zb_cluster_list_t *cluster_list = esp_zb_color_dimmable_light_clusters_create(&light_cfg);
+    ESP_RETURN_ON_FALSE(cluster_list, ESP_ERR_NO_MEM, TAG, "Failed to create clusters of endpoint %d", endpoint);
+    ESP_RETURN_ON_ERROR(esp_zb_ep_list_add_ep(ep_list, cluster_list, endpoint_config), TAG, "Failed to add endpoint %d", endpoint);
+    zcl_basic_manufacturer_info_t info = {
+        .manufacturer_name = ESP_MANUFACTURER_NAME,
+        .model_identifier = ESP_MODEL_IDENTIFIER,
+    };
+    ESP_RETURN_ON_ERROR(esp_zcl_utility_add_ep_basic_manufacturer_info(ep_list, endpoint, &info), TAG, "Failed to add basic info");
+
+    // https://github.com/espressif/esp-zigbee-sdk/issues/457#issuecomment-2426128314
+    uint16_t on_off_on_time = 0;
+    bool on_off_global_scene_control = 0;
+    esp_zb_attribute_list_t *onoff_attr_list =
+        esp_zb_cluster_list_get_cluster(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+    esp_zb_on_off_cluster_add_attr(onoff_attr_list, ESP_ZB_ZCL_ATTR_ON_OFF_ON_TIME, &on_off_on_time);
+    esp_zb_on_off_cluster_add_attr(onoff_attr_list, ESP_ZB_ZCL_ATTR_ON_OFF_GLOBAL_SCENE_CONTROL, &on_off_global_scene_control);
+    // power-on behaviour, saved with the light state, see light_load_state()
+    uint8_t start_up_on_off = state->startup_on_off;
+    esp_zb_on_off_cluster_add_attr(onoff_attr_list, ESP_ZB_ZCL_ATTR_ON_OFF_START_UP_ON_OFF, &start_up_on_off);
+
+    // fade on/off over OnOffTransitionTime, see light_commit_cb()
+    uint16_t on_off_transition_time = 0;
+    uint8_t start_up_level = state->startup_level;
+    esp_zb_attribute_list_t *level_attr_list =
+        esp_zb_cluster_list_get_cluster(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+    esp_zb_level_cluster_add_attr(level_attr_list, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID, &on_off_transition_time);
+    esp_zb_level_cluster_add_attr(level_attr_list, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_START_UP_CURRENT_LEVEL_ID, &start_up_level);
+
+    // hue/saturation and color temperature, next to the default CurrentX/CurrentY
+    uint8_t color_hue = state->hue;
+    uint8_t color_saturation = state->sat;
+    uint16_t color_enhanced_hue = state->hue << 8;
+    uint16_t color_temperature = state->mireds;
+    uint16_t color_temp_min = LIGHT_COLOR_CT_MIN_MIREDS;
+    uint16_t color_temp_max = LIGHT_COLOR_CT_MAX_MIREDS;
+    esp_zb_attribute_list_t *color_attr_list =
+        esp_zb_cluster_list_get_cluster(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_HUE_ID, &color_hue);
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID, &color_saturation);
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_CURRENT_HUE_ID, &color_enhanced_hue);
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID, &color_temperature);
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMP_PHYSICAL_MIN_MIREDS_ID, &color_temp_min);
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMP_PHYSICAL_MAX_MIREDS_ID, &color_temp_max);
+
+    // color loop, run by the driver, see light_color_loop_update()
+    uint8_t color_loop_active = 0;
+    uint8_t color_loop_direction = 0;
+    uint16_t color_loop_time = s_segments[index].color_loop_time_s;
+    uint16_t color_loop_start_hue = s_segments[index].color_loop_hue;
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_ACTIVE_ID, &color_loop_active);
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_DIRECTION_ID, &color_loop_direction);
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_TIME_ID, &color_loop_time);
+    esp_zb_color_control_cluster_add_attr(color_attr_list, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_LOOP_START_ENHANCED_HUE_ID, &color_loop_start_hue);
+    return ESP_OK;
+}
+
 static void esp_zb_task(void *pvParameters)
 {
     /* initialize Zigbee stack */
@@ -234,38 +838,29 @@ static void esp_zb_task(void *pvParameters)
         0xC8, 0xCB, 0xC5, 0x2E, 0x5D, 0x65, 0xD1, 0xB8};
     esp_zb_secur_TC_standard_distributed_key_set(secret_zll_trust_center_key);
 
-esp_zb_color_dimmable_light_cfg_t light_cfg = ESP_ZB_DEFAULT_COLOR_DIMMABLE_LIGHT_CONFIG();
 esp_zb_ep_list_t *esp_zb_color_dimmable_light_ep = NULL;
 esp_zb_color_dimmable_light_ep = esp_zb_ep_list_create();
-esp_zb_endpoint_config_t endpoint_config = {
-    .endpoint = HA_COLOR_DIMMABLE_LIGHT_ENDPOINT,
-    .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
-    .app_device_id = ESP_ZB_HA_COLOR_DIMMABLE_LIGHT_DEVICE_ID,
-    .app_device_version = 1, // maybe important for Hue? Oh HELL yes.
-};
-esp_zb_ep_list_add_ep(esp_zb_color_dimmable_light_ep, esp_zb_color_dimmable_light_clusters_create(&light_cfg), endpoint_config);
-zcl_basic_manufacturer_info_t info = {
-    .manufacturer_name = ESP_MANUFACTURER_NAME,
-    .model_identifier = ESP_MODEL_IDENTIFIER,
-};
-
-esp_zcl_utility_add_ep_basic_manufacturer_info(esp_zb_color_dimmable_light_ep, HA_COLOR_DIMMABLE_LIGHT_ENDPOINT, &info);
+for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++)
+{
+    ESP_ERROR_CHECK(light_add_endpoint(esp_zb_color_dimmable_light_ep, i));
+}
 
-// https://github.com/espressif/esp-zigbee-sdk/issues/457#issuecomment-2426128314
-uint16_t on_off_on_time = 0;
-bool on_off_global_scene_control = 0;
+// hot path counters, pixel streaming and OTA upgrades on the first endpoint, see light_metrics.h, light_stream.h and light_ota.h
 esp_zb_cluster_list_t *cluster_list = esp_zb_ep_list_get_ep(esp_zb_color_dimmable_light_ep, HA_COLOR_DIMMABLE_LIGHT_ENDPOINT);
-esp_zb_attribute_list_t *onoff_attr_list =
-    esp_zb_cluster_list_get_cluster(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
-
-esp_zb_on_off_cluster_add_attr(onoff_attr_list, ESP_ZB_ZCL_ATTR_ON_OFF_ON_TIME, &on_off_on_time);
-esp_zb_on_off_cluster_add_attr(onoff_attr_list, ESP_ZB_ZCL_ATTR_ON_OFF_GLOBAL_SCENE_CONTROL,
-                               &on_off_global_scene_control);
-// .
+ESP_ERROR_CHECK(light_metrics_add_cluster(cluster_list));
+ESP_ERROR_CHECK(light_stream_add_cluster(cluster_list));
+ESP_ERROR_CHECK(light_ota_add_cluster(cluster_list));
 
 esp_zb_device_register(esp_zb_color_dimmable_light_ep);
+// default reporting of on/off, level and color, see light_report.h
+ESP_ERROR_CHECK(light_report_init());
 esp_zb_core_action_handler_register(zb_action_handler);
-esp_zb_set_primary_network_channel_set(ESP_ZB_PRIMARY_CHANNEL_MASK);
+for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++)
+{
+    esp_zb_identify_notify_handler_register(LIGHT_SEGMENT_ENDPOINT(i), s_identify_cbs[i]);
+}
+// last network's channel first, see light_commission.h
+ESP_ERROR_CHECK(light_commission_init(ESP_ZB_PRIMARY_CHANNEL_MASK));
 ESP_ERROR_CHECK(esp_zb_start(false));
 esp_zb_stack_main_loop();
 }
@@ -277,6 +872,23 @@ void app_main(void)
         .host_config = ESP_ZB_DEFAULT_HOST_CONFIG(),
     };
     ESP_ERROR_CHECK(nvs_flash_init());
+    /* show the saved state right away, long before the stack has loaded its NVRAM */
+    for (uint8_t i = 0; i < LIGHT_SEGMENT_COUNT; i++)
+    {
+        light_load_state(i);
+        light_apply_state(i);
+    }
+    light_driver_init();
+    light_boot_mark("first frame");
+    ESP_ERROR_CHECK(light_trace_start());
+    ESP_ERROR_CHECK(light_scene_init());
     ESP_ERROR_CHECK(esp_zb_platform_config(&config));
-    xTaskCreate(esp_zb_task, "Zigbee_main", 4096, NULL, 5, NULL);
+    /* the stack and TCB of every firmware task are static, see light_memory.h */
+    static StackType_t zb_task_stack[CONFIG_LIGHT_ZB_TASK_STACK_SIZE];
+    static StaticTask_t zb_task;
+    xTaskCreateStatic(esp_zb_task, "Zigbee_main", CONFIG_LIGHT_ZB_TASK_STACK_SIZE, NULL, CONFIG_LIGHT_ZB_TASK_PRIORITY,
+                      zb_task_stack, &zb_task);
+#if CONFIG_LIGHT_MEMORY_REPORT_ON_BOOT
+    light_memory_report("Boot");
+#endif
 }
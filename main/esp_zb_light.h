@@ -14,14 +14,38 @@
 
 #include "esp_zigbee_core.h"
 #include "light_driver.h"
+#include "light_bench.h"
+#include "light_color.h"
 #include "zcl_utility.h"
 
 /* Zigbee configuration */
 #define MAX_CHILDREN                      10                                    /* the max amount of connected devices */
 #define INSTALLCODE_POLICY_ENABLE         false                                 /* enable the install code policy for security */
 #define HA_COLOR_DIMMABLE_LIGHT_ENDPOINT  10                                    /* esp light switch device endpoint */
+#define LIGHT_SEGMENT_COUNT               CONFIG_LIGHT_DRIVER_SEGMENTS          /* one light endpoint per strip segment */
+#define LIGHT_SEGMENT_ENDPOINT(index)     (HA_COLOR_DIMMABLE_LIGHT_ENDPOINT + (index))
 #define ESP_ZB_PRIMARY_CHANNEL_MASK       ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK  /* Zigbee primary channel mask use in the example */
 
+/* Light rendering */
+#define LIGHT_COMMIT_RETRY_MS             10                                    /* retry delay when the render queue is full */
+#define LIGHT_COLOR_CT_DEFAULT_MIREDS     370                                   /* warm white until told otherwise */
+#define LIGHT_COLOR_CAPABILITIES          0x001f                                /* hue/sat, enhanced hue, color loop, xy, color temperature */
+#define LIGHT_COLOR_LOOP_TIME_DEFAULT_S   25                                    /* ColorLoopTime until told otherwise */
+#define LIGHT_COLOR_LOOP_HUE_DEFAULT      0x2300                                /* ColorLoopStartEnhancedHue until told otherwise */
+#define LIGHT_BREATHE_CYCLES              15                                    /* TriggerEffect Breathe: fade up and down this often */
+#define LIGHT_LEVEL_MIN                   1                                     /* MinLevel, what StartUpCurrentLevel 0x00 restores */
+#define LIGHT_LEVEL_DEFAULT               0xfe                                  /* full brightness until told otherwise */
+#define LIGHT_START_UP_LEVEL_MINIMUM      0x00                                  /* StartUpCurrentLevel: come up at MinLevel */
+#define LIGHT_START_UP_LEVEL_PREVIOUS     0xff                                  /* StartUpCurrentLevel: come up at the last level */
+
+/* Identify TriggerEffect effect identifiers */
+#define LIGHT_IDENTIFY_EFFECT_BLINK           0x00
+#define LIGHT_IDENTIFY_EFFECT_BREATHE         0x01
+#define LIGHT_IDENTIFY_EFFECT_OKAY            0x02
+#define LIGHT_IDENTIFY_EFFECT_CHANNEL_CHANGE  0x0b
+#define LIGHT_IDENTIFY_EFFECT_FINISH          0xfe
+#define LIGHT_IDENTIFY_EFFECT_STOP            0xff
+
 /* Basic manufacturer information */
 #define ESP_MANUFACTURER_NAME "\x09""ESPRESSIF"      /* Customized manufacturer name */
 #define ESP_MODEL_IDENTIFIER "\x07"CONFIG_IDF_TARGET /* Customized model identifier */
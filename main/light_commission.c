@@ -0,0 +1,162 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <string.h>
+#include "light_commission.h"
+#include "sdkconfig.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "nvs.h"
+
+#define LIGHT_COMMISSION_NAMESPACE      "light"
+#define LIGHT_COMMISSION_KEY            "nwk"
+#define LIGHT_COMMISSION_VERSION        1
+#define LIGHT_COMMISSION_JITTER_PCT     25      /* each delay is randomized by +-25% */
+#define LIGHT_COMMISSION_CHANNEL_MIN    11
+#define LIGHT_COMMISSION_CHANNEL_MAX    26
+
+static const char *TAG = "LIGHT_COMMISSION";
+
+/* the network last joined, stored as a blob */
+typedef struct {
+    uint8_t version;
+    uint8_t channel;
+    uint16_t pan_id;
+    esp_zb_ieee_addr_t ext_pan_id;
+} light_commission_cache_t;
+
+_Static_assert(sizeof(light_commission_cache_t) == 12, "light_commission_cache_t must not have padding");
+
+static nvs_handle_t s_handle;
+static bool s_open = false;
+static light_commission_cache_t s_cache;
+static bool s_cached = false;
+static bool s_steering = false;
+static int64_t s_started_us;
+static uint32_t s_attempts;
+
+static void light_commission_save(void)
+{
+    if (!s_open)
+    {
+        return;
+    }
+    esp_err_t err = nvs_set_blob(s_handle, LIGHT_COMMISSION_KEY, &s_cache, sizeof(s_cache));
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(s_handle);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to save network (%s)", esp_err_to_name(err));
+    }
+}
+
+/* exponential backoff between CONFIG_LIGHT_COMMISSION_BACKOFF_MIN_MS and _MAX_MS, plus jitter */
+static uint32_t light_commission_backoff_ms(uint32_t attempts)
+{
+    uint32_t delay_ms = CONFIG_LIGHT_COMMISSION_BACKOFF_MIN_MS;
+    while (--attempts && delay_ms < CONFIG_LIGHT_COMMISSION_BACKOFF_MAX_MS)
+    {
+        delay_ms <<= 1;
+    }
+    if (delay_ms > CONFIG_LIGHT_COMMISSION_BACKOFF_MAX_MS)
+    {
+        delay_ms = CONFIG_LIGHT_COMMISSION_BACKOFF_MAX_MS;
+    }
+    uint32_t jitter_ms = delay_ms / 100 * LIGHT_COMMISSION_JITTER_PCT;
+    return delay_ms - jitter_ms + esp_random() % (2 * jitter_ms + 1);
+}
+
+static void light_commission_begin(void)
+{
+    if (!s_steering)
+    {
+        s_steering = true;
+        s_started_us = esp_timer_get_time();
+        s_attempts = 0;
+    }
+}
+
+static void light_commission_retry_cb(uint8_t param)
+{
+    /* joined in the meantime, e.g. the stack rejoined on its own */
+    if (s_steering)
+    {
+        light_commission_start();
+    }
+}
+
+void light_commission_start(void)
+{
+    light_commission_begin();
+    ESP_RETURN_ON_FALSE(esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING) == ESP_OK, , TAG,
+                        "Failed to start Zigbee commissioning");
+}
+
+void light_commission_failed(void)
+{
+    light_commission_begin();
+    uint32_t delay_ms = light_commission_backoff_ms(++s_attempts);
+    ESP_LOGI(TAG, "Steering attempt %lu failed, retrying in %lu ms", (unsigned long)s_attempts, (unsigned long)delay_ms);
+    esp_zb_scheduler_alarm(light_commission_retry_cb, 0, delay_ms);
+}
+
+uint32_t light_commission_joined(void)
+{
+    uint32_t joined_ms = s_steering ? (uint32_t)((esp_timer_get_time() - s_started_us) / 1000) : 0;
+    if (s_steering)
+    {
+        ESP_LOGI(TAG, "Joined after %lu ms, %lu failed attempts", (unsigned long)joined_ms, (unsigned long)s_attempts);
+    }
+    s_steering = false;
+    s_attempts = 0;
+
+    light_commission_cache_t joined = {
+        .version = LIGHT_COMMISSION_VERSION,
+        .channel = esp_zb_get_current_channel(),
+        .pan_id = esp_zb_get_pan_id(),
+    };
+    esp_zb_get_extended_pan_id(joined.ext_pan_id);
+    if (!s_cached || memcmp(&joined, &s_cache, sizeof(joined)))
+    {
+        s_cache = joined;
+        s_cached = true;
+        light_commission_save();
+    }
+    return joined_ms;
+}
+
+esp_err_t light_commission_init(uint32_t channel_mask)
+{
+    if (!s_open)
+    {
+        ESP_RETURN_ON_ERROR(nvs_open(LIGHT_COMMISSION_NAMESPACE, NVS_READWRITE, &s_handle), TAG, "Failed to open NVS namespace");
+        s_open = true;
+    }
+    size_t size = sizeof(s_cache);
+    s_cached = nvs_get_blob(s_handle, LIGHT_COMMISSION_KEY, &s_cache, &size) == ESP_OK && size == sizeof(s_cache) &&
+               s_cache.version == LIGHT_COMMISSION_VERSION && s_cache.channel >= LIGHT_COMMISSION_CHANNEL_MIN &&
+               s_cache.channel <= LIGHT_COMMISSION_CHANNEL_MAX && (channel_mask & (1UL << s_cache.channel));
+    if (!s_cached)
+    {
+        return esp_zb_set_primary_network_channel_set(channel_mask);
+    }
+    ESP_LOGI(TAG, "Last network: channel %d, PAN ID 0x%04hx, trying it first", s_cache.channel, s_cache.pan_id);
+    ESP_RETURN_ON_ERROR(esp_zb_set_primary_network_channel_set(1UL << s_cache.channel), TAG, "Failed to set primary channel");
+    return esp_zb_set_secondary_network_channel_set(channel_mask);
+}
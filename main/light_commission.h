@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/* Network steering with a memory. The channel, PAN ID and extended PAN ID
+ * of the last network joined are kept in NVS; steering scans that channel
+ * first (primary channel set) and only then all allowed channels
+ * (secondary channel set). Failed attempts are retried with exponential
+ * backoff plus jitter, so a room full of bulbs does not beacon in step. */
+
+/**
+* @brief Load the cached network and set the channel sets, before esp_zb_start()
+*
+* @param  channel_mask  all channels the light may join on
+*/
+esp_err_t light_commission_init(uint32_t channel_mask);
+
+/**
+* @brief Start network steering, or retry it, from the Zigbee task
+*/
+void light_commission_start(void);
+
+/**
+* @brief Steering failed: schedule the next attempt after a backoff
+*/
+void light_commission_failed(void);
+
+/**
+* @brief Steering succeeded: cache the network if it changed
+*
+* @return ms since the first steering attempt of this round, 0 if none was running
+*/
+uint32_t light_commission_joined(void);
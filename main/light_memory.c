@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "light_memory.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "LIGHT_MEMORY";
+
+static const char *const s_task_names[LIGHT_MEMORY_TASK_COUNT] = {
+    [LIGHT_MEMORY_TASK_ZIGBEE] = "Zigbee_main",
+    [LIGHT_MEMORY_TASK_RENDER] = "light_render",
+    [LIGHT_MEMORY_TASK_TRACE] = "light_trace",
+};
+
+void light_memory_get_stats(light_memory_stats_t *stats)
+{
+    stats->heap_free = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    stats->heap_free_min = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    stats->heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+    for (int i = 0; i < LIGHT_MEMORY_TASK_COUNT; i++)
+    {
+        /* tasks disabled in Kconfig, or not started yet, report 0 */
+        TaskHandle_t task = xTaskGetHandle(s_task_names[i]);
+        stats->stack_hwm[i] = task ? uxTaskGetStackHighWaterMark(task) : 0;
+    }
+}
+
+void light_memory_report(const char *when)
+{
+    light_memory_stats_t stats;
+    light_memory_get_stats(&stats);
+    ESP_LOGI(TAG, "%s: heap free %lu, min free %lu, largest block %lu", when, (unsigned long)stats.heap_free,
+             (unsigned long)stats.heap_free_min, (unsigned long)stats.heap_largest_block);
+    for (int i = 0; i < LIGHT_MEMORY_TASK_COUNT; i++)
+    {
+        if (stats.stack_hwm[i])
+        {
+            ESP_LOGI(TAG, "%s: %s stack never used %lu", when, s_task_names[i], (unsigned long)stats.stack_hwm[i]);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Memory report: the firmware's own tasks and buffers are statically
+ * allocated and sized from Kconfig, so what is left to watch at runtime is
+ * the stack headroom of those tasks and the heap the Zigbee stack and the
+ * IDF allocate from. The static footprint itself is checked at build time by
+ * main/tools/check_memory_budget.py. */
+
+/** Firmware tasks whose stacks are reported, see light_memory_stats_t */
+typedef enum {
+    LIGHT_MEMORY_TASK_ZIGBEE,       /*!< "Zigbee_main", CONFIG_LIGHT_ZB_TASK_STACK_SIZE */
+    LIGHT_MEMORY_TASK_RENDER,       /*!< "light_render", CONFIG_LIGHT_DRIVER_RENDER_TASK_STACK_SIZE */
+    LIGHT_MEMORY_TASK_TRACE,        /*!< "light_trace", CONFIG_LIGHT_TRACE_DRAIN_TASK_STACK_SIZE */
+    LIGHT_MEMORY_TASK_COUNT,
+} light_memory_task_t;
+
+typedef struct {
+    uint32_t heap_free;                                 /*!< Free default heap now, in bytes */
+    uint32_t heap_free_min;                             /*!< Lowest free default heap since boot */
+    uint32_t heap_largest_block;                        /*!< Largest block one allocation can get */
+    uint32_t stack_hwm[LIGHT_MEMORY_TASK_COUNT];        /*!< Stack never used by each task, in bytes; 0 if it is not running */
+} light_memory_stats_t;
+
+void light_memory_get_stats(light_memory_stats_t *stats);
+
+/**
+* @brief Log the heap and per-task stack headroom
+*
+* @param  when  what the report follows, for the log line
+*/
+void light_memory_report(const char *when);
@@ -0,0 +1,190 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "light_metrics.h"
+#include "light_memory.h"
+#include "light_report.h"
+#include "light_scene.h"
+#include "light_store.h"
+#include "light_stream.h"
+#include "esp_zb_light.h"
+#include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "LIGHT_METRICS";
+
+/* all counters are only touched from the Zigbee task, no locking */
+static struct
+{
+    uint32_t on_off_writes;
+    uint32_t level_writes;
+    uint32_t color_writes;
+    uint32_t other_writes;
+    uint32_t handler_hist[LIGHT_DRIVER_HIST_BUCKETS];
+    uint32_t steering_retries;
+    uint32_t rejoins;
+    uint32_t leaves;
+    uint32_t join_ms_last;
+} s_metrics;
+
+void light_metrics_attr_write(uint16_t cluster_id, uint32_t cycles)
+{
+    switch (cluster_id)
+    {
+    case ESP_ZB_ZCL_CLUSTER_ID_ON_OFF:
+        s_metrics.on_off_writes++;
+        break;
+    case ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL:
+        s_metrics.level_writes++;
+        break;
+    case ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL:
+        s_metrics.color_writes++;
+        break;
+    default:
+        s_metrics.other_writes++;
+        break;
+    }
+    s_metrics.handler_hist[light_driver_hist_bucket(cycles, LIGHT_METRICS_HANDLER_BASE_BITS)]++;
+}
+
+void light_metrics_steering_retry(void)
+{
+    s_metrics.steering_retries++;
+}
+
+void light_metrics_rejoin(void)
+{
+    s_metrics.rejoins++;
+}
+
+void light_metrics_leave(void)
+{
+    s_metrics.leaves++;
+}
+
+void light_metrics_joined(uint32_t join_ms)
+{
+    s_metrics.join_ms_last = join_ms;
+}
+
+esp_err_t light_metrics_add_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+    /* the stack copies the initial values, zero is right for all of them */
+    uint32_t zero = 0;
+    esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(LIGHT_METRICS_CLUSTER_ID);
+    ESP_RETURN_ON_FALSE(attr_list, ESP_ERR_NO_MEM, TAG, "Failed to create metrics cluster");
+    static const uint16_t scalar_attrs[] = {
+        LIGHT_METRICS_ATTR_ON_OFF_WRITES, LIGHT_METRICS_ATTR_LEVEL_WRITES, LIGHT_METRICS_ATTR_COLOR_WRITES,
+        LIGHT_METRICS_ATTR_OTHER_WRITES, LIGHT_METRICS_ATTR_LED_REFRESHES, LIGHT_METRICS_ATTR_LED_REFRESH_US_MAX,
+        LIGHT_METRICS_ATTR_RENDER_DROPPED, LIGHT_METRICS_ATTR_RENDER_OVERWRITTEN, LIGHT_METRICS_ATTR_LED_POWER_LIMITED,
+        LIGHT_METRICS_ATTR_LED_POWER_MA_MAX, LIGHT_METRICS_ATTR_STEERING_RETRIES, LIGHT_METRICS_ATTR_REJOINS,
+        LIGHT_METRICS_ATTR_LEAVES, LIGHT_METRICS_ATTR_JOIN_MS_LAST, LIGHT_METRICS_ATTR_ZB_STACK_HWM,
+        LIGHT_METRICS_ATTR_NVS_WRITES, LIGHT_METRICS_ATTR_NVS_WRITES_AVOIDED, LIGHT_METRICS_ATTR_STREAM_FRAMES,
+        LIGHT_METRICS_ATTR_STREAM_DROPPED, LIGHT_METRICS_ATTR_RENDER_STACK_HWM, LIGHT_METRICS_ATTR_TRACE_STACK_HWM,
+        LIGHT_METRICS_ATTR_HEAP_FREE, LIGHT_METRICS_ATTR_HEAP_FREE_MIN, LIGHT_METRICS_ATTR_HEAP_LARGEST_BLOCK,
+        LIGHT_METRICS_ATTR_REPORTS_EST, LIGHT_METRICS_ATTR_REPORTED_ATTRS_EST, LIGHT_METRICS_ATTR_REPORTS_SUPPRESSED_EST,
+        LIGHT_METRICS_ATTR_SCENE_RECALLS, LIGHT_METRICS_ATTR_SCENE_RECALL_US_MAX, LIGHT_METRICS_ATTR_SCENES,
+    };
+    for (size_t i = 0; i < sizeof(scalar_attrs) / sizeof(scalar_attrs[0]); i++)
+    {
+        ESP_RETURN_ON_ERROR(esp_zb_custom_cluster_add_custom_attr(attr_list, scalar_attrs[i], ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                                  ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &zero),
+                            TAG, "Failed to add metrics attribute 0x%04x", scalar_attrs[i]);
+    }
+    for (uint16_t i = 0; i < LIGHT_DRIVER_HIST_BUCKETS; i++)
+    {
+        ESP_RETURN_ON_ERROR(esp_zb_custom_cluster_add_custom_attr(attr_list, LIGHT_METRICS_ATTR_HANDLER_HIST + i, ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                                  ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &zero),
+                            TAG, "Failed to add handler histogram");
+        ESP_RETURN_ON_ERROR(esp_zb_custom_cluster_add_custom_attr(attr_list, LIGHT_METRICS_ATTR_LED_REFRESH_HIST + i, ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                                  ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &zero),
+                            TAG, "Failed to add refresh histogram");
+    }
+    return esp_zb_cluster_list_add_custom_cluster(cluster_list, attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+static void light_metrics_set(uint16_t attr_id, uint32_t value)
+{
+    esp_zb_zcl_set_attribute_val(HA_COLOR_DIMMABLE_LIGHT_ENDPOINT, LIGHT_METRICS_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id,
+                                 &value, false);
+}
+
+void light_metrics_refresh(void)
+{
+    light_driver_stats_t stats;
+    light_store_stats_t store_stats;
+    light_stream_stats_t stream_stats;
+    light_memory_stats_t memory_stats;
+    light_report_stats_t report_stats;
+    light_scene_stats_t scene_stats;
+    light_driver_get_stats(&stats);
+    light_store_get_stats(&store_stats);
+    light_stream_get_stats(&stream_stats);
+    light_memory_get_stats(&memory_stats);
+    light_report_get_stats(&report_stats);
+    light_scene_get_stats(&scene_stats);
+    light_metrics_set(LIGHT_METRICS_ATTR_ON_OFF_WRITES, s_metrics.on_off_writes);
+    light_metrics_set(LIGHT_METRICS_ATTR_LEVEL_WRITES, s_metrics.level_writes);
+    light_metrics_set(LIGHT_METRICS_ATTR_COLOR_WRITES, s_metrics.color_writes);
+    light_metrics_set(LIGHT_METRICS_ATTR_OTHER_WRITES, s_metrics.other_writes);
+    light_metrics_set(LIGHT_METRICS_ATTR_LED_REFRESHES, stats.frames);
+    light_metrics_set(LIGHT_METRICS_ATTR_LED_REFRESH_US_MAX, stats.refresh_us_max);
+    light_metrics_set(LIGHT_METRICS_ATTR_RENDER_DROPPED, stats.dropped);
+    light_metrics_set(LIGHT_METRICS_ATTR_RENDER_OVERWRITTEN, stats.overwritten);
+    light_metrics_set(LIGHT_METRICS_ATTR_LED_POWER_LIMITED, stats.power_limited);
+    light_metrics_set(LIGHT_METRICS_ATTR_LED_POWER_MA_MAX, stats.power_ma_max);
+    for (uint16_t i = 0; i < LIGHT_DRIVER_HIST_BUCKETS; i++)
+    {
+        light_metrics_set(LIGHT_METRICS_ATTR_HANDLER_HIST + i, s_metrics.handler_hist[i]);
+        light_metrics_set(LIGHT_METRICS_ATTR_LED_REFRESH_HIST + i, stats.refresh_hist[i]);
+    }
+    light_metrics_set(LIGHT_METRICS_ATTR_STEERING_RETRIES, s_metrics.steering_retries);
+    light_metrics_set(LIGHT_METRICS_ATTR_REJOINS, s_metrics.rejoins);
+    light_metrics_set(LIGHT_METRICS_ATTR_LEAVES, s_metrics.leaves);
+    light_metrics_set(LIGHT_METRICS_ATTR_JOIN_MS_LAST, s_metrics.join_ms_last);
+    /* runs on the Zigbee task, so this is its own stack */
+    light_metrics_set(LIGHT_METRICS_ATTR_ZB_STACK_HWM, uxTaskGetStackHighWaterMark(NULL));
+    light_metrics_set(LIGHT_METRICS_ATTR_RENDER_STACK_HWM, memory_stats.stack_hwm[LIGHT_MEMORY_TASK_RENDER]);
+    light_metrics_set(LIGHT_METRICS_ATTR_TRACE_STACK_HWM, memory_stats.stack_hwm[LIGHT_MEMORY_TASK_TRACE]);
+    light_metrics_set(LIGHT_METRICS_ATTR_HEAP_FREE, memory_stats.heap_free);
+    light_metrics_set(LIGHT_METRICS_ATTR_HEAP_FREE_MIN, memory_stats.heap_free_min);
+    light_metrics_set(LIGHT_METRICS_ATTR_HEAP_LARGEST_BLOCK, memory_stats.heap_largest_block);
+    light_metrics_set(LIGHT_METRICS_ATTR_NVS_WRITES, store_stats.writes);
+    light_metrics_set(LIGHT_METRICS_ATTR_NVS_WRITES_AVOIDED, store_stats.avoided);
+    light_metrics_set(LIGHT_METRICS_ATTR_STREAM_FRAMES, stream_stats.frames);
+    light_metrics_set(LIGHT_METRICS_ATTR_STREAM_DROPPED, stream_stats.dropped);
+    light_metrics_set(LIGHT_METRICS_ATTR_REPORTS_EST, report_stats.reports_est);
+    light_metrics_set(LIGHT_METRICS_ATTR_REPORTED_ATTRS_EST, report_stats.attributes_est);
+    light_metrics_set(LIGHT_METRICS_ATTR_REPORTS_SUPPRESSED_EST, report_stats.suppressed_est);
+    light_metrics_set(LIGHT_METRICS_ATTR_SCENE_RECALLS, scene_stats.recalls);
+    light_metrics_set(LIGHT_METRICS_ATTR_SCENE_RECALL_US_MAX, scene_stats.recall_us_max);
+    light_metrics_set(LIGHT_METRICS_ATTR_SCENES, scene_stats.used);
+}
+
+static void light_metrics_publish(uint8_t param)
+{
+    light_metrics_refresh();
+    esp_zb_scheduler_alarm(light_metrics_publish, 0, LIGHT_METRICS_PUBLISH_MS);
+}
+
+void light_metrics_start(void)
+{
+    static bool started = false;
+    if (!started)
+    {
+        started = true;
+        light_metrics_publish(0);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+/* Hot path counters, readable as attributes of a manufacturer specific
+ * cluster on the light endpoint. Recording is a counter increment (plus a
+ * histogram bucket for latencies); the attributes are refreshed from the
+ * counters every LIGHT_METRICS_PUBLISH_MS on the Zigbee task. */
+
+#define LIGHT_METRICS_CLUSTER_ID          0xFC10    /* manufacturer specific cluster range */
+#define LIGHT_METRICS_PUBLISH_MS          10000     /* attribute refresh period */
+#define LIGHT_METRICS_HANDLER_BASE_BITS   10        /* handler histogram starts at 1024 cycles */
+#define LIGHT_METRICS_CMD_REFRESH         0x00      /* refresh the attributes now and log a memory report */
+
+/** Attributes of LIGHT_METRICS_CLUSTER_ID, all U32 and read only */
+enum {
+    LIGHT_METRICS_ATTR_ON_OFF_WRITES = 0x0000,          /*!< On/Off attribute callbacks */
+    LIGHT_METRICS_ATTR_LEVEL_WRITES = 0x0001,           /*!< Level Control attribute callbacks */
+    LIGHT_METRICS_ATTR_COLOR_WRITES = 0x0002,           /*!< Color Control attribute callbacks */
+    LIGHT_METRICS_ATTR_OTHER_WRITES = 0x0003,           /*!< Attribute callbacks of any other cluster */
+    LIGHT_METRICS_ATTR_HANDLER_HIST = 0x0010,           /*!< 0x0010..0x0017: attribute callback CPU cycles, log2 buckets */
+    LIGHT_METRICS_ATTR_LED_REFRESHES = 0x0020,          /*!< Frames pushed to the strip */
+    LIGHT_METRICS_ATTR_LED_REFRESH_US_MAX = 0x0021,     /*!< Longest wait for the strip in one frame, in us */
+    LIGHT_METRICS_ATTR_RENDER_DROPPED = 0x0022,         /*!< Segment commands rejected by a full render queue */
+    LIGHT_METRICS_ATTR_RENDER_OVERWRITTEN = 0x0023,     /*!< Segment commands superseded before rendering */
+    LIGHT_METRICS_ATTR_LED_POWER_LIMITED = 0x0024,      /*!< Frames scaled down to the strip current budget */
+    LIGHT_METRICS_ATTR_LED_POWER_MA_MAX = 0x0025,       /*!< Highest estimated strip current of a frame before limiting, in mA */
+    LIGHT_METRICS_ATTR_LED_REFRESH_HIST = 0x0030,       /*!< 0x0030..0x0037: strip wait per frame in us, log2 buckets */
+    LIGHT_METRICS_ATTR_STEERING_RETRIES = 0x0040,       /*!< Failed network steering attempts */
+    LIGHT_METRICS_ATTR_REJOINS = 0x0041,                /*!< Rejoins of a known network after reboot */
+    LIGHT_METRICS_ATTR_LEAVES = 0x0042,                 /*!< ZDO leave signals */
+    LIGHT_METRICS_ATTR_JOIN_MS_LAST = 0x0043,           /*!< Time the last network steering round took to join, in ms */
+    LIGHT_METRICS_ATTR_ZB_STACK_HWM = 0x0050,           /*!< Zigbee task stack high-water mark in bytes */
+    LIGHT_METRICS_ATTR_RENDER_STACK_HWM = 0x0051,       /*!< Render task stack high-water mark, 0 without the task */
+    LIGHT_METRICS_ATTR_TRACE_STACK_HWM = 0x0052,        /*!< Trace drain task stack high-water mark, 0 without the task */
+    LIGHT_METRICS_ATTR_HEAP_FREE = 0x0053,              /*!< Free default heap in bytes */
+    LIGHT_METRICS_ATTR_HEAP_FREE_MIN = 0x0054,          /*!< Lowest free default heap since boot */
+    LIGHT_METRICS_ATTR_HEAP_LARGEST_BLOCK = 0x0055,     /*!< Largest free block of the default heap */
+    LIGHT_METRICS_ATTR_NVS_WRITES = 0x0060,             /*!< Light state blobs written to flash */
+    LIGHT_METRICS_ATTR_NVS_WRITES_AVOIDED = 0x0061,     /*!< Light state changes coalesced into another write */
+    LIGHT_METRICS_ATTR_STREAM_FRAMES = 0x0070,          /*!< Streamed frames shown, see light_stream.h */
+    LIGHT_METRICS_ATTR_STREAM_DROPPED = 0x0071,         /*!< Stream chunks dropped */
+    LIGHT_METRICS_ATTR_REPORTS_EST = 0x0080,            /*!< Report Attributes frames, modelled, see light_report.h */
+    LIGHT_METRICS_ATTR_REPORTED_ATTRS_EST = 0x0081,     /*!< Attribute records in those frames, modelled */
+    LIGHT_METRICS_ATTR_REPORTS_SUPPRESSED_EST = 0x0082, /*!< Attribute changes that did not cause a frame of their own, modelled */
+    LIGHT_METRICS_ATTR_SCENE_RECALLS = 0x0090,          /*!< Scenes recalled, see light_scene.h */
+    LIGHT_METRICS_ATTR_SCENE_RECALL_US_MAX = 0x0091,    /*!< Longest time from Recall Scene to its frame being queued, in us */
+    LIGHT_METRICS_ATTR_SCENES = 0x0092,                 /*!< Scene table entries in use */
+};
+
+/**
+* @brief Count an attribute callback and its duration
+*
+* @param  cluster_id  cluster of the attribute
+* @param  cycles      CPU cycles the callback took
+*/
+void light_metrics_attr_write(uint16_t cluster_id, uint32_t cycles);
+
+void light_metrics_steering_retry(void);
+void light_metrics_rejoin(void);
+void light_metrics_leave(void);
+void light_metrics_joined(uint32_t join_ms);
+
+/**
+* @brief Add the metrics cluster to the light endpoint, before esp_zb_device_register()
+*/
+esp_err_t light_metrics_add_cluster(esp_zb_cluster_list_t *cluster_list);
+
+/**
+* @brief Refresh the attributes now and every LIGHT_METRICS_PUBLISH_MS, from the Zigbee task
+*/
+void light_metrics_start(void);
+
+/**
+* @brief Refresh the attributes now, for the Refresh command; the periodic refresh goes on
+*/
+void light_metrics_refresh(void);
@@ -0,0 +1,472 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "light_ota.h"
+#include "light_trace.h"
+#include "sdkconfig.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "nvs.h"
+
+/* only touched from the Zigbee task, no locking */
+static light_ota_stats_t s_stats;
+
+#if CONFIG_LIGHT_OTA
+
+#define LIGHT_OTA_NAMESPACE         "light_ota"
+#define LIGHT_OTA_KEY               "progress"
+#define LIGHT_OTA_VERSION           1
+#define LIGHT_OTA_CHECKPOINT_BYTES  (CONFIG_LIGHT_OTA_CHECKPOINT_KB * 1024U)
+#define LIGHT_OTA_SECTOR_SIZE       0x1000
+#define LIGHT_OTA_REHASH_CHUNK      256
+
+_Static_assert(LIGHT_OTA_CHECKPOINT_BYTES % LIGHT_OTA_SECTOR_SIZE == 0,
+               "checkpoints must fall on flash sectors, esp_ota_resume() erases from there");
+
+static const char *TAG = "LIGHT_OTA";
+
+/* a download, and what is saved of it: enough to pick it up again at a
+ * checkpoint of the image; no padding, it is stored as a blob */
+typedef struct
+{
+    uint8_t version;            /* LIGHT_OTA_VERSION, 0 if there is no download */
+    uint8_t reserved;
+    uint16_t manufacturer_code;
+    uint16_t image_type;
+    uint16_t reserved2;
+    uint32_t file_version;
+    uint32_t file_size;         /* after the upgrade file header */
+    uint32_t file_offset;       /* of that, bytes received */
+    uint32_t image_offset;      /* upgrade image bytes in the slot */
+    uint32_t image_size;        /* upgrade image sub-element length, 0 until its header arrived */
+} light_ota_progress_t;
+
+_Static_assert(sizeof(light_ota_progress_t) == 28, "light_ota_progress_t must not have padding");
+
+static struct
+{
+    light_ota_progress_t saved;         /* last checkpoint, in NVS */
+    light_ota_progress_t current;
+    const esp_partition_t *partition;
+    esp_ota_handle_t handle;
+    mbedtls_sha256_context sha;         /* of the upgrade image so far */
+    uint8_t tag_header[LIGHT_OTA_TAG_HEADER_SIZE];
+    uint8_t tag_header_len;             /* bytes of the next sub-element header so far */
+    uint16_t tag;                       /* current sub-element */
+    uint32_t tag_remaining;             /* its data still to come */
+    uint8_t sha256[LIGHT_OTA_SHA256_SIZE];
+    uint8_t sha256_len;
+    uint8_t endpoint;
+    bool active;                        /* handle is open */
+    bool verified;                      /* ready to switch slots */
+    uint32_t start_ms;
+} s_ota;
+
+static nvs_handle_t s_handle;
+static bool s_open = false;
+
+static uint32_t light_ota_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void light_ota_save(const light_ota_progress_t *progress)
+{
+    if (!memcmp(progress, &s_ota.saved, sizeof(s_ota.saved)))
+    {
+        return;
+    }
+    s_ota.saved = *progress;
+    if (!s_open)
+    {
+        return;
+    }
+    esp_err_t err = progress->version ? nvs_set_blob(s_handle, LIGHT_OTA_KEY, progress, sizeof(*progress))
+                                      : nvs_erase_key(s_handle, LIGHT_OTA_KEY);
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND)
+    {
+        err = nvs_commit(s_handle);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to save OTA progress (%s)", esp_err_to_name(err));
+    }
+}
+
+/* where the stack should continue: FileOffset counts the upgrade file header */
+static void light_ota_announce(void)
+{
+    uint32_t file_offset = s_ota.saved.version ? LIGHT_OTA_FILE_HEADER_SIZE + s_ota.saved.file_offset : 0;
+    uint32_t file_version = s_ota.saved.version ? s_ota.saved.file_version : ESP_ZB_ZCL_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_DEF_VALUE;
+    esp_zb_zcl_set_attribute_val(s_ota.endpoint, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE,
+                                 ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID, &file_offset, false);
+    esp_zb_zcl_set_attribute_val(s_ota.endpoint, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE,
+                                 ESP_ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_ID, &file_version, false);
+}
+
+static void light_ota_update_rate(void)
+{
+    s_stats.received = s_ota.current.file_offset;
+    s_stats.elapsed_ms = light_ota_now_ms() - s_ota.start_ms;
+    s_stats.bytes_per_s =
+        s_stats.elapsed_ms ? (uint32_t)((uint64_t)(s_stats.received - s_stats.resumed_from) * 1000 / s_stats.elapsed_ms) : 0;
+}
+
+static void light_ota_close(void)
+{
+    if (s_ota.active)
+    {
+        esp_ota_abort(s_ota.handle);
+        s_ota.active = false;
+    }
+    s_ota.verified = false;
+    mbedtls_sha256_free(&s_ota.sha);
+}
+
+/* a broken image is not resumed, the next download starts over */
+static esp_err_t light_ota_fail(light_ota_step_t step, esp_err_t err)
+{
+    light_ota_close();
+    light_ota_update_rate();
+    light_ota_save(&(light_ota_progress_t) { 0 });
+    light_ota_announce();
+    s_stats.failures++;
+    LIGHT_LOGW(OTA_FAIL, s_ota.current.file_offset, s_ota.current.file_size, step, err);
+    return err;
+}
+
+/* save a checkpoint once the image has grown past the next one. Only while
+ * no byte beyond the image was taken, so the checkpoint's file offset is
+ * the image offset's. */
+static void light_ota_checkpoint(void)
+{
+    const light_ota_progress_t *current = &s_ota.current;
+    if (s_ota.tag != LIGHT_OTA_TAG_UPGRADE_IMAGE || !current->image_size || s_ota.tag_header_len)
+    {
+        return;
+    }
+    uint32_t image_offset = current->image_offset - current->image_offset % LIGHT_OTA_CHECKPOINT_BYTES;
+    if (!image_offset || (s_ota.saved.version && image_offset <= s_ota.saved.image_offset))
+    {
+        return;
+    }
+    light_ota_progress_t progress = *current;
+    progress.file_offset -= current->image_offset - image_offset;
+    progress.image_offset = image_offset;
+    light_ota_save(&progress);
+    s_stats.checkpoints++;
+}
+
+/* hash what an earlier download left in the slot, instead of saving the hash state */
+static esp_err_t light_ota_rehash(uint32_t size)
+{
+    uint8_t chunk[LIGHT_OTA_REHASH_CHUNK];
+    for (uint32_t offset = 0; offset < size; offset += sizeof(chunk))
+    {
+        uint32_t n = size - offset < sizeof(chunk) ? size - offset : sizeof(chunk);
+        ESP_RETURN_ON_ERROR(esp_partition_read(s_ota.partition, offset, chunk, n), TAG, "Failed to read back the update slot");
+        mbedtls_sha256_update(&s_ota.sha, chunk, n);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t light_ota_start(const esp_zb_zcl_ota_upgrade_value_message_t *message)
+{
+    light_ota_close();
+    s_ota.endpoint = message->info.dst_endpoint;
+    s_ota.current = (light_ota_progress_t) {
+        .version = LIGHT_OTA_VERSION,
+        .manufacturer_code = message->ota_header.manufacturer_code,
+        .image_type = message->ota_header.image_type,
+        .file_version = message->ota_header.file_version,
+        .file_size = message->ota_header.image_size,
+    };
+    s_ota.tag_header_len = 0;
+    s_ota.tag = LIGHT_OTA_TAG_UPGRADE_IMAGE;
+    s_ota.tag_remaining = 0;
+    s_ota.sha256_len = 0;
+    s_ota.start_ms = light_ota_now_ms();
+    memset(&s_stats, 0, offsetof(light_ota_stats_t, checkpoints));
+    s_stats.file_version = s_ota.current.file_version;
+    s_stats.image_size = s_ota.current.file_size;
+    mbedtls_sha256_init(&s_ota.sha);
+    mbedtls_sha256_starts(&s_ota.sha, 0);
+
+    s_ota.partition = esp_ota_get_next_update_partition(NULL);
+    if (!s_ota.partition)
+    {
+        return light_ota_fail(LIGHT_OTA_STEP_START, ESP_ERR_NOT_FOUND);
+    }
+    const light_ota_progress_t *saved = &s_ota.saved;
+    bool resume = saved->version && saved->manufacturer_code == s_ota.current.manufacturer_code &&
+                  saved->image_type == s_ota.current.image_type && saved->file_version == s_ota.current.file_version &&
+                  saved->file_size == s_ota.current.file_size;
+    esp_err_t err;
+    if (resume)
+    {
+        /* the stack continues at the FileOffset announced, see light_ota_announce() */
+        err = esp_ota_resume(s_ota.partition, OTA_WITH_SEQUENTIAL_WRITES, saved->image_offset, &s_ota.handle);
+        s_ota.active = err == ESP_OK;
+        err = err == ESP_OK ? light_ota_rehash(saved->image_offset) : err;
+        s_ota.current = *saved;
+        s_ota.tag_remaining = saved->image_size - saved->image_offset;
+    }
+    else
+    {
+        light_ota_save(&(light_ota_progress_t) { 0 });
+        err = esp_ota_begin(s_ota.partition, OTA_WITH_SEQUENTIAL_WRITES, &s_ota.handle);
+        s_ota.active = err == ESP_OK;
+    }
+    if (err != ESP_OK)
+    {
+        return light_ota_fail(LIGHT_OTA_STEP_START, err);
+    }
+    s_stats.resumed_from = s_ota.current.file_offset;
+    s_stats.received = s_ota.current.file_offset;
+    LIGHT_LOGI(OTA_START, s_ota.current.file_version, s_ota.current.file_size, s_ota.current.file_offset);
+    return ESP_OK;
+}
+
+/* split the payload into sub-elements: the image goes to the slot and the
+ * hash, the rest is skipped */
+static esp_err_t light_ota_write(const uint8_t *data, uint32_t size)
+{
+    light_ota_progress_t *current = &s_ota.current;
+    ESP_RETURN_ON_FALSE(size <= current->file_size - current->file_offset, ESP_ERR_INVALID_SIZE, TAG, "Block beyond the end of the file");
+    while (size)
+    {
+        uint32_t n;
+        if (!s_ota.tag_remaining)
+        {
+            n = LIGHT_OTA_TAG_HEADER_SIZE - s_ota.tag_header_len;
+            n = n < size ? n : size;
+            memcpy(s_ota.tag_header + s_ota.tag_header_len, data, n);
+            s_ota.tag_header_len += n;
+            data += n;
+            size -= n;
+            current->file_offset += n;
+            if (s_ota.tag_header_len < LIGHT_OTA_TAG_HEADER_SIZE)
+            {
+                break;
+            }
+            const uint8_t *header = s_ota.tag_header;
+            s_ota.tag_header_len = 0;
+            s_ota.tag = header[0] | header[1] << 8;
+            s_ota.tag_remaining = header[2] | header[3] << 8 | header[4] << 16 | (uint32_t)header[5] << 24;
+            if (s_ota.tag == LIGHT_OTA_TAG_UPGRADE_IMAGE)
+            {
+                ESP_RETURN_ON_FALSE(!current->image_size && s_ota.tag_remaining && s_ota.tag_remaining <= s_ota.partition->size,
+                                    ESP_ERR_INVALID_SIZE, TAG, "Bad upgrade image of %lu bytes", (unsigned long)s_ota.tag_remaining);
+                current->image_size = s_ota.tag_remaining;
+            }
+            else if (s_ota.tag == LIGHT_OTA_TAG_SHA256)
+            {
+                ESP_RETURN_ON_FALSE(!s_ota.sha256_len && s_ota.tag_remaining == LIGHT_OTA_SHA256_SIZE, ESP_ERR_INVALID_SIZE, TAG,
+                                    "Bad SHA-256 sub-element");
+            }
+            continue;
+        }
+        n = s_ota.tag_remaining < size ? s_ota.tag_remaining : size;
+        switch (s_ota.tag)
+        {
+        case LIGHT_OTA_TAG_UPGRADE_IMAGE:
+            ESP_RETURN_ON_ERROR(esp_ota_write(s_ota.handle, data, n), TAG, "Failed to write the update slot");
+            mbedtls_sha256_update(&s_ota.sha, data, n);
+            current->image_offset += n;
+            break;
+        case LIGHT_OTA_TAG_SHA256:
+            memcpy(s_ota.sha256 + s_ota.sha256_len, data, n);
+            s_ota.sha256_len += n;
+            break;
+        default:
+            /* signatures, pictures and the like are not for this client */
+            break;
+        }
+        s_ota.tag_remaining -= n;
+        data += n;
+        size -= n;
+        current->file_offset += n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t light_ota_verify(void)
+{
+    const light_ota_progress_t *current = &s_ota.current;
+    uint8_t sha256[LIGHT_OTA_SHA256_SIZE];
+    mbedtls_sha256_finish(&s_ota.sha, sha256);
+    if (current->file_offset != current->file_size || !current->image_size || current->image_offset != current->image_size ||
+            s_ota.sha256_len != LIGHT_OTA_SHA256_SIZE || s_ota.tag_remaining || s_ota.tag_header_len)
+    {
+        ESP_LOGW(TAG, "Incomplete upgrade file, image %lu of %lu bytes", (unsigned long)current->image_offset,
+                 (unsigned long)current->image_size);
+        return light_ota_fail(LIGHT_OTA_STEP_VERIFY, ESP_ERR_INVALID_SIZE);
+    }
+    if (memcmp(sha256, s_ota.sha256, sizeof(sha256)))
+    {
+        ESP_LOGW(TAG, "Upgrade image SHA-256 mismatch");
+        return light_ota_fail(LIGHT_OTA_STEP_VERIFY, ESP_ERR_INVALID_CRC);
+    }
+    s_ota.active = false;
+    esp_err_t err = esp_ota_end(s_ota.handle);
+    if (err != ESP_OK)
+    {
+        return light_ota_fail(LIGHT_OTA_STEP_VERIFY, err);
+    }
+    s_ota.verified = true;
+    light_ota_update_rate();
+    LIGHT_LOGI(OTA_VERIFIED, current->file_version, current->file_size - s_stats.resumed_from, s_stats.elapsed_ms, s_stats.bytes_per_s);
+    return ESP_OK;
+}
+
+static esp_err_t light_ota_switch(void)
+{
+    ESP_RETURN_ON_FALSE(s_ota.verified, ESP_ERR_INVALID_STATE, TAG, "Nothing verified to switch to");
+    esp_err_t err = esp_ota_set_boot_partition(s_ota.partition);
+    if (err != ESP_OK)
+    {
+        return light_ota_fail(LIGHT_OTA_STEP_SWITCH, err);
+    }
+    s_ota.verified = false;
+    light_ota_save(&(light_ota_progress_t) { 0 });
+    light_ota_announce();
+    ESP_LOGI(TAG, "Upgrade to 0x%08lx in %s: %lu bytes in %lu ms (%lu B/s), %lu bytes of RAM; restarting",
+             (unsigned long)s_ota.current.file_version, s_ota.partition->label, (unsigned long)(s_stats.received - s_stats.resumed_from),
+             (unsigned long)s_stats.elapsed_ms, (unsigned long)s_stats.bytes_per_s, (unsigned long)s_stats.ram_bytes);
+    esp_restart();
+    return ESP_OK;
+}
+
+esp_err_t light_ota_handle(const esp_zb_zcl_ota_upgrade_value_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    esp_err_t err = ESP_OK;
+    switch (message->upgrade_status)
+    {
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START:
+        err = light_ota_start(message);
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE:
+        ESP_RETURN_ON_FALSE(s_ota.active, ESP_ERR_INVALID_STATE, TAG, "Block without a download");
+        err = light_ota_write(message->payload, message->payload_size);
+        if (err != ESP_OK)
+        {
+            return light_ota_fail(LIGHT_OTA_STEP_WRITE, err);
+        }
+        s_stats.blocks++;
+        light_ota_update_rate();
+        light_ota_checkpoint();
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+        ESP_RETURN_ON_FALSE(s_ota.active, ESP_ERR_INVALID_STATE, TAG, "Nothing downloaded to check");
+        err = light_ota_verify();
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+        ESP_LOGI(TAG, "Applying 0x%08lx", (unsigned long)s_ota.current.file_version);
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
+        err = light_ota_switch();
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT:
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR:
+        /* server gone or the network down: keep the slot, continue from the last checkpoint */
+        if (s_ota.active || s_ota.verified)
+        {
+            light_ota_close();
+            light_ota_update_rate();
+            light_ota_announce();
+            LIGHT_LOGW(OTA_ABORT, s_ota.current.file_offset, s_ota.current.file_size, s_ota.saved.version ? s_ota.saved.file_offset : 0);
+        }
+        break;
+    default:
+        break;
+    }
+    return err;
+}
+
+esp_err_t light_ota_add_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+    s_stats.ram_bytes = sizeof(s_ota) + sizeof(s_stats);
+    esp_err_t err = nvs_open(LIGHT_OTA_NAMESPACE, NVS_READWRITE, &s_handle);
+    if (err == ESP_OK)
+    {
+        s_open = true;
+        light_ota_progress_t saved;
+        size_t size = sizeof(saved);
+        err = nvs_get_blob(s_handle, LIGHT_OTA_KEY, &saved, &size);
+        if (err == ESP_OK && size == sizeof(saved) && saved.version == LIGHT_OTA_VERSION && saved.image_offset <= saved.image_size &&
+                saved.file_offset <= saved.file_size)
+        {
+            s_ota.saved = saved;
+            ESP_LOGI(TAG, "Download of 0x%08lx continues at %lu of %lu bytes", (unsigned long)saved.file_version,
+                     (unsigned long)saved.file_offset, (unsigned long)saved.file_size);
+        }
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Failed to open NVS namespace, downloads cannot resume (%s)", esp_err_to_name(err));
+    }
+
+    esp_zb_ota_cluster_cfg_t ota_cfg = {
+        .ota_upgrade_file_version = CONFIG_LIGHT_OTA_FILE_VERSION,
+        .ota_upgrade_manufacturer = CONFIG_LIGHT_OTA_MANUFACTURER_CODE,
+        .ota_upgrade_image_type = CONFIG_LIGHT_OTA_IMAGE_TYPE,
+        .ota_min_block_reque = CONFIG_LIGHT_OTA_BLOCK_PERIOD_MS,
+        .ota_upgrade_file_offset = s_ota.saved.version ? LIGHT_OTA_FILE_HEADER_SIZE + s_ota.saved.file_offset : 0,
+        .ota_upgrade_downloaded_file_ver =
+            s_ota.saved.version ? s_ota.saved.file_version : ESP_ZB_ZCL_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_DEF_VALUE,
+    };
+    esp_zb_attribute_list_t *attr_list = esp_zb_ota_cluster_create(&ota_cfg);
+    ESP_RETURN_ON_FALSE(attr_list, ESP_ERR_NO_MEM, TAG, "Failed to create OTA cluster");
+    esp_zb_zcl_ota_upgrade_client_variable_t client = {
+        .timer_query = CONFIG_LIGHT_OTA_QUERY_INTERVAL_MIN,
+        .hw_version = LIGHT_OTA_HW_VERSION,
+        .max_data_size = CONFIG_LIGHT_OTA_BLOCK_SIZE,
+    };
+    /* whichever server answers the broadcast query */
+    uint16_t server_addr = 0xffff;
+    uint8_t server_endpoint = 0xff;
+    ESP_RETURN_ON_ERROR(esp_zb_ota_cluster_add_attr(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID, &client), TAG,
+                        "Failed to add OTA client data");
+    ESP_RETURN_ON_ERROR(esp_zb_ota_cluster_add_attr(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID, &server_addr), TAG,
+                        "Failed to add OTA server address");
+    ESP_RETURN_ON_ERROR(esp_zb_ota_cluster_add_attr(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID, &server_endpoint), TAG,
+                        "Failed to add OTA server endpoint");
+    return esp_zb_cluster_list_add_ota_cluster(cluster_list, attr_list, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE);
+}
+
+#else
+
+esp_err_t light_ota_handle(const esp_zb_zcl_ota_upgrade_value_message_t *message)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t light_ota_add_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+    return ESP_OK;
+}
+
+#endif
+
+void light_ota_get_stats(light_ota_stats_t *stats)
+{
+    *stats = s_stats;
+}
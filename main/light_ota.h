@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+/* OTA upgrade: an OTA Upgrade cluster client on the light endpoint. The
+ * stack asks the server for a new image every
+ * CONFIG_LIGHT_OTA_QUERY_INTERVAL_MIN minutes and downloads it in blocks of
+ * at most CONFIG_LIGHT_OTA_BLOCK_SIZE bytes, one request per
+ * CONFIG_LIGHT_OTA_BLOCK_PERIOD_MS (MinimumBlockPeriod) at most, so an
+ * upgrade of a whole room does not flood the mesh. Every block is written
+ * to the inactive OTA slot as it arrives; nothing is buffered.
+ *
+ * After the upgrade file header, the file carries these sub-elements, each
+ * a tag u16 | length u32 header (little endian) and its data:
+ *
+ *     0x0000  upgrade image: the app binary as idf.py builds it
+ *     0xf000  SHA-256 of the upgrade image, 32 bytes
+ *
+ * main/tools/make_ota_image.py writes them. The slot is switched to only if
+ * the hash matches and esp_ota_end() validates the app.
+ *
+ * Progress is saved in NVS every CONFIG_LIGHT_OTA_CHECKPOINT_KB of image.
+ * After a broken download, or a reboot in the middle of one, the client
+ * announces the last checkpoint in FileOffset and DownloadedFileVersion, so
+ * the next download of the same file continues there. */
+
+#define LIGHT_OTA_TAG_UPGRADE_IMAGE       0x0000
+#define LIGHT_OTA_TAG_SHA256              0xf000    /* manufacturer specific tag range */
+#define LIGHT_OTA_TAG_HEADER_SIZE         6
+#define LIGHT_OTA_SHA256_SIZE             32
+#define LIGHT_OTA_FILE_HEADER_SIZE        56        /* upgrade file header without optional fields, FileOffset counts it */
+#define LIGHT_OTA_HW_VERSION              1
+
+/** Where a download failed, the step argument of the OTA_FAIL trace event */
+typedef enum {
+    LIGHT_OTA_STEP_START = 1,           /*!< no update slot, or the image does not fit */
+    LIGHT_OTA_STEP_WRITE = 2,           /*!< malformed sub-element, or the flash write failed */
+    LIGHT_OTA_STEP_VERIFY = 3,          /*!< incomplete, hash mismatch or the app does not validate */
+    LIGHT_OTA_STEP_SWITCH = 4,          /*!< the boot slot could not be changed */
+} light_ota_step_t;
+
+/** Download counters, see light_ota_get_stats() */
+typedef struct {
+    uint32_t file_version;      /*!< File being or last downloaded, 0 if none */
+    uint32_t image_size;        /*!< Its size after the upgrade file header */
+    uint32_t received;          /*!< Of that, bytes received and written so far */
+    uint32_t resumed_from;      /*!< Where this download started, 0 from the start */
+    uint32_t blocks;            /*!< Blocks received */
+    uint32_t elapsed_ms;        /*!< Since this download started, until it ended */
+    uint32_t bytes_per_s;       /*!< received - resumed_from over elapsed_ms */
+    uint32_t checkpoints;       /*!< Progress saved to NVS */
+    uint32_t failures;          /*!< Downloads given up, for any light_ota_step_t */
+    uint32_t ram_bytes;         /*!< RAM the client holds, all of it static */
+} light_ota_stats_t;
+
+/**
+* @brief Add the OTA Upgrade client to the light endpoint, before esp_zb_device_register()
+*
+* Loads the saved progress, so NVS must be initialized. Adds nothing without
+* CONFIG_LIGHT_OTA.
+*/
+esp_err_t light_ota_add_cluster(esp_zb_cluster_list_t *cluster_list);
+
+/**
+* @brief Handle an OTA upgrade progress callback, from the Zigbee task
+*
+* @return ESP_OK, or the error that makes the stack abort the download
+*/
+esp_err_t light_ota_handle(const esp_zb_zcl_ota_upgrade_value_message_t *message);
+
+void light_ota_get_stats(light_ota_stats_t *stats);
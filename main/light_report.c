@@ -0,0 +1,281 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "light_report.h"
+#include "esp_zb_light.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define LIGHT_REPORT_SEGMENTS   CONFIG_LIGHT_DRIVER_SEGMENTS
+
+static const char *TAG = "LIGHT_REPORT";
+
+/* the clusters reported, one frame each */
+enum {
+    LIGHT_REPORT_ON_OFF,
+    LIGHT_REPORT_LEVEL,
+    LIGHT_REPORT_COLOR,
+    LIGHT_REPORT_CLUSTERS,
+};
+
+typedef struct {
+    uint16_t cluster_id;
+    uint16_t min_interval_s;
+} light_report_cluster_t;
+
+typedef struct {
+    uint8_t cluster;            /* index in s_clusters */
+    uint16_t attr_id;
+    uint16_t change;            /* reportable change, 1 for any */
+    bool wide;                  /* 16-bit attribute */
+} light_report_attr_t;
+
+static const light_report_cluster_t s_clusters[LIGHT_REPORT_CLUSTERS] = {
+    [LIGHT_REPORT_ON_OFF] = { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, 0 },
+    [LIGHT_REPORT_LEVEL] = { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, CONFIG_LIGHT_REPORT_MIN_INTERVAL_S },
+    [LIGHT_REPORT_COLOR] = { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, CONFIG_LIGHT_REPORT_MIN_INTERVAL_S },
+};
+
+static const light_report_attr_t s_attrs[] = {
+    { LIGHT_REPORT_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, 1, false },
+    { LIGHT_REPORT_LEVEL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, CONFIG_LIGHT_REPORT_LEVEL_CHANGE, false },
+    { LIGHT_REPORT_COLOR, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, CONFIG_LIGHT_REPORT_XY_CHANGE, true },
+    { LIGHT_REPORT_COLOR, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, CONFIG_LIGHT_REPORT_XY_CHANGE, true },
+    { LIGHT_REPORT_COLOR, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID, CONFIG_LIGHT_REPORT_CT_CHANGE, true },
+};
+
+#define LIGHT_REPORT_ATTRS      (sizeof(s_attrs) / sizeof(s_attrs[0]))
+
+/* what the stack holds per endpoint, modelled: the last reported values and the changes waiting for the minimum interval */
+typedef struct {
+    uint16_t current[LIGHT_REPORT_ATTRS];
+    uint16_t reported[LIGHT_REPORT_ATTRS];
+    uint8_t seen;                           /* attributes with a current value, bit per s_attrs entry */
+    uint8_t pending;                        /* attributes due for a report, bit per s_attrs entry */
+    uint8_t reported_once;                  /* clusters reported since boot, bit per cluster */
+    uint32_t last_ms[LIGHT_REPORT_CLUSTERS];    /* last frame */
+    uint32_t pending_ms[LIGHT_REPORT_CLUSTERS]; /* first change waiting, valid with pending */
+} light_report_segment_t;
+
+static light_report_segment_t s_segments[LIGHT_REPORT_SEGMENTS];
+static light_report_stats_t s_stats;
+
+static uint32_t light_report_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static uint16_t light_report_value(const light_store_state_t *state, size_t attr)
+{
+    switch (s_attrs[attr].cluster)
+    {
+    case LIGHT_REPORT_ON_OFF:
+        return state->power;
+    case LIGHT_REPORT_LEVEL:
+        return state->level;
+    default:
+        break;
+    }
+    switch (s_attrs[attr].attr_id)
+    {
+    case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID:
+        return state->color_x;
+    case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID:
+        return state->color_y;
+    default:
+        return state->mireds;
+    }
+}
+
+static bool light_report_reportable(const light_report_segment_t *segment, size_t attr)
+{
+    if (!(segment->reported_once & (1U << s_attrs[attr].cluster)))
+    {
+        return true;
+    }
+    int32_t delta = (int32_t)segment->current[attr] - segment->reported[attr];
+    return (uint32_t)(delta < 0 ? -delta : delta) >= s_attrs[attr].change;
+}
+
+/* frames of the given attributes of a cluster, or all of them; the last one at at_ms */
+static void light_report_send(light_report_segment_t *segment, uint8_t cluster, uint8_t mask, uint32_t at_ms, uint32_t frames)
+{
+    uint8_t count = 0;
+    for (size_t i = 0; i < LIGHT_REPORT_ATTRS; i++)
+    {
+        if (s_attrs[i].cluster == cluster && (mask & (1U << i)))
+        {
+            segment->reported[i] = segment->current[i];
+            count++;
+        }
+    }
+    segment->reported_once |= 1U << cluster;
+    segment->last_ms[cluster] = at_ms;
+    s_stats.reports_est += frames;
+    s_stats.attributes_est += frames * count;
+}
+
+static uint8_t light_report_cluster_mask(uint8_t cluster)
+{
+    uint8_t mask = 0;
+    for (size_t i = 0; i < LIGHT_REPORT_ATTRS; i++)
+    {
+        mask |= s_attrs[i].cluster == cluster ? 1U << i : 0;
+    }
+    return mask;
+}
+
+/* Play one cluster of a segment forward to now_ms as the stack's reporting
+ * would: pending changes go out once the minimum interval since the last
+ * frame is up, then everything once per maximum interval without a frame.
+ * Only what fell due before now_ms, a change at now_ms may still join. */
+static void light_report_settle_cluster(light_report_segment_t *segment, uint8_t cluster, uint32_t now_ms)
+{
+    uint8_t cluster_mask = light_report_cluster_mask(cluster);
+    uint8_t cluster_pending = segment->pending & cluster_mask;
+    if (cluster_pending)
+    {
+        uint32_t due_ms = segment->last_ms[cluster] + s_clusters[cluster].min_interval_s * 1000U;
+        if (!(segment->reported_once & (1U << cluster)) || (int32_t)(due_ms - segment->pending_ms[cluster]) < 0)
+        {
+            due_ms = segment->pending_ms[cluster];
+        }
+        if ((int32_t)(now_ms - due_ms) <= 0)
+        {
+            return;
+        }
+        segment->pending &= ~cluster_mask;
+        uint8_t send = 0;
+        for (size_t i = 0; i < LIGHT_REPORT_ATTRS; i++)
+        {
+            send |= (cluster_pending & (1U << i)) && light_report_reportable(segment, i) ? 1U << i : 0;
+        }
+        if (send)
+        {
+            light_report_send(segment, cluster, send, due_ms, 1);
+        }
+        else
+        {
+            /* changed back before the minimum interval was up */
+            s_stats.suppressed_est++;
+        }
+    }
+    if (!(segment->reported_once & (1U << cluster)))
+    {
+        return;
+    }
+    /* maximum interval: everything, changed or not */
+    const uint32_t max_ms = CONFIG_LIGHT_REPORT_MAX_INTERVAL_S * 1000U;
+    uint32_t since_ms = now_ms - segment->last_ms[cluster];
+    uint32_t frames = (int32_t)since_ms > 0 ? (since_ms - 1) / max_ms : 0;
+    if (frames)
+    {
+        light_report_send(segment, cluster, cluster_mask, segment->last_ms[cluster] + frames * max_ms, frames);
+    }
+}
+
+static void light_report_settle(uint32_t now_ms)
+{
+    for (uint8_t s = 0; s < LIGHT_REPORT_SEGMENTS; s++)
+    {
+        for (uint8_t c = 0; c < LIGHT_REPORT_CLUSTERS; c++)
+        {
+            light_report_settle_cluster(&s_segments[s], c, now_ms);
+        }
+    }
+}
+
+esp_err_t light_report_init(void)
+{
+    for (uint8_t s = 0; s < LIGHT_REPORT_SEGMENTS; s++)
+    {
+        for (size_t i = 0; i < LIGHT_REPORT_ATTRS; i++)
+        {
+            const light_report_attr_t *attr = &s_attrs[i];
+            esp_zb_zcl_reporting_info_t info = {
+                .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV,
+                .ep = LIGHT_SEGMENT_ENDPOINT(s),
+                .cluster_id = s_clusters[attr->cluster].cluster_id,
+                .cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                .attr_id = attr->attr_id,
+                .dst.profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+                .u.send_info.min_interval = s_clusters[attr->cluster].min_interval_s,
+                .u.send_info.max_interval = CONFIG_LIGHT_REPORT_MAX_INTERVAL_S,
+                .u.send_info.def_min_interval = s_clusters[attr->cluster].min_interval_s,
+                .u.send_info.def_max_interval = CONFIG_LIGHT_REPORT_MAX_INTERVAL_S,
+                .manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+            };
+            /* OnOff is discrete, any change is reported */
+            if (attr->wide)
+            {
+                info.u.send_info.delta.u16 = attr->change;
+            }
+            else if (attr->cluster != LIGHT_REPORT_ON_OFF)
+            {
+                info.u.send_info.delta.u8 = attr->change;
+            }
+            ESP_RETURN_ON_ERROR(esp_zb_zcl_update_reporting_info(&info), TAG, "Failed to configure reporting of 0x%04x/0x%04x on endpoint %u",
+                                info.cluster_id, info.attr_id, info.ep);
+        }
+    }
+    ESP_LOGI(TAG, "Reporting level and color changes at most every %u s, everything at least every %u s",
+             CONFIG_LIGHT_REPORT_MIN_INTERVAL_S, CONFIG_LIGHT_REPORT_MAX_INTERVAL_S);
+    return ESP_OK;
+}
+
+void light_report_update(uint8_t segment_index, const light_store_state_t *state)
+{
+    if (segment_index >= LIGHT_REPORT_SEGMENTS)
+    {
+        return;
+    }
+    uint32_t now_ms = light_report_now_ms();
+    light_report_settle(now_ms);
+    light_report_segment_t *segment = &s_segments[segment_index];
+    for (size_t i = 0; i < LIGHT_REPORT_ATTRS; i++)
+    {
+        uint16_t value = light_report_value(state, i);
+        uint8_t cluster = s_attrs[i].cluster;
+        if ((segment->seen & (1U << i)) && value == segment->current[i])
+        {
+            continue;
+        }
+        segment->current[i] = value;
+        segment->seen |= 1U << i;
+        s_stats.changes++;
+        if (!light_report_reportable(segment, i))
+        {
+            /* below the reportable change; the next report carries it */
+            s_stats.suppressed_est++;
+            continue;
+        }
+        if (segment->pending & light_report_cluster_mask(cluster))
+        {
+            /* joins the frame already waiting for the minimum interval */
+            s_stats.suppressed_est++;
+        }
+        else
+        {
+            segment->pending_ms[cluster] = now_ms;
+        }
+        segment->pending |= 1U << i;
+    }
+}
+
+void light_report_get_stats(light_report_stats_t *stats)
+{
+    light_report_settle(light_report_now_ms());
+    *stats = s_stats;
+}
@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "light_store.h"
+
+/* Attribute reporting of every light endpoint. light_report_init() gives
+ * the stack a default reporting configuration for these attributes, so a
+ * bound bridge hears about changes without polling:
+ *
+ *     OnOff             every change, at once
+ *     CurrentLevel      a change of CONFIG_LIGHT_REPORT_LEVEL_CHANGE
+ *     CurrentX/Y        a change of CONFIG_LIGHT_REPORT_XY_CHANGE
+ *     ColorTemperature  a change of CONFIG_LIGHT_REPORT_CT_CHANGE mireds
+ *
+ * Level and color are reported CONFIG_LIGHT_REPORT_MIN_INTERVAL_S apart at
+ * the least, everything at least every CONFIG_LIGHT_REPORT_MAX_INTERVAL_S.
+ * The attributes of a cluster share their intervals, so whatever changed
+ * falls due together and goes out as one Report Attributes frame. A bridge
+ * may still configure its own reporting on top.
+ *
+ * The stack sends the reports and does not say when it did. The _est
+ * counters of light_report_get_stats() are an estimate: the default rules
+ * applied to the changes light_report_update() sees, settled whenever the
+ * state changes or the counters are read. They do not see a configuration
+ * a bridge writes, nor frames the stack fails to send. */
+
+/** Reporting counters; all but changes are modelled, as the default configuration has it */
+typedef struct {
+    uint32_t changes;           /*!< Changes of a reported attribute */
+    uint32_t reports_est;       /*!< Report Attributes frames, one cluster of one endpoint each */
+    uint32_t attributes_est;    /*!< Attribute records in those frames */
+    uint32_t suppressed_est;    /*!< Changes that did not cause a frame of their own */
+} light_report_stats_t;
+
+/**
+* @brief Configure reporting on every light endpoint, after esp_zb_device_register()
+*/
+esp_err_t light_report_init(void);
+
+/**
+* @brief Hand over the current state of a segment after its attributes changed. Zigbee task only.
+*/
+void light_report_update(uint8_t segment, const light_store_state_t *state);
+
+/**
+* @brief Read the counters, with the estimate settled up to now. Zigbee task only.
+*/
+void light_report_get_stats(light_report_stats_t *stats);
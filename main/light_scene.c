@@ -0,0 +1,359 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <string.h>
+#include "light_scene.h"
+#include "sdkconfig.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ha/esp_zigbee_ha_standard.h"
+#include "nvs.h"
+
+#define LIGHT_SCENE_NAMESPACE   "light_scene"
+#define LIGHT_SCENE_KEY         "table2"    /* a new entry layout gets a new key */
+#define LIGHT_SCENE_SEGMENTS    CONFIG_LIGHT_DRIVER_SEGMENTS
+
+/* Color Control scene extension: CurrentX, CurrentY, EnhancedCurrentHue, CurrentSaturation,
+ * ColorLoopActive, ColorLoopDirection, ColorLoopTime, ColorTemperatureMireds */
+#define LIGHT_SCENE_COLOR_X_OFFSET      0
+#define LIGHT_SCENE_COLOR_Y_OFFSET      2
+#define LIGHT_SCENE_COLOR_HUE_OFFSET    4
+#define LIGHT_SCENE_COLOR_SAT_OFFSET    6
+#define LIGHT_SCENE_COLOR_CT_OFFSET     11
+#define LIGHT_SCENE_COLOR_LENGTH        13      /* all of them, as Store Scene writes the field */
+
+_Static_assert(sizeof(light_scene_t) == 16, "light_scene_t must not have padding");
+
+static const char *TAG = "LIGHT_SCENE";
+
+static nvs_handle_t s_handle;
+static bool s_open = false;
+/* the entries in use, stored longest ago first; nothing is ever removed, only replaced */
+static light_scene_t s_table[CONFIG_LIGHT_SCENE_MAX];
+static uint16_t s_used;
+static bool s_recall_pending = false;
+static int64_t s_recall_start_us;
+static light_scene_stats_t s_stats;
+
+static void light_scene_save(uint8_t param)
+{
+    if (!s_open)
+    {
+        return;
+    }
+    esp_err_t err = nvs_set_blob(s_handle, LIGHT_SCENE_KEY, s_table, s_used * sizeof(s_table[0]));
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(s_handle);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to save scenes (%s)", esp_err_to_name(err));
+        return;
+    }
+    s_stats.saves++;
+}
+
+/* a dimmer scene storm is one write, once it has settled */
+static void light_scene_changed(void)
+{
+    esp_zb_scheduler_alarm_cancel(light_scene_save, 0);
+    esp_zb_scheduler_alarm(light_scene_save, 0, CONFIG_LIGHT_SCENE_SAVE_DELAY_MS);
+}
+
+static light_scene_t *light_scene_find(uint8_t segment, uint16_t group_id, uint8_t scene_id)
+{
+    for (uint16_t i = 0; i < s_used; i++)
+    {
+        if (s_table[i].segment == segment && s_table[i].group_id == group_id && s_table[i].scene_id == scene_id)
+        {
+            return &s_table[i];
+        }
+    }
+    return NULL;
+}
+
+/* the entry of a scene, moved to the end: the table is in store order and the
+ * first entry makes room when it is full */
+static light_scene_t *light_scene_entry(uint8_t segment, uint16_t group_id, uint8_t scene_id)
+{
+    light_scene_t entry = {
+        .group_id = group_id,
+        .scene_id = scene_id,
+        .segment = segment,
+    };
+    light_scene_t *scene = light_scene_find(segment, group_id, scene_id);
+    uint16_t from = 0;
+    if (scene)
+    {
+        entry = *scene;
+        from = scene - s_table;
+    }
+    else if (s_used < CONFIG_LIGHT_SCENE_MAX)
+    {
+        from = s_used++;
+    }
+    memmove(&s_table[from], &s_table[from + 1], (s_used - 1 - from) * sizeof(s_table[0]));
+    s_table[s_used - 1] = entry;
+    return &s_table[s_used - 1];
+}
+
+static uint16_t light_scene_u16(const uint8_t *value)
+{
+    return value[0] | (value[1] << 8);
+}
+
+/* the color of one mode from a Color Control field, false if the field is too short to carry it */
+static bool light_scene_field_color(const uint8_t *value, uint8_t length, uint8_t mode, uint16_t color[2])
+{
+    switch (mode)
+    {
+    case ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_TEMPERATURE:
+        if (length < LIGHT_SCENE_COLOR_CT_OFFSET + 2)
+        {
+            return false;
+        }
+        color[0] = light_scene_u16(value + LIGHT_SCENE_COLOR_CT_OFFSET);
+        color[1] = 0;
+        return true;
+    case ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION:
+        if (length <= LIGHT_SCENE_COLOR_SAT_OFFSET)
+        {
+            return false;
+        }
+        /* EnhancedCurrentHue is 16-bit, CurrentHue is its top byte */
+        color[0] = light_scene_u16(value + LIGHT_SCENE_COLOR_HUE_OFFSET) >> 8;
+        color[1] = value[LIGHT_SCENE_COLOR_SAT_OFFSET];
+        return true;
+    default:
+        if (length < LIGHT_SCENE_COLOR_Y_OFFSET + 2)
+        {
+            return false;
+        }
+        color[0] = light_scene_u16(value + LIGHT_SCENE_COLOR_X_OFFSET);
+        color[1] = light_scene_u16(value + LIGHT_SCENE_COLOR_Y_OFFSET);
+        return true;
+    }
+}
+
+esp_err_t light_scene_store(uint8_t segment, uint16_t group_id, uint8_t scene_id, const light_store_state_t *state)
+{
+    ESP_RETURN_ON_FALSE(segment < LIGHT_SCENE_SEGMENTS, ESP_ERR_INVALID_ARG, TAG, "No segment %d", segment);
+    light_scene_t *scene = light_scene_entry(segment, group_id, scene_id);
+    scene->power = state->power;
+    scene->level = state->level;
+    scene->color_mode = state->color_mode;
+    switch (state->color_mode)
+    {
+    case ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_TEMPERATURE:
+        scene->color[0] = state->mireds;
+        scene->color[1] = 0;
+        break;
+    case ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION:
+        scene->color[0] = state->hue;
+        scene->color[1] = state->sat;
+        break;
+    default:
+        scene->color[0] = state->color_x;
+        scene->color[1] = state->color_y;
+        break;
+    }
+    scene->fields = LIGHT_SCENE_FIELD_ON_OFF | LIGHT_SCENE_FIELD_LEVEL | LIGHT_SCENE_FIELD_COLOR;
+    s_stats.stores++;
+    light_scene_changed();
+    return ESP_OK;
+}
+
+esp_err_t light_scene_describe(uint8_t segment, uint16_t group_id, uint8_t scene_id, const esp_zb_zcl_scenes_extension_field_t *fields)
+{
+    ESP_RETURN_ON_FALSE(segment < LIGHT_SCENE_SEGMENTS, ESP_ERR_INVALID_ARG, TAG, "No segment %d", segment);
+    light_scene_t described = { 0 };
+    const light_scene_t *known = light_scene_find(segment, group_id, scene_id);
+    for (const esp_zb_zcl_scenes_extension_field_t *field = fields; field; field = field->next)
+    {
+        const uint8_t *value = field->extension_field_attribute_value_list;
+        if (!value)
+        {
+            continue;
+        }
+        switch (field->cluster_id)
+        {
+        case ESP_ZB_ZCL_CLUSTER_ID_ON_OFF:
+            if (field->length >= 1)
+            {
+                described.power = value[0] ? 1 : 0;
+                described.fields |= LIGHT_SCENE_FIELD_ON_OFF;
+            }
+            break;
+        case ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL:
+            if (field->length >= 1)
+            {
+                described.level = value[0];
+                described.fields |= LIGHT_SCENE_FIELD_LEVEL;
+            }
+            break;
+        case ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL:
+        {
+            /* The fields carry no ColorMode. A known scene keeps its mode only
+             * if the field is the full one Store Scene writes and still holds
+             * the scene's color; else the mode is what the field sets: xy,
+             * else a color temperature, else hue and saturation. */
+            uint16_t color[2];
+            uint8_t mode;
+            if (known && (known->fields & LIGHT_SCENE_FIELD_COLOR) && field->length >= LIGHT_SCENE_COLOR_LENGTH &&
+                    light_scene_field_color(value, field->length, known->color_mode, color) &&
+                    !memcmp(color, known->color, sizeof(color)))
+            {
+                mode = known->color_mode;
+            }
+            else if (light_scene_field_color(value, field->length, ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_CURRENT_X_Y, color) &&
+                     (color[0] || color[1]))
+            {
+                mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_CURRENT_X_Y;
+            }
+            else if (light_scene_field_color(value, field->length, ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_TEMPERATURE, color) && color[0])
+            {
+                mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_TEMPERATURE;
+            }
+            else if (light_scene_field_color(value, field->length, ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION, color))
+            {
+                mode = ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION;
+            }
+            else
+            {
+                break;
+            }
+            memcpy(described.color, color, sizeof(described.color));
+            described.color_mode = mode;
+            described.fields |= LIGHT_SCENE_FIELD_COLOR;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    if (known && !memcmp(known->color, described.color, sizeof(known->color)) && known->color_mode == described.color_mode &&
+            known->power == described.power && known->level == described.level && known->fields == described.fields)
+    {
+        return ESP_OK;
+    }
+    light_scene_t *scene = light_scene_entry(segment, group_id, scene_id);
+    described.group_id = group_id;
+    described.scene_id = scene_id;
+    described.segment = segment;
+    *scene = described;
+    light_scene_changed();
+    return ESP_OK;
+}
+
+esp_err_t light_scene_recall(uint8_t segment, uint16_t group_id, uint8_t scene_id, uint16_t transition_time, light_store_state_t *state,
+                             uint32_t *transition_ms)
+{
+    const light_scene_t *scene = light_scene_find(segment, group_id, scene_id);
+    if (!scene)
+    {
+        s_stats.misses++;
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!s_recall_pending)
+    {
+        /* a group recall reaches every segment endpoint in turn, timed from the first one */
+        s_recall_pending = true;
+        s_recall_start_us = esp_timer_get_time();
+    }
+    if (scene->fields & LIGHT_SCENE_FIELD_ON_OFF)
+    {
+        state->power = scene->power;
+    }
+    if (scene->fields & LIGHT_SCENE_FIELD_LEVEL)
+    {
+        state->level = scene->level;
+    }
+    if (scene->fields & LIGHT_SCENE_FIELD_COLOR)
+    {
+        state->color_mode = scene->color_mode;
+        switch (scene->color_mode)
+        {
+        case ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_TEMPERATURE:
+            state->mireds = scene->color[0];
+            break;
+        case ESP_ZB_ZCL_COLOR_CONTROL_COLOR_MODE_HUE_SATURATION:
+            state->hue = scene->color[0];
+            state->sat = scene->color[1];
+            break;
+        default:
+            state->color_x = scene->color[0];
+            state->color_y = scene->color[1];
+            break;
+        }
+    }
+    *transition_ms = transition_time * 100U;
+    s_stats.transition_ms_last = *transition_ms;
+    s_stats.recalls++;
+    return ESP_OK;
+}
+
+void light_scene_committed(void)
+{
+    if (!s_recall_pending)
+    {
+        return;
+    }
+    s_recall_pending = false;
+    s_stats.recall_us_last = (uint32_t)(esp_timer_get_time() - s_recall_start_us);
+    if (s_stats.recall_us_last > s_stats.recall_us_max)
+    {
+        s_stats.recall_us_max = s_stats.recall_us_last;
+    }
+}
+
+void light_scene_get_stats(light_scene_stats_t *stats)
+{
+    *stats = s_stats;
+    stats->used = s_used;
+    stats->capacity = CONFIG_LIGHT_SCENE_MAX;
+    stats->bytes_per_scene = sizeof(light_scene_t);
+}
+
+esp_err_t light_scene_init(void)
+{
+    if (s_open)
+    {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(nvs_open(LIGHT_SCENE_NAMESPACE, NVS_READWRITE, &s_handle), TAG, "Failed to open NVS namespace");
+    s_open = true;
+    size_t size = sizeof(s_table);
+    esp_err_t err = nvs_get_blob(s_handle, LIGHT_SCENE_KEY, s_table, &size);
+    if (err == ESP_ERR_NVS_NOT_FOUND)
+    {
+        return ESP_OK;
+    }
+    if (err != ESP_OK || size % sizeof(s_table[0]))
+    {
+        /* e.g. saved with a larger CONFIG_LIGHT_SCENE_MAX; the bridge stores them again */
+        ESP_LOGW(TAG, "Ignoring saved scenes (%s, %d bytes)", esp_err_to_name(err), (int)size);
+        return ESP_OK;
+    }
+    for (size_t i = 0; i < size / sizeof(s_table[0]); i++)
+    {
+        if (s_table[i].segment < LIGHT_SCENE_SEGMENTS)
+        {
+            s_table[s_used++] = s_table[i];
+        }
+    }
+    ESP_LOGI(TAG, "Loaded %u scenes", s_used);
+    return ESP_OK;
+}
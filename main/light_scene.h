@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+#include "light_store.h"
+
+/* Scenes of every light endpoint, in one RAM table of CONFIG_LIGHT_SCENE_MAX
+ * entries shared by all segments. The Scenes cluster of the stack keeps
+ * track of which scenes exist and their transition times, and answers the
+ * commands. Store Scene copies
+ * the segment state into the table. Recall Scene applies an entry to the
+ * segment in one render commit, not one attribute write per value. A scene
+ * a bridge added with Add Scene comes with its extension fields on recall,
+ * which the table takes over; it changes only if they do. When the table
+ * is full, the scene stored longest ago makes room.
+ *
+ * The table is saved to NVS (namespace "light_scene") as one blob, once it
+ * has not changed for CONFIG_LIGHT_SCENE_SAVE_DELAY_MS, from the Zigbee
+ * task. A recall never writes flash. */
+
+/** What a scene sets */
+enum {
+    LIGHT_SCENE_FIELD_ON_OFF = 0x01,
+    LIGHT_SCENE_FIELD_LEVEL = 0x02,
+    LIGHT_SCENE_FIELD_COLOR = 0x04,
+};
+
+/** One scene of one segment; no padding, the table is stored as a blob */
+typedef struct {
+    uint16_t group_id;
+    uint8_t scene_id;
+    uint8_t segment;
+    uint16_t color[2];          /*!< CurrentX and CurrentY, ColorTemperature, or CurrentHue and CurrentSaturation, by color_mode */
+    uint8_t color_mode;         /*!< ZCL ColorMode */
+    uint8_t power;
+    uint8_t level;
+    uint8_t fields;             /*!< LIGHT_SCENE_FIELD_* the scene sets */
+    uint8_t reserved[4];        /*!< keep zero */
+} light_scene_t;
+
+/** Scene table counters */
+typedef struct {
+    uint32_t stores;            /*!< Store Scene commands */
+    uint32_t recalls;           /*!< Scenes applied */
+    uint32_t misses;            /*!< Recalls of a scene neither stored nor described */
+    uint32_t saves;             /*!< Table blobs written to flash */
+    uint32_t recall_us_last;    /*!< From the last Recall Scene to its frame being queued */
+    uint32_t recall_us_max;
+    uint32_t transition_ms_last;    /*!< Fade of the last recall */
+    uint16_t used;              /*!< Entries in use */
+    uint16_t capacity;          /*!< CONFIG_LIGHT_SCENE_MAX */
+    uint16_t bytes_per_scene;   /*!< RAM per entry, and flash per saved entry */
+} light_scene_stats_t;
+
+/**
+* @brief Load the saved scene table; NVS must be initialized
+*/
+esp_err_t light_scene_init(void);
+
+/**
+* @brief Store Scene: the current state of a segment becomes the scene. Zigbee task only.
+*/
+esp_err_t light_scene_store(uint8_t segment, uint16_t group_id, uint8_t scene_id, const light_store_state_t *state);
+
+/**
+* @brief Take over what the stack holds for a scene, e.g. from Add Scene. Zigbee task only.
+*
+* On/Off, Level Control and Color Control fields are used, others are
+* ignored. The table changes only if the scene does.
+*/
+esp_err_t light_scene_describe(uint8_t segment, uint16_t group_id, uint8_t scene_id, const esp_zb_zcl_scenes_extension_field_t *fields);
+
+/**
+* @brief Recall Scene: apply a scene to the state of a segment. Zigbee task only.
+*
+* @param  transition_time  the scene's, as the stack passes it with the recall, tenths of a second
+* @param  state            updated with what the scene sets
+* @param  transition_ms    the fade to use
+* @return ESP_ERR_NOT_FOUND if the table has no such scene
+*/
+esp_err_t light_scene_recall(uint8_t segment, uint16_t group_id, uint8_t scene_id, uint16_t transition_time, light_store_state_t *state,
+                             uint32_t *transition_ms);
+
+/**
+* @brief The frame of the recalled scenes was queued, ends the recall latency measurement
+*/
+void light_scene_committed(void);
+
+void light_scene_get_stats(light_scene_stats_t *stats);
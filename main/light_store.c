@@ -0,0 +1,198 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "light_store.h"
+#include "sdkconfig.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "nvs.h"
+
+#define LIGHT_STORE_NAMESPACE   "light"
+#define LIGHT_STORE_VERSION     1
+#define LIGHT_STORE_SEGMENTS    CONFIG_LIGHT_DRIVER_SEGMENTS
+
+_Static_assert(sizeof(light_store_state_t) == 14, "light_store_state_t must not have padding");
+
+static const char *TAG = "LIGHT_STORE";
+
+/* what is stored: the state prefixed with a version */
+typedef struct {
+    uint8_t version;
+    uint8_t reserved;
+    light_store_state_t state;
+} light_store_blob_t;
+
+static nvs_handle_t s_handle;
+static bool s_open = false;
+static light_store_state_t s_saved[LIGHT_STORE_SEGMENTS];
+static light_store_state_t s_pending[LIGHT_STORE_SEGMENTS];
+static bool s_dirty = false;
+static bool s_alarm_scheduled = false;
+/* one debounce window for all segments, a scene on a whole strip is one write round */
+static uint32_t s_first_change_ms;
+static uint32_t s_last_change_ms;
+static light_store_stats_t s_stats;
+
+static void light_store_alarm(uint8_t param);
+
+static uint32_t light_store_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* "state" for the first segment, as before segments existed, "state<n>" for the others */
+static void light_store_key(uint8_t segment, char key[8])
+{
+    snprintf(key, 8, segment ? "state%u" : "state", segment);
+}
+
+static void light_store_write(void)
+{
+    s_dirty = false;
+    if (!s_open)
+    {
+        return;
+    }
+    bool written[LIGHT_STORE_SEGMENTS] = { false };
+    bool any = false;
+    esp_err_t err = ESP_OK;
+    for (uint8_t i = 0; i < LIGHT_STORE_SEGMENTS && err == ESP_OK; i++)
+    {
+        /* unchanged, or changed and changed back in the meantime */
+        if (!memcmp(&s_pending[i], &s_saved[i], sizeof(s_saved[i])))
+        {
+            continue;
+        }
+        light_store_blob_t blob = {
+            .version = LIGHT_STORE_VERSION,
+            .state = s_pending[i],
+        };
+        char key[8];
+        light_store_key(i, key);
+        err = nvs_set_blob(s_handle, key, &blob, sizeof(blob));
+        written[i] = err == ESP_OK;
+        any |= written[i];
+    }
+    if (err == ESP_OK && any)
+    {
+        err = nvs_commit(s_handle);
+    }
+    if (err != ESP_OK)
+    {
+        /* nothing counts as saved, try again after another debounce window */
+        ESP_LOGW(TAG, "Failed to save light state (%s)", esp_err_to_name(err));
+        s_dirty = true;
+        if (!s_alarm_scheduled)
+        {
+            s_alarm_scheduled = true;
+            esp_zb_scheduler_alarm(light_store_alarm, 0, CONFIG_LIGHT_STORE_DEBOUNCE_MS);
+        }
+        return;
+    }
+    for (uint8_t i = 0; i < LIGHT_STORE_SEGMENTS; i++)
+    {
+        if (written[i])
+        {
+            s_saved[i] = s_pending[i];
+            s_stats.writes++;
+        }
+    }
+}
+
+static void light_store_alarm(uint8_t param)
+{
+    uint32_t now_ms = light_store_now_ms();
+    uint32_t quiet_ms = now_ms - s_last_change_ms;
+    uint32_t age_ms = now_ms - s_first_change_ms;
+    if (quiet_ms < CONFIG_LIGHT_STORE_DEBOUNCE_MS && age_ms < CONFIG_LIGHT_STORE_MAX_DELAY_MS)
+    {
+        /* still changing, e.g. a dimmer drag: wait until it settles, or the deadline */
+        uint32_t wait_ms = CONFIG_LIGHT_STORE_DEBOUNCE_MS - quiet_ms;
+        if (wait_ms > CONFIG_LIGHT_STORE_MAX_DELAY_MS - age_ms)
+        {
+            wait_ms = CONFIG_LIGHT_STORE_MAX_DELAY_MS - age_ms;
+        }
+        esp_zb_scheduler_alarm(light_store_alarm, 0, wait_ms);
+        return;
+    }
+    s_alarm_scheduled = false;
+    if (s_dirty)
+    {
+        light_store_write();
+    }
+}
+
+void light_store_update(uint8_t segment, const light_store_state_t *state)
+{
+    if (segment >= LIGHT_STORE_SEGMENTS || !memcmp(state, &s_pending[segment], sizeof(s_pending[segment])))
+    {
+        return;
+    }
+    uint32_t now_ms = light_store_now_ms();
+    s_pending[segment] = *state;
+    s_stats.updates++;
+    if (!s_dirty)
+    {
+        s_dirty = true;
+        s_first_change_ms = now_ms;
+    }
+    s_last_change_ms = now_ms;
+    if (!s_alarm_scheduled)
+    {
+        s_alarm_scheduled = true;
+        esp_zb_scheduler_alarm(light_store_alarm, 0, CONFIG_LIGHT_STORE_DEBOUNCE_MS);
+    }
+}
+
+void light_store_get_stats(light_store_stats_t *stats)
+{
+    *stats = s_stats;
+    stats->avoided = s_stats.updates - s_stats.writes;
+}
+
+esp_err_t light_store_init(uint8_t segment, light_store_state_t *state)
+{
+    ESP_RETURN_ON_FALSE(segment < LIGHT_STORE_SEGMENTS, ESP_ERR_INVALID_ARG, TAG, "No segment %d", segment);
+    if (!s_open)
+    {
+        ESP_RETURN_ON_ERROR(nvs_open(LIGHT_STORE_NAMESPACE, NVS_READWRITE, &s_handle), TAG, "Failed to open NVS namespace");
+        s_open = true;
+    }
+    light_store_blob_t blob;
+    size_t size = sizeof(blob);
+    char key[8];
+    light_store_key(segment, key);
+    esp_err_t err = nvs_get_blob(s_handle, key, &blob, &size);
+    if (err == ESP_OK && (size != sizeof(blob) || blob.version != LIGHT_STORE_VERSION))
+    {
+        ESP_LOGW(TAG, "Ignoring saved light state %s (version %d, %d bytes)", key, blob.version, (int)size);
+        err = ESP_ERR_NOT_FOUND;
+    }
+    else if (err == ESP_ERR_NVS_NOT_FOUND)
+    {
+        err = ESP_ERR_NOT_FOUND;
+    }
+    if (err == ESP_OK)
+    {
+        *state = blob.state;
+    }
+    /* what is in flash now, later updates compare against it */
+    s_saved[segment] = err == ESP_OK ? blob.state : *state;
+    s_pending[segment] = s_saved[segment];
+    return err;
+}
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/* Light state of every segment, persisted in NVS. Updates are coalesced: the state is written
+ * once it has been quiet for CONFIG_LIGHT_STORE_DEBOUNCE_MS, or at the
+ * latest CONFIG_LIGHT_STORE_MAX_DELAY_MS after the first unsaved change, and
+ * only if it differs from what is already in flash. */
+
+/** Persisted light state; no padding, it is compared and stored as a blob */
+typedef struct {
+    uint16_t color_x;
+    uint16_t color_y;
+    uint16_t mireds;
+    uint8_t power;
+    uint8_t level;
+    uint8_t color_mode;         /*!< ZCL ColorMode the color was last set in */
+    uint8_t hue;
+    uint8_t sat;
+    uint8_t startup_on_off;     /*!< ZCL StartUpOnOff */
+    uint8_t startup_level;      /*!< ZCL StartUpCurrentLevel */
+    uint8_t reserved;           /*!< keep zero */
+} light_store_state_t;
+
+/** NVS write counters */
+typedef struct {
+    uint32_t updates;           /*!< Changed states handed to light_store_update() */
+    uint32_t writes;            /*!< Blobs written to flash */
+    uint32_t avoided;           /*!< Updates that did not cause a write of their own */
+} light_store_stats_t;
+
+/**
+* @brief Open the store and load the saved state of a segment
+*
+* @param  segment  segment index, below CONFIG_LIGHT_DRIVER_SEGMENTS
+* @param  state    filled with the saved state; left untouched if there is none
+* @return ESP_ERR_NOT_FOUND if nothing (valid) was saved yet
+*/
+esp_err_t light_store_init(uint8_t segment, light_store_state_t *state);
+
+/**
+* @brief Hand over the current state of a segment, written later if it changed. Zigbee task only.
+*/
+void light_store_update(uint8_t segment, const light_store_state_t *state);
+
+void light_store_get_stats(light_store_stats_t *stats);
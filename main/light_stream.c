@@ -0,0 +1,187 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "light_stream.h"
+#include "light_driver.h"
+#include "light_trace.h"
+#include "esp_check.h"
+
+/* only touched from the Zigbee task, no locking */
+static light_stream_stats_t s_stats;
+
+#if CONFIG_LIGHT_DRIVER_STREAM
+
+static const char *TAG = "LIGHT_STREAM";
+static uint8_t s_last_seq;
+static bool s_synced;       /* s_last_seq is valid */
+static bool s_have_base;    /* the buffer holds the frame delta chunks apply to */
+
+/* write data into the stream buffer from pixel first on
+ * @return false if the data is truncated, overruns the strip or has an unknown op */
+static bool light_stream_decode(uint8_t *frame, uint16_t led_count, uint16_t first, bool ops, const uint8_t *data, uint16_t size,
+                                uint32_t *pixels)
+{
+    if (first > led_count)
+    {
+        return false;
+    }
+    uint8_t *out = frame + first * 3;
+    size_t room = (size_t)(led_count - first) * 3;
+    if (!ops)
+    {
+        if (size % 3 || size > room)
+        {
+            return false;
+        }
+        memcpy(out, data, size);
+        *pixels += size / 3;
+        return true;
+    }
+    const uint8_t *end = data + size;
+    while (data < end)
+    {
+        uint8_t op = *data++;
+        size_t bytes = ((op & ~LIGHT_STREAM_OP_MASK) + 1) * 3;
+        if (bytes > room)
+        {
+            return false;
+        }
+        switch (op & LIGHT_STREAM_OP_MASK)
+        {
+        case LIGHT_STREAM_OP_LITERAL:
+            if (bytes > (size_t)(end - data))
+            {
+                return false;
+            }
+            memcpy(out, data, bytes);
+            data += bytes;
+            *pixels += bytes / 3;
+            break;
+        case LIGHT_STREAM_OP_REPEAT:
+            if (end - data < 3)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < bytes; i += 3)
+            {
+                memcpy(out + i, data, 3);
+            }
+            data += 3;
+            *pixels += bytes / 3;
+            break;
+        case LIGHT_STREAM_OP_SKIP:
+            break;
+        default:
+            return false;
+        }
+        out += bytes;
+        room -= bytes;
+    }
+    return true;
+}
+
+static esp_err_t light_stream_drop(uint8_t seq, light_stream_drop_t reason, esp_err_t err)
+{
+    s_stats.dropped++;
+    if (reason != LIGHT_STREAM_DROP_STALE)
+    {
+        /* a reordered old chunk changes nothing, anything else leaves a hole */
+        s_have_base = false;
+    }
+    LIGHT_LOGW(STREAM_DROP, seq, reason);
+    return err;
+}
+
+esp_err_t light_stream_handle(const uint8_t *data, uint16_t size)
+{
+    if (!data || size < LIGHT_STREAM_HEADER_SIZE)
+    {
+        return light_stream_drop(0, LIGHT_STREAM_DROP_MALFORMED, ESP_ERR_INVALID_SIZE);
+    }
+    uint8_t seq = data[0];
+    uint8_t flags = data[1];
+    uint16_t first = data[2] | data[3] << 8;
+    bool delta = flags & LIGHT_STREAM_FLAG_DELTA;
+    bool restart = seq == 0 && !delta;
+    if (s_synced && !restart && (int8_t)(seq - s_last_seq) <= 0)
+    {
+        return light_stream_drop(seq, LIGHT_STREAM_DROP_STALE, ESP_ERR_INVALID_STATE);
+    }
+    if (delta && (!s_have_base || seq != (uint8_t)(s_last_seq + 1)))
+    {
+        return light_stream_drop(seq, LIGHT_STREAM_DROP_NO_BASE, ESP_ERR_INVALID_STATE);
+    }
+    uint16_t led_count;
+    uint8_t *frame = light_driver_stream_buffer(&led_count);
+    if (!frame)
+    {
+        return light_stream_drop(seq, LIGHT_STREAM_DROP_BUSY, ESP_ERR_NO_MEM);
+    }
+    uint32_t pixels = 0;
+    if (!light_stream_decode(frame, led_count, first, flags & LIGHT_STREAM_FLAG_OPS, data + LIGHT_STREAM_HEADER_SIZE,
+                             size - LIGHT_STREAM_HEADER_SIZE, &pixels))
+    {
+        return light_stream_drop(seq, LIGHT_STREAM_DROP_MALFORMED, ESP_ERR_INVALID_SIZE);
+    }
+    s_last_seq = seq;
+    s_synced = true;
+    s_have_base = true;
+    s_stats.chunks++;
+    s_stats.pixels += pixels;
+    s_stats.bytes += size;
+    if (flags & LIGHT_STREAM_FLAG_SHOW)
+    {
+        if (light_driver_stream_show() != ESP_OK)
+        {
+            return light_stream_drop(seq, LIGHT_STREAM_DROP_BUSY, ESP_ERR_NO_MEM);
+        }
+        s_stats.frames++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t light_stream_add_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+    /* the controller reads the strip length before it streams: what the driver
+     * was started with, which may be less than the Kconfig maximum */
+    uint16_t led_count;
+    light_driver_stream_buffer(&led_count);
+    esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(LIGHT_STREAM_CLUSTER_ID);
+    ESP_RETURN_ON_FALSE(attr_list, ESP_ERR_NO_MEM, TAG, "Failed to create stream cluster");
+    ESP_RETURN_ON_ERROR(esp_zb_custom_cluster_add_custom_attr(attr_list, LIGHT_STREAM_ATTR_LED_COUNT, ESP_ZB_ZCL_ATTR_TYPE_U16,
+                                                              ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &led_count),
+                        TAG, "Failed to add stream attribute");
+    return esp_zb_cluster_list_add_custom_cluster(cluster_list, attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+#else
+
+esp_err_t light_stream_handle(const uint8_t *data, uint16_t size)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t light_stream_add_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+    return ESP_OK;
+}
+
+#endif
+
+void light_stream_get_stats(light_stream_stats_t *stats)
+{
+    *stats = s_stats;
+}
@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+/* Pixel streaming: a manufacturer specific cluster on the light endpoint
+ * whose Chunk command carries pixels for the whole strip, decoded straight
+ * into the driver's stream buffer (light_driver_stream_buffer()). A frame
+ * is one or more chunks, the last one flagged SHOW. Streamed frames replace
+ * the segment colors until the next On/Off, Level or Color write.
+ *
+ * Chunk payload, little endian:
+ *
+ *     seq u8 | flags u8 | first u16 | data
+ *
+ * seq counts chunks, modulo 256. A chunk not newer than the last one
+ * accepted is stale and dropped; seq 0 without LIGHT_STREAM_FLAG_DELTA always
+ * restarts the count. data writes pixels from index first on, either raw
+ * (r, g, b per pixel) or, with LIGHT_STREAM_FLAG_OPS, as a sequence of ops:
+ *
+ *     0b00nnnnnn r g b ...   n + 1 literal pixels
+ *     0b01nnnnnn r g b       one pixel repeated n + 1 times
+ *     0b10nnnnnn             skip n + 1 pixels, they keep the previous frame
+ *
+ * A chunk that relies on the previous frame is flagged LIGHT_STREAM_FLAG_DELTA.
+ * After a lost or dropped chunk, delta chunks are dropped until a chunk
+ * without the flag arrives: the controller should send a full frame now and
+ * then. Pixels are shown as sent, without level or gamma. */
+
+#define LIGHT_STREAM_CLUSTER_ID           0xFC11    /* manufacturer specific cluster range */
+#define LIGHT_STREAM_CMD_CHUNK            0x00
+#define LIGHT_STREAM_HEADER_SIZE          4
+#define LIGHT_STREAM_ATTR_LED_COUNT       0x0000    /* U16, read only: pixels in the strip */
+
+#define LIGHT_STREAM_FLAG_OPS             0x01      /* data is ops, not raw pixels */
+#define LIGHT_STREAM_FLAG_DELTA           0x02      /* relies on the previous frame */
+#define LIGHT_STREAM_FLAG_SHOW            0x04      /* last chunk of the frame */
+
+#define LIGHT_STREAM_OP_LITERAL           0x00
+#define LIGHT_STREAM_OP_REPEAT            0x40
+#define LIGHT_STREAM_OP_SKIP              0x80
+#define LIGHT_STREAM_OP_MASK              0xc0
+#define LIGHT_STREAM_OP_COUNT_MAX         64
+
+/** Why a chunk was dropped, the argument of the STREAM_DROP trace event */
+typedef enum {
+    LIGHT_STREAM_DROP_STALE = 1,        /*!< seq not newer than the last accepted chunk */
+    LIGHT_STREAM_DROP_NO_BASE = 2,      /*!< delta chunk after a lost or dropped chunk */
+    LIGHT_STREAM_DROP_BUSY = 3,         /*!< last frame still being rendered, or render queue full */
+    LIGHT_STREAM_DROP_MALFORMED = 4,    /*!< truncated, out of range or unknown op */
+} light_stream_drop_t;
+
+/** Stream counters, see light_stream_get_stats() */
+typedef struct {
+    uint32_t chunks;        /*!< Chunks accepted */
+    uint32_t frames;        /*!< Frames shown */
+    uint32_t pixels;        /*!< Pixels written, skipped ones not counted */
+    uint32_t bytes;         /*!< Chunk payload bytes accepted, headers included */
+    uint32_t dropped;       /*!< Chunks dropped, for any light_stream_drop_t reason */
+} light_stream_stats_t;
+
+/**
+* @brief Add the stream cluster to the light endpoint, before esp_zb_device_register()
+*
+* Adds nothing without CONFIG_LIGHT_DRIVER_STREAM.
+*/
+esp_err_t light_stream_add_cluster(esp_zb_cluster_list_t *cluster_list);
+
+/**
+* @brief Handle a Chunk command, from the Zigbee task
+*
+* @param  data  command payload
+* @param  size  payload size
+* @return ESP_OK, or why the chunk was not shown: ESP_ERR_INVALID_STATE
+*         (stale, no base), ESP_ERR_NO_MEM (busy), ESP_ERR_INVALID_SIZE (malformed)
+*/
+esp_err_t light_stream_handle(const uint8_t *data, uint16_t size);
+
+void light_stream_get_stats(light_stream_stats_t *stats);
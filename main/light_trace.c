@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "light_trace.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#if CONFIG_LIGHT_TRACE
+
+_Static_assert(sizeof(light_trace_record_t) == 32, "trace records are dumped as 32 bytes");
+_Static_assert(LIGHT_TRACE_EVENT_COUNT <= UINT16_MAX, "event ids are 16-bit");
+
+#define TRACE_DEPTH CONFIG_LIGHT_TRACE_DEPTH
+_Static_assert((TRACE_DEPTH & (TRACE_DEPTH - 1)) == 0, "trace depth must be a power of two");
+
+/* records printed per lock, keeps the critical section short */
+#define TRACE_DUMP_CHUNK 8
+
+/* head and tail run freely and are masked on access */
+static light_trace_record_t s_ring[TRACE_DEPTH];
+static uint32_t s_head;
+static uint32_t s_tail;
+static uint32_t s_lost;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void light_trace_write(uint16_t event, char level, uint8_t nargs, const uint32_t *args)
+{
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    if (nargs > LIGHT_TRACE_MAX_ARGS)
+    {
+        nargs = LIGHT_TRACE_MAX_ARGS;
+    }
+    portENTER_CRITICAL(&s_lock);
+    if (s_head - s_tail == TRACE_DEPTH)
+    {
+        /* full, drop the oldest */
+        s_tail++;
+        s_lost++;
+    }
+    light_trace_record_t *record = &s_ring[s_head & (TRACE_DEPTH - 1)];
+    record->timestamp_us = now_us;
+    record->event = event;
+    record->level = level;
+    record->nargs = nargs;
+    for (uint8_t i = 0; i < nargs; i++)
+    {
+        record->args[i] = args[i];
+    }
+    s_head++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void light_trace_print(const light_trace_record_t *record)
+{
+    static const char hex[] = "0123456789abcdef";
+    const uint8_t *bytes = (const uint8_t *)record;
+    char line[3 + 2 * sizeof(*record) + 1] = "LT ";
+    for (size_t i = 0; i < sizeof(*record); i++)
+    {
+        line[3 + 2 * i] = hex[bytes[i] >> 4];
+        line[3 + 2 * i + 1] = hex[bytes[i] & 0xf];
+    }
+    line[sizeof(line) - 1] = '\0';
+    puts(line);
+}
+
+void light_trace_dump(void)
+{
+    light_trace_record_t chunk[TRACE_DUMP_CHUNK];
+    while (true)
+    {
+        uint32_t count = 0;
+        uint32_t lost;
+        portENTER_CRITICAL(&s_lock);
+        lost = s_lost;
+        s_lost = 0;
+        while (count < TRACE_DUMP_CHUNK && s_tail != s_head)
+        {
+            chunk[count++] = s_ring[s_tail++ & (TRACE_DEPTH - 1)];
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (lost)
+        {
+            light_trace_record_t marker = {
+                .timestamp_us = (uint32_t)esp_timer_get_time(),
+                .event = LIGHT_TRACE_LOST,
+                .level = 'W',
+                .nargs = 1,
+                .args = { lost },
+            };
+            light_trace_print(&marker);
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            light_trace_print(&chunk[i]);
+        }
+        if (count < TRACE_DUMP_CHUNK)
+        {
+            return;
+        }
+    }
+}
+
+#if CONFIG_LIGHT_TRACE_DRAIN_TASK
+static const char *TAG = "LIGHT_TRACE";
+static StackType_t s_drain_task_stack[CONFIG_LIGHT_TRACE_DRAIN_TASK_STACK_SIZE];
+static StaticTask_t s_drain_task;
+
+static void light_trace_drain_task(void *arg)
+{
+    while (true)
+    {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_LIGHT_TRACE_DRAIN_PERIOD_MS));
+        light_trace_dump();
+    }
+}
+#endif
+
+esp_err_t light_trace_start(void)
+{
+#if CONFIG_LIGHT_TRACE_DRAIN_TASK
+    TaskHandle_t task = xTaskCreateStatic(light_trace_drain_task, "light_trace", CONFIG_LIGHT_TRACE_DRAIN_TASK_STACK_SIZE, NULL,
+                                          tskIDLE_PRIORITY + 1, s_drain_task_stack, &s_drain_task);
+    ESP_RETURN_ON_FALSE(task, ESP_ERR_INVALID_STATE, TAG, "Failed to create trace drain task");
+#endif
+    return ESP_OK;
+}
+
+#else
+
+void light_trace_write(uint16_t event, char level, uint8_t nargs, const uint32_t *args)
+{
+}
+
+void light_trace_dump(void)
+{
+}
+
+esp_err_t light_trace_start(void)
+{
+    return ESP_OK;
+}
+
+#endif
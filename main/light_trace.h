@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "light_trace_events.h"
+
+/* Binary event trace for the hot path: a record is an event id plus its raw
+ * integer arguments, copied into a RAM ring without any formatting. Records
+ * are printed as hex lines ("LT <record>") by a low priority drain task or
+ * light_trace_dump(), and turned back into log lines on the host by
+ * main/tools/light_trace_decode.py. The ring overwrites the oldest records
+ * when full and reports how many were lost.
+ *
+ * LIGHT_LOGI(event, args...) / LIGHT_LOGW(event, args...) trace the event
+ * with CONFIG_LIGHT_TRACE, and fall back to ESP_LOGI/ESP_LOGW with the
+ * event's format string (and the caller's TAG) without it. */
+
+typedef enum {
+#define LIGHT_TRACE_ENUM(name) LIGHT_TRACE_##name,
+    LIGHT_TRACE_EVENTS(LIGHT_TRACE_ENUM)
+#undef LIGHT_TRACE_ENUM
+    LIGHT_TRACE_EVENT_COUNT,
+} light_trace_event_t;
+
+#define LIGHT_TRACE_MAX_ARGS 6
+
+/** One trace record, 32 bytes, dumped as is (little endian) */
+typedef struct {
+    uint32_t timestamp_us;  /*!< esp_timer time, wraps after 71 minutes */
+    uint16_t event;         /*!< light_trace_event_t */
+    char level;             /*!< 'E', 'W', 'I' or 'D' */
+    uint8_t nargs;
+    uint32_t args[LIGHT_TRACE_MAX_ARGS];
+} light_trace_record_t;
+
+#define LIGHT_TRACE_NARGS(...) (sizeof((uint32_t[]){0, ##__VA_ARGS__}) / sizeof(uint32_t) - 1)
+#define LIGHT_TRACE_ARGS(...) ((const uint32_t[]){0, ##__VA_ARGS__} + 1)
+
+#if CONFIG_LIGHT_TRACE
+#define LIGHT_TRACE_LOG(level, event, ...) \
+    light_trace_write(LIGHT_TRACE_##event, #level[0], LIGHT_TRACE_NARGS(__VA_ARGS__), LIGHT_TRACE_ARGS(__VA_ARGS__))
+#else
+#define LIGHT_TRACE_LOG(level, event, ...) ESP_LOG##level(TAG, LIGHT_TRACE_FMT_##event, ##__VA_ARGS__)
+#endif
+
+#define LIGHT_LOGI(event, ...) LIGHT_TRACE_LOG(I, event, ##__VA_ARGS__)
+#define LIGHT_LOGW(event, ...) LIGHT_TRACE_LOG(W, event, ##__VA_ARGS__)
+
+/**
+* @brief Append a record to the trace ring, never blocks or formats
+*
+* @param  event  light_trace_event_t
+* @param  level  log level letter
+* @param  nargs  number of arguments, extra ones beyond LIGHT_TRACE_MAX_ARGS are dropped
+* @param  args   arguments
+*/
+void light_trace_write(uint16_t event, char level, uint8_t nargs, const uint32_t *args);
+
+/**
+* @brief Print and consume the records in the ring, one "LT <hex>" line each
+*/
+void light_trace_dump(void);
+
+/**
+* @brief Start the drain task, if CONFIG_LIGHT_TRACE_DRAIN_TASK is enabled
+*/
+esp_err_t light_trace_start(void);
@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_color_dimmable_light Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+/* Trace events. The position in LIGHT_TRACE_EVENTS is the event id stored in
+ * the trace records, so only append. Each event has a format string
+ * LIGHT_TRACE_FMT_<name>: printf conversions of integers only, at most
+ * LIGHT_TRACE_MAX_ARGS of them. main/tools/light_trace_decode.py reads this
+ * file to turn records back into log lines. */
+#define LIGHT_TRACE_EVENTS(X)   \
+    X(LOST)                     \
+    X(ATTR_RX)                  \
+    X(ATTR_ON_OFF)              \
+    X(ATTR_COLOR_X)             \
+    X(ATTR_COLOR_Y)             \
+    X(ATTR_COLOR_TEMPERATURE)   \
+    X(ATTR_HUE)                 \
+    X(ATTR_ENHANCED_HUE)        \
+    X(ATTR_SATURATION)          \
+    X(ATTR_LEVEL)               \
+    X(ATTR_UNKNOWN_ON_OFF)      \
+    X(ATTR_UNKNOWN_COLOR)       \
+    X(ATTR_UNKNOWN_LEVEL)       \
+    X(ATTR_OTHER_CLUSTER)       \
+    X(NWK_JOINED)               \
+    X(ATTR_START_UP_ON_OFF)     \
+    X(ATTR_START_UP_LEVEL)      \
+    X(STREAM_DROP)              \
+    X(IDENTIFY)                 \
+    X(EFFECT)                   \
+    X(ATTR_COLOR_LOOP)          \
+    X(OTA_START)                \
+    X(OTA_VERIFIED)             \
+    X(OTA_ABORT)                \
+    X(OTA_FAIL)
+
+#define LIGHT_TRACE_FMT_LOST                    "%u trace records lost"
+#define LIGHT_TRACE_FMT_ATTR_RX                 "Received message: endpoint(%d), cluster(0x%x), attribute(0x%x), data size(%d)"
+#define LIGHT_TRACE_FMT_ATTR_ON_OFF             "Light sets to %d (1 = On)"
+#define LIGHT_TRACE_FMT_ATTR_COLOR_X            "Light color x changes to 0x%x"
+#define LIGHT_TRACE_FMT_ATTR_COLOR_Y            "Light color y changes to 0x%x"
+#define LIGHT_TRACE_FMT_ATTR_COLOR_TEMPERATURE  "Light color temperature changes to %d mireds"
+#define LIGHT_TRACE_FMT_ATTR_HUE                "Light color hue changes to %d"
+#define LIGHT_TRACE_FMT_ATTR_ENHANCED_HUE       "Light color enhanced hue changes to %d"
+#define LIGHT_TRACE_FMT_ATTR_SATURATION         "Light color saturation changes to %d"
+#define LIGHT_TRACE_FMT_ATTR_LEVEL              "Light level changes to %d"
+#define LIGHT_TRACE_FMT_ATTR_UNKNOWN_ON_OFF     "On/Off cluster data: attribute(0x%x), type(0x%x)"
+#define LIGHT_TRACE_FMT_ATTR_UNKNOWN_COLOR      "Color control cluster data: attribute(0x%x), type(0x%x)"
+#define LIGHT_TRACE_FMT_ATTR_UNKNOWN_LEVEL      "Level Control cluster data: attribute(0x%x), type(0x%x)"
+#define LIGHT_TRACE_FMT_ATTR_OTHER_CLUSTER      "Message data: cluster(0x%x), attribute(0x%x)"
+#define LIGHT_TRACE_FMT_NWK_JOINED              "Joined network successfully (Extended PAN ID: %08x%08x, PAN ID: 0x%04x, Channel:%d, Short Address: 0x%04x)"
+#define LIGHT_TRACE_FMT_ATTR_START_UP_ON_OFF    "Light start up on/off changes to 0x%x"
+#define LIGHT_TRACE_FMT_ATTR_START_UP_LEVEL     "Light start up level changes to 0x%x"
+#define LIGHT_TRACE_FMT_STREAM_DROP             "Stream chunk %d dropped, reason %d"
+#define LIGHT_TRACE_FMT_IDENTIFY                "Identify on segment %d changes to %d"
+#define LIGHT_TRACE_FMT_EFFECT                  "Trigger effect 0x%x (variant 0x%x) on segment %d"
+#define LIGHT_TRACE_FMT_ATTR_COLOR_LOOP         "Light color loop changes to %d (direction %d, %d s per turn)"
+#define LIGHT_TRACE_FMT_OTA_START               "OTA download of file 0x%x (%u bytes) from offset %u"
+#define LIGHT_TRACE_FMT_OTA_VERIFIED            "OTA file 0x%x verified, %u bytes in %u ms (%u B/s)"
+#define LIGHT_TRACE_FMT_OTA_ABORT               "OTA download interrupted at %u of %u bytes, resumes from %u"
+#define LIGHT_TRACE_FMT_OTA_FAIL                "OTA download failed at %u of %u bytes (step %d, error 0x%x)"
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+#
+# Check the static memory footprint of the app against a budget.
+#
+# Reads the section headers of the app ELF and sums:
+#
+#  - RAM: allocated sections that live in RAM, i.e. writable data (.data,
+#    .bss, .noinit and the DRAM/RTC variants) and code placed in IRAM
+#  - flash: allocated sections with contents, i.e. everything the image
+#    carries, including the initial values of .data and the IRAM code
+#
+# and fails if either exceeds its budget. The root CMakeLists.txt runs it
+# after every link with the LIGHT_MEMORY_*_BUDGET_KB Kconfig options:
+#
+#     python3 main/tools/check_memory_budget.py --ram-budget-kb 320 \
+#         --flash-budget-kb 1600 build/color_light_bulb.elf
+#
+# A budget of 0 is not checked. Heap and task stacks allocated at runtime
+# are not included, see light_memory_report() for those.
+
+import argparse
+import struct
+import sys
+
+SHT_NOBITS = 8
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+# prefixes of code and read-only sections that run from RAM, and of sections
+# that stay in flash even if the linker script marks them writable
+RAM_CODE_PREFIXES = ('.iram', '.rtc.text', '.rtc.force_fast')
+FLASH_PREFIXES = ('.flash',)
+
+
+def read_sections(path):
+    """(name, type, flags, size) of every section of an ELF32 or ELF64 file"""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF':
+        raise ValueError('%s: not an ELF file' % path)
+    is64 = data[4] == 2
+    endian = '<' if data[5] == 1 else '>'
+    if is64:
+        shoff, = struct.unpack_from(endian + 'Q', data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', data, 0x3a)
+        header = struct.Struct(endian + 'IIQQQQIIQQ')
+    else:
+        shoff, = struct.unpack_from(endian + 'I', data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', data, 0x2e)
+        header = struct.Struct(endian + 'IIIIIIIIII')
+    headers = [header.unpack_from(data, shoff + i * shentsize) for i in range(shnum)]
+    strtab = headers[shstrndx][4]
+
+    def name(offset):
+        end = data.index(b'\0', strtab + offset)
+        return data[strtab + offset:end].decode()
+
+    # name, type, flags, addr, offset, size, ...
+    return [(name(h[0]), h[1], h[2], h[5]) for h in headers]
+
+
+def classify(sections):
+    """(name, size, in_ram, in_flash) of the allocated sections"""
+    result = []
+    for name, sh_type, flags, size in sections:
+        if not flags & SHF_ALLOC or not size:
+            continue
+        in_flash = sh_type != SHT_NOBITS
+        in_ram = not name.startswith(FLASH_PREFIXES) and (bool(flags & SHF_WRITE) or name.startswith(RAM_CODE_PREFIXES))
+        result.append((name, size, in_ram, in_flash))
+    return result
+
+
+def check(label, used, budget_kb):
+    if not budget_kb:
+        print('%-6s %8d bytes, no budget' % (label, used))
+        return True
+    budget = budget_kb * 1024
+    ok = used <= budget
+    print('%-6s %8d bytes of %d (%d%%)%s' % (label, used, budget, used * 100 // budget, '' if ok else ', OVER BUDGET'))
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Check the static RAM and flash footprint of an ELF against a budget')
+    parser.add_argument('elf', help='linked app')
+    parser.add_argument('--ram-budget-kb', type=int, default=0, help='static RAM budget, 0 for none')
+    parser.add_argument('--flash-budget-kb', type=int, default=0, help='flash budget, 0 for none')
+    parser.add_argument('-v', '--verbose', action='store_true', help='list the sections')
+    args = parser.parse_args()
+
+    sections = classify(read_sections(args.elf))
+    if args.verbose:
+        for name, size, in_ram, in_flash in sections:
+            print('  %-32s %8d %s%s' % (name, size, 'R' if in_ram else '-', 'F' if in_flash else '-'))
+    ram = sum(size for _, size, in_ram, _ in sections if in_ram)
+    flash = sum(size for _, size, _, in_flash in sections if in_flash)
+    ok = check('RAM', ram, args.ram_budget_kb)
+    ok = check('flash', flash, args.flash_budget_kb) and ok
+    if not ok:
+        print('%s: static memory over budget, see LIGHT_MEMORY_*_BUDGET_KB in menuconfig' % args.elf, file=sys.stderr)
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+#
+# Decode the binary light trace (see main/light_trace.h) back into log lines.
+#
+# Reads console output, e.g. from `idf.py monitor` or a saved log, replaces
+# every "LT <hex>" line with the log line it stands for and passes all other
+# lines through unchanged:
+#
+#     idf.py monitor | python3 main/tools/light_trace_decode.py
+#     python3 main/tools/light_trace_decode.py console.log
+#
+# With --binary the input is a raw dump of 32-byte records instead.
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+RECORD = struct.Struct('<IHcB6I')
+MAX_ARGS = 6
+LINE_RE = re.compile(r'LT ([0-9a-f]{%d})\s*$' % (2 * RECORD.size))
+CONVERSION_RE = re.compile(r'%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXc%])')
+
+
+def load_events(header):
+    """Event names in id order and their format strings, from light_trace_events.h"""
+    with open(header) as f:
+        text = f.read()
+    table = re.search(r'#define\s+LIGHT_TRACE_EVENTS\(X\)(.*?)\n\s*\n', text, re.S)
+    if not table:
+        raise ValueError('%s: LIGHT_TRACE_EVENTS not found' % header)
+    names = re.findall(r'X\((\w+)\)', table.group(1))
+    formats = dict(re.findall(r'#define\s+LIGHT_TRACE_FMT_(\w+)\s+"((?:[^"\\]|\\.)*)"', text))
+    missing = [name for name in names if name not in formats]
+    if missing:
+        raise ValueError('%s: no format for %s' % (header, ', '.join(missing)))
+    return [(name, formats[name]) for name in names]
+
+
+def format_args(fmt, args):
+    """printf with 32-bit integer arguments, C length modifiers dropped"""
+    values = iter(args)
+
+    def convert(match):
+        flags, _, conv = match.groups()
+        if conv == '%':
+            return '%'
+        value = next(values, 0)
+        if conv in 'di':
+            value = value - (1 << 32) if value & 0x80000000 else value
+        elif conv == 'c':
+            value = chr(value & 0xff)
+        return ('%' + flags + ('d' if conv == 'u' else conv)) % value
+
+    return CONVERSION_RE.sub(convert, fmt)
+
+
+def decode(record, events):
+    timestamp_us, event, level, nargs, *args = RECORD.unpack(record)
+    level = level.decode('ascii', 'replace')
+    if event >= len(events):
+        return '%s (%d) TRACE: unknown event %d %s' % (level, timestamp_us // 1000, event, args[:nargs])
+    name, fmt = events[event]
+    return '%s (%d) %s: %s' % (level, timestamp_us // 1000, name, format_args(fmt, args[:min(nargs, MAX_ARGS)]))
+
+
+def main():
+    default_header = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'light_trace_events.h')
+    parser = argparse.ArgumentParser(description='Decode the binary light trace into log lines')
+    parser.add_argument('input', nargs='?', help='console log or binary dump (default: stdin)')
+    parser.add_argument('--binary', action='store_true', help='input is raw 32-byte records')
+    parser.add_argument('--events', default=default_header, help='path to light_trace_events.h')
+    args = parser.parse_args()
+
+    events = load_events(args.events)
+    if args.binary:
+        data = open(args.input, 'rb').read() if args.input else sys.stdin.buffer.read()
+        for offset in range(0, len(data) - RECORD.size + 1, RECORD.size):
+            print(decode(data[offset:offset + RECORD.size], events))
+        return
+    source = open(args.input, errors='replace') if args.input else sys.stdin
+    for line in source:
+        match = LINE_RE.search(line)
+        if match:
+            line = line[:match.start()] + decode(bytes.fromhex(match.group(1)), events) + '\n'
+        sys.stdout.write(line)
+        sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
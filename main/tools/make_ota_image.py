@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+#
+# Wrap an app binary into a Zigbee OTA upgrade file for the light's OTA
+# client (see main/light_ota.h): the upgrade file header, the app as the
+# upgrade image sub-element and its SHA-256 as a manufacturer specific one.
+#
+#     python3 main/tools/make_ota_image.py build/color_light_bulb.bin \
+#         --file-version 0x00000002 -o 131B-0001-00000002-light.zigbee
+#
+# Manufacturer code, image type and file version must match the
+# CONFIG_LIGHT_OTA_* values; the light only downloads a file version above
+# the one it was built with.
+
+import argparse
+import hashlib
+import struct
+import sys
+
+FILE_MAGIC = 0x0BEEF11E
+HEADER_VERSION = 0x0100
+STACK_VERSION = 0x0002  # Zigbee PRO
+HEADER = struct.Struct('<IHHHHHIH32sI')
+TAG = struct.Struct('<HI')
+TAG_UPGRADE_IMAGE = 0x0000
+TAG_SHA256 = 0xf000  # LIGHT_OTA_TAG_SHA256
+APP_IMAGE_MAGIC = 0xe9
+
+
+def make_ota_image(app, manufacturer_code, image_type, file_version, header_string):
+    elements = TAG.pack(TAG_UPGRADE_IMAGE, len(app)) + app
+    elements += TAG.pack(TAG_SHA256, 32) + hashlib.sha256(app).digest()
+    header = HEADER.pack(FILE_MAGIC, HEADER_VERSION, HEADER.size, 0, manufacturer_code, image_type, file_version,
+                         STACK_VERSION, header_string.encode()[:32], HEADER.size + len(elements))
+    return header + elements
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Wrap an app binary into a Zigbee OTA upgrade file')
+    parser.add_argument('app', help='app binary, e.g. build/color_light_bulb.bin')
+    parser.add_argument('-o', '--output', required=True, help='upgrade file to write')
+    parser.add_argument('--manufacturer-code', type=lambda s: int(s, 0), default=0x131B)
+    parser.add_argument('--image-type', type=lambda s: int(s, 0), default=0x0001)
+    parser.add_argument('--file-version', type=lambda s: int(s, 0), required=True)
+    parser.add_argument('--header-string', default='esp32-huello-world light')
+    args = parser.parse_args()
+
+    app = open(args.app, 'rb').read()
+    if not app or app[0] != APP_IMAGE_MAGIC:
+        sys.exit('%s is not an app image' % args.app)
+    with open(args.output, 'wb') as f:
+        f.write(make_ota_image(app, args.manufacturer_code, args.image_type, args.file_version, args.header_string))
+
+
+if __name__ == '__main__':
+    main()